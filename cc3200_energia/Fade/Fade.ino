@@ -17,7 +17,7 @@ char websocket_path[] = "/ws";
 
 boolean draw_en = false;
 WiFiClient client;
-WebsocketClient webSocketClient(websocket_server, websocket_port, websocket_path, false, wscMessage);
+WebsocketClient webSocketClient(websocket_server, websocket_port, websocket_path, false, wscConnect, wscMessage);
 
 char responseMessage[] = "{\"cmd\": \"subscribe\", \"channel\": \"CC3200\"}";
 
@@ -25,8 +25,11 @@ void wscConnect() {
   webSocketClient.sendMessage(responseMessage, sizeof(responseMessage));
 }
 
-void wscMessage(char* msg)
+void wscMessage(char* msg, uint16_t length, uint8_t opcode)
 {
+  if (opcode != WS_OPCODE_TEXT) {
+    return;
+  }
   Serial.print("Got msg : ");
   Serial.println(msg);
   
@@ -93,6 +96,14 @@ void setup() {
   // Connect to WPA/WPA2 network. Change this line if using open or WEP network:
   WiFi.begin(wifi_ssid, wifi_password);
   wifi_connect();
+
+  // Seed from the MAC address so that devices do not retry in lock-step
+  // or send the same Sec-WebSocket-Key and masks after boot
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  uint32_t seed = ((uint32_t) mac[2] << 24) | ((uint32_t) mac[3] << 16) | ((uint32_t) mac[4] << 8) | mac[5];
+  randomSeed(seed);  // Sec-WebSocket-Key nonces and frame masks
+  webSocketClient.setReconnect(500, 60000, seed);
   webSocketClient.connect();
 }
 
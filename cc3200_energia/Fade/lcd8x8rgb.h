@@ -6,6 +6,7 @@
   * color - drawing color
   * drawPixel(x,y) draws drawPixel at X,Y coordinates (1,1) is upper left corner
   * drawLine(x1,y1,x2,y2) draws line
+  * drawSpan(x1,y1,x2,y2) draws horizontal or vertical line
   * drawRectangle(x1,y1,x2,y2) draws rectangle
   * drawSolidRectangle(x1,y1,x2,y2) draws solid rectangle
   * drawElipse(x,y,rx,ry) draws elipse
@@ -18,61 +19,107 @@
   * scrollCharLeft(c) - scrolls one character from the bottom right matrix to the left
   * scrollCharRight(c) - scrolls one character from the upper left matrix to the right
   *scrollString( c, dir) - scrolls string left or right
+  * scrollStringByChar(c, dir) - scrolls string left or right one character at a time
+  * transferGap - microseconds between SPI bytes, 0 sends the frame as one block
+  * partialTransfer - true to resend only part of the chain when the rest is unchanged
+  * ticker - pre-rendered text for scrollString(), see text_ticker.h for other fonts, colors and spacing.
+  *    Text over TEXT_TICKER_COLUMNS / 6 characters, 85 by default, scrolls one character at a time.
   *
 */
+#ifndef bigX
 #define bigX 3                  // Number of MOD-LED8x8RGB in columns
+#endif
+#ifndef bigY
 #define bigY 2                  // Number of MOD-LED8x8RGB in rows
+#endif
 #define NumberX bigX*bigY       // Total number of MOD-LED8x8RGBs connected together
 
+#include "matrix_fb.h"
+#include "text_ticker.h"
+
 unsigned char color = 1;        // Starting color of LEDs
 unsigned char sdelay = 100;
+unsigned int transferGap = 10;  // Microseconds between SPI bytes, as in the Olimex library
+boolean partialTransfer = false;  // Send only the changed panels at the start of the chain, see chainShift()
 const char chipSelectPin = 18;
 
-unsigned char videobuf[NumberX*24];   //video buffer
+MatrixFramebuffer<bigX, bigY> framebuf;   //one byte per pixel, see matrix_fb.h
+unsigned char videobuf[NumberX*24];       //framebuf packed for the wire by Transfer()
+unsigned char chainbuf[NumberX*24];       //the bytes last shifted into the chain
+boolean chainValid = false;               //chainbuf matches the panels, clear to resend everything
+
+TextTicker ticker(FontLookup, false);     //scrollString() text, fixed width like drawChar()
 
 unsigned char cX = 1;
 unsigned char cY = 1;
 
 //----------------------------------------------------------------------------------------------
 void vClear() {          			//clear the video buffer
-   for(int i=0; i<NumberX*24; i++)
-      videobuf[i]=0;
+   framebuf.clear();
 }
 
 //----------------------------------------------------------------------------------------------
-void Transfer () {      			//transfer the video buffer to MOD-LED8x8RGB
+void spiWrite(const unsigned char *data, int length) {   //send a block of bytes under one chip select
    digitalWrite(chipSelectPin, LOW);
-   for(int i = 0; i < NumberX*24; i++){
-      SPI.transfer(videobuf[i]);
-      delayMicroseconds(10);
+   if (transferGap) {
+      for(int i = 0; i < length; i++){
+         SPI.transfer(data[i]);
+         delayMicroseconds(transferGap);
+      }
+   } else {
+      for(int i = 0; i < length; i++)
+         SPI.transfer(data[i]);
    }
    digitalWrite(chipSelectPin, HIGH);
 }
 
-//----------------------------------------------------------------------------------------------	
-void drawPixel (unsigned int X, unsigned int Y) {    //draw drawPixel at x,y coordinates to MOD-LED8x8RGB 1,1 is upper left corner
-   if (Y<=bigY*8 && X<=bigX*8 && X>0 && Y>0) {
-      if (Y>8) X=(X+bigX*8)*((Y-1)/8);
-      Y=Y%8;
-      if (Y==0) Y=8;
-      
+//----------------------------------------------------------------------------------------------
+int chainShift() {      			//number of panels to shift in to turn chainbuf into videobuf
+   // The chain is a shift register: the last 24 bytes sent go to the first panel and
+   // the panels already in the chain move towards the end.  Sending only the first s
+   // panels is enough when the rest of the chain already holds what videobuf wants.
+   if (!chainValid) return NumberX;
+   for (int s = 0; s < NumberX; s++) {
       int p;
-      p=NumberX-((X-1)/8)-1;
+      for (p = NumberX-1; p >= s; p--)       //compare from the first panel, where changes usually are
+         if (memcmp(chainbuf+24*p, videobuf+24*(p-s), 24)) break;
+      if (p < s) return s;
+   }
+   return NumberX;
+}
+
+//----------------------------------------------------------------------------------------------
+void Transfer () {      			//transfer the video buffer to MOD-LED8x8RGB
+   if (chainValid && !framebuf.dirty()) return;   //nothing drawn since the last transfer
+   framebuf.pack(videobuf);
+   int s = partialTransfer ? chainShift() : NumberX;
+   if (s == 0) return;                        //no changed panels
+   spiWrite(videobuf+24*(NumberX-s), 24*s);
+   memcpy(chainbuf, videobuf, sizeof(videobuf));
+   chainValid = true;
+}
 
-      videobuf[3*(Y-1)+24*p]&=~(1<<((X-1)%8));                  //turn off chosen drawPixel
-      videobuf[3*(Y-1)+1+24*p]&=~(1<<((X-1)%8));
-      videobuf[3*(Y-1)+2+24*p]&=~(1<<((X-1)%8));
+//----------------------------------------------------------------------------------------------	
+void drawPixel (unsigned int X, unsigned int Y) {    //draw drawPixel at x,y coordinates to MOD-LED8x8RGB 1,1 is upper left corner
+   framebuf.setPixel(X-1, Y-1, color);
+}
 
-      if (color&1) videobuf[3*(Y-1)+24*p]|=(1<<((X-1)%8));      //set color to the drawPixel
-      if (color&2) videobuf[3*(Y-1)+1+24*p]|=(1<<((X-1)%8));
-      if (color&4) videobuf[3*(Y-1)+2+24*p]|=(1<<((X-1)%8));
-   }
+//----------------------------------------------------------------------------------------------
+void drawSpan (int x1, int y1, int x2, int y2) {      //draw a horizontal or vertical run from x1,y1 to x2,y2
+   if (x1 == x2 && y1 == y2) framebuf.setPixel(x1-1, y1-1, color);
+      else if (y1 == y2) framebuf.fillRow(x1-1, x2-1, y1-1, color);
+      else framebuf.fillColumn(x1-1, y1-1, y2-1, color);
 }
 
 //----------------------------------------------------------------------------------------------
 void drawLine (int x1, int y1, int x2, int y2) {      //draw a line from x1,y1 to x2,y2
    int dx, dy, sx, sy, err, e2;
 
+   if (x1 == x2 || y1 == y2) {        //horizontal and vertical lines are a single run
+      drawSpan (x1, y1, x2, y2);
+      return;
+   }
+
    dx = abs (x2-x1);
    dy = abs (y2-y1);
    if (x1<x2) sx = 1;
@@ -108,11 +155,7 @@ void drawRectangle (int x1, int y1, int x2, int y2) {  //draw a rectangle from x
 
 //----------------------------------------------------------------------------------------------
 void drawSolidRectangle (int x1, int y1, int x2, int y2) {  //draw a solid rectangle
-   if (x2>x1)
-      for (int i=x1; i<=x2;i++)
-         drawLine (i, y1, i, y2);
-   else for (int i=x2; i<=x1;i++)
-         drawLine (i, y1, i, y2);
+   framebuf.fillRect(x1-1, y1-1, x2-1, y2-1, color);
    return;
 }
 
@@ -130,6 +173,10 @@ void drawEllipse (int CX, int CY, int XRadius, int YRadius) {   //draw an ellips
    int X, Y, XChange, YChange, EllipseError, TwoASquare, TwoBSquare, StoppingX, StoppingY;
    if (XRadius<0) XRadius=-XRadius;
    if (YRadius<0) YRadius=-YRadius;
+   if (XRadius==0 && YRadius==0) {         //a single point, the first loop below would never end
+      drawPixel (CX, CY);
+      return;
+   }
 
    TwoASquare = 2 * XRadius*XRadius;
    TwoBSquare = 2 * YRadius*YRadius;
@@ -214,18 +261,12 @@ void drawString( unsigned char c[]) {  //draw static string
 
 //----------------------------------------------------------------------------------------------
 void lScroll() {   //scroll everything left
-   for (int i=NumberX*24-1;i>=0;i--) {
-      videobuf[i]=videobuf[i]>>1;
-      if (i>=24) videobuf[i]|=((videobuf[i-24]&1)<<7);
-   }
+   framebuf.scrollLeft();
 }
 
 //----------------------------------------------------------------------------------------------
 void rScroll() {   //scroll everything right
-   for (int i=0;i<NumberX*24;i++) {
-      videobuf[i]=videobuf[i]<<1;
-      if (i<(NumberX-1)*24) videobuf[i]|=(videobuf[i+24]>>7);
-   }
+   framebuf.scrollRight();
 }
 
 //----------------------------------------------------------------------------------------------
@@ -248,7 +289,8 @@ void scrollCharLeft(unsigned char c) {   //scroll one character left if within t
 
 //----------------------------------------------------------------------------------------------
 void scrollCharRight(unsigned char c) {  //scroll one character right if within the Font limit
-   unsigned char b,i,k;
+   unsigned char b,i;
+   signed char k;
    if (c<32 || c>125) c=32;
 
    rScroll();
@@ -275,7 +317,7 @@ void theEnder(boolean directions) {  //move everything left/right until it leave
 }
 
 //----------------------------------------------------------------------------------------------
-void scrollString(unsigned char c[], boolean directions) { //draw a scrolling string
+void scrollStringByChar(unsigned char c[], boolean directions) { //draw a scrolling string one character at a time
    
       int len;
       for(len=0;c[len];len++);
@@ -293,3 +335,36 @@ void scrollString(unsigned char c[], boolean directions) { //draw a scrolling st
       }
       theEnder(directions);
 }
+
+//----------------------------------------------------------------------------------------------
+void scrollString(unsigned char c[], boolean directions) { //draw a scrolling string
+      // Render the text once, then each step scrolls the strip and draws the incoming
+      // column.  Text longer than the ticker scrolls one character at a time instead.
+      unsigned char firstColor = color;
+      ticker.clear();
+      for(int i=0;c[i];i++) {
+         if (ticker.append(c[i], color) < 0) {
+            color = firstColor;
+            scrollStringByChar(c, directions);
+            return;
+         }
+         color++; if (color>7) color = 1;
+      }
+
+      int len = ticker.length();
+      if (directions) {
+         ticker.draw(framebuf, len);
+         for(int p=len-1; p>=-NumberX*8; p--) {
+            ticker.step(framebuf, p, true);
+            Transfer();
+            delay(sdelay);
+         }
+      } else {
+         ticker.draw(framebuf, -NumberX*8);
+         for(int p=1-NumberX*8; p<=len; p++) {
+            ticker.step(framebuf, p, false);
+            Transfer();
+            delay(sdelay);
+         }
+      }
+}
@@ -0,0 +1,374 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Linear framebuffer for chained Olimex MOD-LED8x8RGB panels.
+ *
+ * Each panel receives 24 bytes over SPI: for each of the 8 rows, one
+ * byte per color plane (red, green, blue) with bit c set for column c.
+ * The first panel in the chain receives the last 24 bytes sent.
+ * Drawing directly into that bit-planar wire format requires a divide,
+ * a modulo and three read-modify-writes per pixel.
+ *
+ * This framebuffer instead stores one byte per pixel holding the 3-bit
+ * color (bit 0 red, bit 1 green, bit 2 blue).  The panels form one long
+ * strip in chain order, bigX panels of the top panel row followed by the
+ * next panel row and so on, and the strip is stored row by row.  A pixel
+ * is a single store at a precomputed row offset plus x, scrolling along
+ * the chain is one memmove per row, and pack() converts the frame to the
+ * wire format once per transfer.
+ *
+ * Each panel has a dirty flag which is set when one of its pixels changes
+ * value.  pack() only converts the dirty panels, and drawing the same
+ * frame again, or clearing a blank frame, leaves every panel clean.
+ *
+ * @param PANELS_X The number of panels in each panel row.
+ * @param PANELS_Y The number of panel rows.
+ */
+
+#ifndef MATRIX_FB_H
+#define MATRIX_FB_H
+
+#include <stdint.h>
+#include <string.h>
+
+template <int PANELS_X, int PANELS_Y>
+class MatrixFramebuffer {
+public:
+    enum {
+        PANELS = PANELS_X * PANELS_Y,
+        WIDTH = PANELS_X * 8,        // display width in pixels
+        HEIGHT = PANELS_Y * 8,       // display height in pixels
+        STRIDE = PANELS * 8,         // strip row length in pixels
+        WIRE_SIZE = PANELS * 24      // packed size in bytes
+    };
+
+    /** Construct a new, cleared instance with every panel dirty. */
+    MatrixFramebuffer() {
+        for (int y = 0; y < HEIGHT; ++y) {
+            rowOffset_[y] = (y & 7) * STRIDE + (y >> 3) * WIDTH;
+            rowPanel_[y] = (y >> 3) * PANELS_X;
+        }
+        memset(pixels_, 0, sizeof(pixels_));
+        blank_ = true;
+        markDirty();
+    }
+
+    /** Set every pixel to black. */
+    void clear() {
+        if (!blank_) {
+            memset(pixels_, 0, sizeof(pixels_));
+            blank_ = true;
+            markDirty();
+        }
+    }
+
+    /** Set a pixel.
+     *
+     * @param x The column from 0 (left) to WIDTH - 1.
+     * @param y The row from 0 (top) to HEIGHT - 1.
+     * @param color The 3-bit color.  Pixels outside the display are
+     *      ignored.
+     */
+    void setPixel(int x, int y, uint8_t color) {
+        if (((unsigned) x < WIDTH) && ((unsigned) y < HEIGHT)) {
+            uint8_t * p = pixels_ + rowOffset_[y] + x;
+            color &= 7;
+            if (*p != color) {
+                *p = color;
+                blank_ = false;
+                markDirty(rowPanel_[y] + (x >> 3));
+            }
+        }
+    }
+
+    /** Set a horizontal run of pixels.
+     *
+     * Each panel's part of the run is a single memset, which is skipped
+     * along with the dirty flag when those pixels already have the color.
+     *
+     * @param x0 The first column, in either order with x1.
+     * @param x1 The last column.
+     * @param y The row.
+     * @param color The 3-bit color.  Pixels outside the display are
+     *      ignored.
+     */
+    void fillRow(int x0, int x1, int y, uint8_t color) {
+        if (x0 > x1) {
+            int t = x0;
+            x0 = x1;
+            x1 = t;
+        }
+        if (((unsigned) y >= HEIGHT) || (x1 < 0) || (x0 >= WIDTH)) {
+            return;
+        }
+        if (x0 < 0) {
+            x0 = 0;
+        }
+        if (x1 >= WIDTH) {
+            x1 = WIDTH - 1;
+        }
+        color &= 7;
+        uint8_t * row = pixels_ + rowOffset_[y];
+        while (x0 <= x1) {
+            int end = x0 | 7;  // the last column of this panel
+            if (end > x1) {
+                end = x1;
+            }
+            if (fill(row + x0, end - x0 + 1, color)) {
+                blank_ = false;
+                markDirty(rowPanel_[y] + (x0 >> 3));
+            }
+            x0 = end + 1;
+        }
+    }
+
+    /** Set a vertical run of pixels.
+     *
+     * @param x The column.
+     * @param y0 The first row, in either order with y1.
+     * @param y1 The last row.
+     * @param color The 3-bit color.  Pixels outside the display are
+     *      ignored.
+     */
+    void fillColumn(int x, int y0, int y1, uint8_t color) {
+        if (y0 > y1) {
+            int t = y0;
+            y0 = y1;
+            y1 = t;
+        }
+        if (((unsigned) x >= WIDTH) || (y1 < 0) || (y0 >= HEIGHT)) {
+            return;
+        }
+        if (y0 < 0) {
+            y0 = 0;
+        }
+        if (y1 >= HEIGHT) {
+            y1 = HEIGHT - 1;
+        }
+        color &= 7;
+        for (int y = y0; y <= y1; ++y) {
+            uint8_t * p = pixels_ + rowOffset_[y] + x;
+            if (*p != color) {
+                *p = color;
+                blank_ = false;
+                markDirty(rowPanel_[y] + (x >> 3));
+            }
+        }
+    }
+
+    /** Set a filled rectangle of pixels.
+     *
+     * @param x0 The first column, in either order with x1.
+     * @param y0 The first row, in either order with y1.
+     * @param x1 The last column.
+     * @param y1 The last row.
+     * @param color The 3-bit color.  Pixels outside the display are
+     *      ignored.
+     */
+    void fillRect(int x0, int y0, int x1, int y1, uint8_t color) {
+        if (y0 > y1) {
+            int t = y0;
+            y0 = y1;
+            y1 = t;
+        }
+        if (y0 < 0) {
+            y0 = 0;
+        }
+        if (y1 >= HEIGHT) {
+            y1 = HEIGHT - 1;
+        }
+        for (int y = y0; y <= y1; ++y) {
+            fillRow(x0, x1, y, color);
+        }
+    }
+
+    /** Get a pixel.
+     *
+     * @param x The column from 0 (left) to WIDTH - 1.
+     * @param y The row from 0 (top) to HEIGHT - 1.
+     * @return The 3-bit color or 0 outside the display.
+     */
+    uint8_t getPixel(int x, int y) const {
+        if (((unsigned) x < WIDTH) && ((unsigned) y < HEIGHT)) {
+            return pixels_[rowOffset_[y] + x];
+        }
+        return 0;
+    }
+
+    /** Copy 8 rows of pixels to a window along the chain.
+     *
+     * The strip has PANELS * 8 columns: column c is column c & 7 of
+     * panel c >> 3, where panel 0 is the top left panel and the panels
+     * continue along each panel row and then to the next.  Only the
+     * panels whose pixels change are stored and marked dirty.
+     *
+     * @param column The first strip column, which may be negative.
+     * @param pixels The first of count 3-bit pixels for row 0, or NULL to
+     *      draw black.
+     * @param stride The distance between rows in pixels.
+     * @param count The number of columns.  Columns outside the strip are
+     *      ignored.
+     */
+    void drawRows(int column, const uint8_t * pixels, int stride, int count) {
+        static const uint8_t black[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        if (column < 0) {
+            if (pixels) {
+                pixels -= column;
+            }
+            count += column;
+            column = 0;
+        }
+        if (count > STRIDE - column) {
+            count = STRIDE - column;
+        }
+        for (int r = 0; r < 8; ++r) {
+            uint8_t * dst = pixels_ + r * STRIDE;
+            const uint8_t * src = pixels ? (pixels + r * stride) : 0;
+            for (int c0 = column; c0 < column + count; ) {
+                int c1 = (c0 | 7) + 1;  // the first column of the next panel
+                if (c1 > column + count) {
+                    c1 = column + count;
+                }
+                const uint8_t * s = src ? (src + c0 - column) : black;
+                if (copy(dst + c0, s, c1 - c0)) {
+                    blank_ = false;
+                    markDirty(c0 >> 3);
+                }
+                c0 = c1;
+            }
+        }
+    }
+
+    /** Scroll every pixel one column toward the start of the chain.
+     *
+     * The first column of each panel row continues at the last column of
+     * the panel row above, and the last column of the bottom panel row
+     * becomes black.
+     */
+    void scrollLeft() {
+        if (blank_) {
+            return;
+        }
+        for (int r = 0; r < 8; ++r) {
+            uint8_t * p = pixels_ + r * STRIDE;
+            memmove(p, p + 1, STRIDE - 1);
+            p[STRIDE - 1] = 0;
+        }
+        markDirty();
+    }
+
+    /** Scroll every pixel one column toward the end of the chain. */
+    void scrollRight() {
+        if (blank_) {
+            return;
+        }
+        for (int r = 0; r < 8; ++r) {
+            uint8_t * p = pixels_ + r * STRIDE;
+            memmove(p + 1, p, STRIDE - 1);
+            p[0] = 0;
+        }
+        markDirty();
+    }
+
+    /** Mark every panel dirty. */
+    void markDirty() {
+        memset(dirty_, 0xff, sizeof(dirty_));
+    }
+
+    /** Mark one panel dirty.
+     *
+     * @param panel The panel in chain order from 0 (top left).
+     */
+    void markDirty(int panel) {
+        dirty_[panel >> 5] |= 1UL << (panel & 31);
+    }
+
+    /** Check for changes since the last pack().
+     *
+     * @return True if any panel is dirty.
+     */
+    bool dirty() const {
+        for (unsigned i = 0; i < sizeof(dirty_) / sizeof(dirty_[0]); ++i) {
+            if (dirty_[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Pack the dirty panels into the wire format and mark them clean.
+     *
+     * @param wire The output buffer of WIRE_SIZE bytes, which must hold
+     *      the previous pack() output for the clean panels.
+     */
+    void pack(uint8_t * wire) {
+        for (int panel = 0; panel < PANELS; ++panel) {
+            if (!(dirty_[panel >> 5] & (1UL << (panel & 31)))) {
+                continue;
+            }
+            uint8_t * out = wire + (PANELS - 1 - panel) * 24;
+            for (int r = 0; r < 8; ++r) {
+                packRow(pixels_ + r * STRIDE + panel * 8, out + r * 3);
+            }
+        }
+        memset(dirty_, 0, sizeof(dirty_));
+    }
+
+    /** Pack one panel row of 8 pixels into its 3 color plane bytes.
+     *
+     * @param pixels The 8 pixels, left to right.
+     * @param out The red, green and blue wire bytes.
+     */
+    static void packRow(const uint8_t * pixels, uint8_t * out) {
+        // Gather bit k of each byte into one byte with a multiply
+        uint64_t v = (uint64_t) pixels[0] | ((uint64_t) pixels[1] << 8) |
+                ((uint64_t) pixels[2] << 16) | ((uint64_t) pixels[3] << 24) |
+                ((uint64_t) pixels[4] << 32) | ((uint64_t) pixels[5] << 40) |
+                ((uint64_t) pixels[6] << 48) | ((uint64_t) pixels[7] << 56);
+        const uint64_t lsb = 0x0101010101010101ULL;
+        const uint64_t gather = 0x0102040810204080ULL;
+        out[0] = (uint8_t) (((v & lsb) * gather) >> 56);
+        out[1] = (uint8_t) ((((v >> 1) & lsb) * gather) >> 56);
+        out[2] = (uint8_t) ((((v >> 2) & lsb) * gather) >> 56);
+    }
+
+private:
+    static bool copy(uint8_t * dst, const uint8_t * src, int length) {
+        if (length == 8) {
+            // A whole panel row compares as one word
+            uint64_t a;
+            uint64_t b;
+            memcpy(&a, dst, 8);
+            memcpy(&b, src, 8);
+            if (a == b) {
+                return false;
+            }
+            memcpy(dst, &b, 8);
+            return true;
+        }
+        if (memcmp(dst, src, length)) {
+            memcpy(dst, src, length);
+            return true;
+        }
+        return false;
+    }
+
+    static bool fill(uint8_t * p, int length, uint8_t color) {
+        for (int i = 0; i < length; ++i) {
+            if (p[i] != color) {
+                memset(p + i, color, length - i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint8_t pixels_[8 * STRIDE];
+    uint16_t rowOffset_[HEIGHT];
+    uint16_t rowPanel_[HEIGHT];         // the first panel of each row
+    uint32_t dirty_[(PANELS + 31) / 32];
+    bool blank_;                        // true if every pixel is black
+};
+
+#endif /* MATRIX_FB_H */
@@ -0,0 +1,66 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "text_ticker.h"
+#include <string.h>
+
+TextTicker::TextTicker(const unsigned char (*font)[5], bool proportional,
+                       int gap, unsigned char first, unsigned char last)
+        : font_(font), proportional_(proportional), gap_(gap), first_(first),
+          last_(last), length_(0) {
+}
+
+void TextTicker::clear() {
+    length_ = 0;
+}
+
+int TextTicker::append(char c, uint8_t color) {
+    unsigned char ch = (unsigned char) c;
+    if ((ch < first_) || (ch > last_)) {
+        ch = first_;
+    }
+    const unsigned char * glyph = font_[ch - first_];
+    int start = 0;
+    int end = 5;
+    if (proportional_) {
+        while ((start < end) && !glyph[start]) {
+            ++start;
+        }
+        while ((end > start) && !glyph[end - 1]) {
+            --end;
+        }
+    }
+    int width = end - start;
+    int blank = width ? gap_ : TEXT_TICKER_SPACE;
+    if (length_ + width + blank > TEXT_TICKER_COLUMNS) {
+        return -1;
+    }
+    color &= 7;
+    for (int r = 0; r < 8; ++r) {
+        uint8_t * p = rows_[r] + length_;
+        for (int i = 0; i < width; ++i) {
+            p[i] = ((glyph[start + i] >> r) & 1) ? color : 0;
+        }
+        memset(p + width, 0, blank);
+    }
+    length_ += width + blank;
+    return length_;
+}
+
+int TextTicker::append(const char * text, uint8_t color) {
+    for (; *text; ++text) {
+        if (append(*text, color) < 0) {
+            return -1;
+        }
+    }
+    return length_;
+}
+
+int TextTicker::length() const {
+    return length_;
+}
+
+const uint8_t * TextTicker::row(int r) const {
+    return rows_[r];
+}
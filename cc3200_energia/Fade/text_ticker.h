@@ -0,0 +1,175 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Pre-rasterized scrolling text for the MOD-LED8x8RGB matrix.
+ *
+ * Plotting text glyph column by glyph column and scrolling the whole
+ * framebuffer for each step costs a font lookup and 8 pixels per column
+ * drawn plus a full scroll per step.  TextTicker instead rasterizes the
+ * text once into 8 rows of 3-bit pixels, the same layout as a
+ * MatrixFramebuffer strip row.  Each scroll step then copies only the
+ * visible window into the framebuffer with draw(), which is one memcpy
+ * per row and panel, so moving the text is just a change of position.
+ * When the text fills the whole strip, step() moves it by one column with
+ * a framebuffer scroll and draws only the incoming column, which is
+ * faster than redrawing every column.  Each appended string has its own
+ * color.
+ *
+ * Glyphs come from a 5-column font such as FontLookup in font.h, with
+ * bit r of each column for row r.  With proportional spacing, the empty
+ * columns on both sides of each glyph are removed and a blank glyph, such
+ * as space, is TEXT_TICKER_SPACE columns wide.  Otherwise every glyph is
+ * 5 columns wide like drawChar().
+ *
+ * Example:
+ * @code
+ * TextTicker ticker(FontLookup);
+ * ticker.append("Hello ", 1);
+ * ticker.append("world", 4);
+ * ticker.draw(framebuf, -framebuf.STRIDE);
+ * for (int p = 1 - framebuf.STRIDE; p <= ticker.length(); ++p) {
+ *     ticker.step(framebuf, p, false);
+ *     Transfer();
+ * }
+ * @endcode
+ */
+
+#ifndef TEXT_TICKER_H
+#define TEXT_TICKER_H
+
+#include <stdint.h>
+
+/** The maximum text length in columns. */
+#ifndef TEXT_TICKER_COLUMNS
+#define TEXT_TICKER_COLUMNS 512
+#endif
+
+/** The width of a blank glyph with proportional spacing. */
+#define TEXT_TICKER_SPACE 3
+
+class TextTicker {
+public:
+    /** Construct a new, empty instance.
+     *
+     * @param font The 5-column glyphs, starting with character first.
+     * @param proportional True to trim the empty columns of each glyph,
+     *      false for a fixed 5-column width.
+     * @param gap The number of blank columns after each glyph.
+     * @param first The character of font[0].
+     * @param last The last character in font.  Characters outside first
+     *      to last are drawn as first.
+     */
+    TextTicker(const unsigned char (*font)[5], bool proportional = true,
+               int gap = 1, unsigned char first = 32, unsigned char last = 125);
+
+    /** Remove all text. */
+    void clear();
+
+    /** Append a character.
+     *
+     * @param c The character.
+     * @param color The 3-bit color of the character.
+     * @return The new length in columns or -1 if the character does not
+     *      fit, in which case the text is unchanged.
+     */
+    int append(char c, uint8_t color);
+
+    /** Append a string.
+     *
+     * @param text The null-terminated string.
+     * @param color The 3-bit color of the string.
+     * @return The new length in columns or -1 if the string was truncated
+     *      after the last character which fits.
+     */
+    int append(const char * text, uint8_t color);
+
+    /** Get the text length.
+     *
+     * @return The number of columns, including the gap after the last
+     *      character.
+     */
+    int length() const;
+
+    /** Get a rendered row.
+     *
+     * @param r The row from 0 (top) to 7.
+     * @return The length() 3-bit pixels of the row.
+     */
+    const uint8_t * row(int r) const;
+
+    /** Draw the visible window of the text.
+     *
+     * Only the columns in the window are written.  Columns before the
+     * start or after the end of the text are drawn black.
+     *
+     * @param fb The MatrixFramebuffer.
+     * @param position The text column shown at the first strip column,
+     *      from -width (text just off the end) to length() (text just off
+     *      the start).
+     * @param column The first strip column of the window.
+     * @param width The number of strip columns in the window, or -1 for
+     *      the rest of the strip.
+     */
+    template <typename Framebuffer>
+    void draw(Framebuffer & fb, int position, int column = 0,
+              int width = -1) const {
+        if (width < 0) {
+            width = Framebuffer::STRIDE - column;
+        }
+        int lead = 0;  // blank columns before the text
+        if (position < 0) {
+            lead = (-position < width) ? -position : width;
+            fb.drawRows(column, 0, 0, lead);
+        }
+        int start = position + lead;
+        int count = width - lead;
+        if (count > length_ - start) {
+            count = (length_ > start) ? (length_ - start) : 0;
+        }
+        if (count > 0) {
+            fb.drawRows(column + lead, rows_[0] + start, TEXT_TICKER_COLUMNS,
+                        count);
+            lead += count;
+        }
+        fb.drawRows(column + lead, 0, 0, width - lead);
+    }
+
+    /** Move the text on the whole strip by one column.
+     *
+     * The framebuffer scrolls by one column and only the incoming text
+     * column is drawn.  The strip must already show the text at the
+     * previous position, such as from draw() with the default window or
+     * from the last step().
+     *
+     * @param fb The MatrixFramebuffer.
+     * @param position The new text column shown at the first strip
+     *      column, which is one more than the previous position when
+     *      scrolling left, or one less when scrolling right.
+     * @param right True to scroll toward the end of the chain, false to
+     *      scroll toward the start.
+     */
+    template <typename Framebuffer>
+    void step(Framebuffer & fb, int position, bool right) const {
+        int column = right ? 0 : (Framebuffer::STRIDE - 1);
+        if (right) {
+            fb.scrollRight();
+        } else {
+            fb.scrollLeft();
+        }
+        int c = position + column;  // the incoming text column
+        fb.drawRows(column, ((c >= 0) && (c < length_)) ? (rows_[0] + c) : 0,
+                    TEXT_TICKER_COLUMNS, 1);
+    }
+
+private:
+    const unsigned char (*font_)[5];
+    bool proportional_;
+    int gap_;
+    unsigned char first_;
+    unsigned char last_;
+    int length_;
+    uint8_t rows_[8][TEXT_TICKER_COLUMNS];
+};
+
+#endif /* TEXT_TICKER_H */
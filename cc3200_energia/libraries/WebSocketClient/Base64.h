@@ -76,5 +76,99 @@ int base64_enc_len(int inputLen);
  */
 int base64_dec_len(char *input, int inputLen);
 
+/* base64_encoder_s:
+ * 		Description:
+ * 			Streaming encoder state.  Up to 2 input bytes that do not
+ * 			complete a 3 byte group are carried to the next call.
+ */
+struct base64_encoder_s {
+	unsigned char carry[3];
+	int carryLen;
+};
+
+/* base64_decoder_s:
+ * 		Description:
+ * 			Streaming decoder state.  Up to 3 characters that do not
+ * 			complete a 4 character group are carried to the next call.
+ */
+struct base64_decoder_s {
+	unsigned char carry[4];
+	int carryLen;
+	int done;
+};
+
+/* base64_encode_init:
+ * 		Description:
+ * 			Start a new streaming encode
+ * 		Parameters:
+ * 			enc: the encoder state
+ */
+void base64_encode_init(struct base64_encoder_s *enc);
+
+/* base64_encode_update:
+ * 		Description:
+ * 			Encode the next chunk of a stream.  The output is not
+ * 			null terminated.
+ * 		Parameters:
+ * 			enc: the encoder state
+ * 			output: the output buffer, which must hold
+ * 					base64_enc_len(inputLen + 2) characters
+ * 			input: the next chunk of binary to be encoded
+ * 			inputLen: the length of the chunk, in bytes
+ * 		Return value:
+ * 			Returns the number of characters written to output
+ */
+int base64_encode_update(struct base64_encoder_s *enc, char *output,
+		const char *input, int inputLen);
+
+/* base64_encode_final:
+ * 		Description:
+ * 			Encode the carried bytes with padding and null terminate
+ * 		Parameters:
+ * 			enc: the encoder state
+ * 			output: the output buffer, which must hold 5 characters
+ * 		Return value:
+ * 			Returns the number of characters written to output,
+ * 			excluding the terminator
+ */
+int base64_encode_final(struct base64_encoder_s *enc, char *output);
+
+/* base64_decode_init:
+ * 		Description:
+ * 			Start a new streaming decode
+ * 		Parameters:
+ * 			dec: the decoder state
+ */
+void base64_decode_init(struct base64_decoder_s *dec);
+
+/* base64_decode_update:
+ * 		Description:
+ * 			Decode the next chunk of a stream.  Like base64_decode,
+ * 			decoding stops at the first '=' and the rest of the stream
+ * 			is ignored.  The output is not null terminated.
+ * 		Parameters:
+ * 			dec: the decoder state
+ * 			output: the output buffer, which must hold
+ * 					(inputLen + 3) / 4 * 3 bytes
+ * 			input: the next chunk of the base64 string
+ * 			inputLen: the length of the chunk, in bytes
+ * 		Return value:
+ * 			Returns the number of bytes written to output
+ */
+int base64_decode_update(struct base64_decoder_s *dec, char *output,
+		const char *input, int inputLen);
+
+/* base64_decode_final:
+ * 		Description:
+ * 			Decode the carried characters and null terminate
+ * 		Parameters:
+ * 			dec: the decoder state
+ * 			output: the output buffer, which must hold 3 bytes
+ * 		Return value:
+ * 			Returns the number of bytes written to output,
+ * 			excluding the terminator
+ */
+int base64_decode_final(struct base64_decoder_s *dec, char *output);
+
 #endif // _BASE64_H
 
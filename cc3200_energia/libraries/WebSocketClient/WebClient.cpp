@@ -3,7 +3,11 @@
   https://github.com/MORA99/Stokerbot/tree/master/Libraries/WebSocketClient
   Released into the public domain - http://unlicense.org
   
-  Note: This package includes Base64 and sha1 implementation that I did not write.
+  Note: Energia builds a library only from its own directory, so this package
+  includes copies of the shared WebSocket code in the common directory of
+  mcu_proto.  Edit the files in common, then run "make -C test energia_copies"
+  to update the copies.  "make -C test" checks that the copies match.
+  The copies include Base64 and sha1 implementations that I did not write.
   Base64 : https://github.com/adamvr/arduino-base64
   Sha1 : Part of https://code.google.com/p/cryptosuite/
   
@@ -12,75 +16,25 @@
 */
 
 #include "WebClient.h"
-#include "Base64.h"
-#include "sha1.h"
-
-const uint8_t CONNECTION_TIMER_DEFAULT = 100;
+#include "ws_mask.h"
+#include <string.h>
 
 
 WebsocketClient::WebsocketClient(char* host, uint16_t port, char* path, boolean ssl, 
-        onConnect fconnect, onMessage fmessage);)
+        onConnect fconnect, onMessage fmessage)
+    : _parser(WEBSOCKET_MAX_MESSAGE_SIZE),
+      _frameLength(0),
+      _reassembler(_message, WEBSOCKET_MAX_MESSAGE_SIZE)
 {
   _fconnect = fconnect;
   _host = host;
   _port = port;
   _path = path;
   _connected = false;
-  _connectionTimer = CONNECTION_TIMER_DEFAULT;
-  _fnc = fnc;
+  _fnc = fmessage;
   _ssl = ssl;
 }
 
-void printHash(uint8_t* hash) {
-    int i;
-    for (i=0; i<20; i++) {
-        Serial.print("0123456789abcdef"[hash[i] >> 4]);
-        Serial.print("0123456789abcdef"[hash[i] & 0x0f]);
-    }
-    Serial.println();
-}
-
-void WebsocketClient::generate_key() {
-    char key[16];
-    for (uint8_t i=0; i<16; i++) {
-        key[i] = random(0, 255); // Must be randomized for each connection
-    }
-    base64_encode(_key, key, 16); 
-    Serial.print("Generated key ");
-    Serial.println(_key);
-}
-
-boolean WebsocketClient::validate_accept_key(char * acceptKey) {
-    /*
-    The client sends a Sec-WebSocket-Key which is a random value that has been base64 encoded. 
-    To form a response, the GUID 258EAFA5-E914-47DA-95CA-C5AB0DC85B11 is appended to this base64 encoded key. 
-    The base64 encoded key will not be decoded first.
-    The resulting string is then hashed with SHA-1, then base64 encoded. 
-    Finally, the resulting reply occurs in the header Sec-WebSocket-Accept.
-    */
-
-    Sha1.init();
-    Sha1.print(_key);
-    Sha1.print("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
-    char res[30];
-    char* ptr = (char*)Sha1.result();
-    base64_encode(res, ptr, 20);
-
-    if (strcmp(res, acceptKey) == 0) {
-        Serial.println("Handshake matches");
-        return true;
-    } else {
-        Serial.print("Bad handshake : ");
-        Serial.print(acceptKey);
-        Serial.print(" != ");
-        Serial.print(res);
-        Serial.print(" ( ");
-        Serial.print(strcmp(res, acceptKey));
-        Serial.println(" ) ");
-    }
-    return false;
-}
-
 boolean WebsocketClient::client_connect() {
     Serial.print("Connecting to ");
     Serial.print(_host);
@@ -94,225 +48,230 @@ boolean WebsocketClient::client_connect() {
   }
 }
 
-void WebsocketClient::client_send_header() {
-    client.print("GET ");
-    client.print(_path);
-    client.print(" HTTP/1.1\r\n");
-    client.print("Upgrade: websocket\r\n");
-    client.print("Connection: Upgrade\r\n");
-    client.print("Host: ");
-    client.print(_host);
-    client.println(); 
-    client.print("Sec-WebSocket-Key: ");
-    client.print(_key);
-    client.println();
-    client.print("Sec-WebSocket-Protocol: chat");
-    client.println();
-    client.print("Sec-WebSocket-Version: 13\r\n");
-    client.println();
-}
+boolean WebsocketClient::client_send_header() {
+    uint8_t nonce[16];
+    for (uint8_t i=0; i<16; i++) {
+        nonce[i] = random(0, 256); // Must be randomized for each connection, call randomSeed() first
+    }
+    _handshake.start(nonce);
+    Serial.print("Generated key ");
+    Serial.println(_handshake.key());
 
-boolean WebsocketClient::client_read_line(char * line, uint16_t length) {
-    boolean lineEndFound = false;
-    uint8_t i = 0;
+    //Send the request with a single write rather than one per fragment
+    int len = _handshake.request((char*) _tx, sizeof(_tx), _host, 0, _path, "chat");
+    if (len < 0) {
+        Serial.println("Request too long");
+        return false;
+    }
+    return client.write(_tx, len) == (size_t) len;
+}
 
-    while (1) {
-        if (i == length - 1) {
-            Serial.print("Header line too long ? : ");
-            line[i] = NULL;
-            Serial.println(line);
-            return false;
-        }
-        uint16_t timeout = 5000; // 5 seconds 
+boolean WebsocketClient::client_read(uint8_t * data, uint16_t length) {
+    uint16_t timeout = 5000; // 5 seconds
+    for (uint16_t i = 0; i < length; ++i) {
         while (!client.available()) {
             delay(1);
             timeout--;
             if (timeout == 0) {
-                Serial.println("Connection failed");
+                Serial.println("Read timeout");
                 return false;
             }
         }
-        char c = client.read();
-        if (c == '\r' ) { // end of line
-            line[i++] = 0;
-            client.read(); // discard \n
-            Serial.println(line);
-            return true;
-        }
-        line[i++] = c;
+        data[i] = client.read();
     }
-}    
+    return true;
+}
 
 boolean WebsocketClient::client_validate_response() {
-    //Find Sec-Websocket-Accept and validate it
-    //Then find \r\n\r\n that ends the HTTP header
-    boolean handshake = false;
-    char line[100];
-  
-    while (1) {
-        if (!client_read_line(line, sizeof(line))) {
+    //Read one byte at a time so that the frames that follow the
+    //response remain in the client for run()
+    while (_handshake.status() == WsHandshake::STATUS_PENDING) {
+        uint8_t c;
+        if (!client_read(&c, 1)) {
+            Serial.println("Connection failed");
             return false;
         }
-        if (line[0] == 0) { // blank line is end of header
-            break;
-        }
-        char* acceptKey = strstr(line, "Sec-Websocket-Accept");
-        if (acceptKey) {
-            acceptKey = strstr(line, ":");
-            acceptKey += 2;
-            handshake = validate_accept_key(acceptKey);
-        }
+        _handshake.parse(&c, 1);
     }
-    return handshake;
+    if (_handshake.status() != WsHandshake::STATUS_DONE) {
+        Serial.print("Bad handshake : ");
+        Serial.println(_handshake.error());
+        return false;
+    }
+    Serial.println("Handshake matches");
+    return true;
 }
 
 boolean WebsocketClient::connect() {
-    generate_key();
     _connected = false;
+    _parser.reset();
+    _frameLength = 0;
+    _reassembler.reset();
     if (!client_connect()) {
         return false;
     }
-    client_send_header();
-    if (!client_validate_response()) {
+    if (!client_send_header() || !client_validate_response()) {
         client.stop();
         return false;
     }
     _connected = true;
+    _reconnect.reset();
     if (_fconnect) {
         _fconnect();
     }
     return true;
 }
 
+void WebsocketClient::setReconnect(uint32_t baseMs, uint32_t maxMs, uint32_t seed)
+{
+    _reconnect = ReconnectScheduler(baseMs, maxMs, seed);
+}
+
 void WebsocketClient::connectRetry()
 {
-    if (_connectionTimer <= 0) {
+    //Jittered exponential backoff keeps devices from reconnecting in lock-step
+    if (_reconnect.ready(millis())) {
         Serial.println("Starting reconnect");
-        connect();
-        _connectionTimer = CONNECTION_TIMER_DEFAULT;
-    } else {
-        --_connectionTimer;
+        if (!connect()) {
+            Serial.print("Reconnect in ");
+            Serial.print(_reconnect.failed(millis()));
+            Serial.println(" ms");
+        }
     }
 }
 
 int WebsocketClient::run()
 {
   if (!client.connected()) {
-      _connected = false;
+      if (_connected) {
+          _connected = false;
+          _reconnect.failed(millis()); //back off before the first attempt
+      }
       connectRetry();
   }
-  if (client.available() > 0)
-  {
-    Serial.print("Data : ");
-    Serial.println(client.available());
+  if (!_connected) {
+    return 0;
+  }
 
-    char c = client.read();
-    uint8_t op = c & 0b00001111;
-    uint8_t fin = c & 0b10000000;
-    Serial.print("Opcode : ");
-    Serial.println(op,BIN);
-    Serial.print("Fin : ");
-    Serial.println(fin,BIN);
-    /*
-      0x00: this frame continues the payload from the last.
-      0x01: this frame includes utf-8 text data.
-      0x02: this frame includes binary data.
-      0x08: this frame terminates the connection.
-      0x09: this frame is a ping.
-      0x10: this frame is a pong.    
-    */
-    if (op == 0x00 || op == 0x01 || op==0x02) //Data
-    {
-      Serial.println("WS Got opcode packet");
-      if (fin > 0)
-      {
-        Serial.println("Single frame message");
-        c = client.read();
-        char masked = c & 0b10000000;
-        uint16_t len = c & 0b01111111;
-        
-        if (len == 126)
-        {
-          //next 2 bytes are length
-          len = client.read();
-          len << 8;
-          len = len & client.read();
-        }
-        if (len == 127)
-        {
-          //next 8 bytes are length
-          Serial.println("64bit messages not supported");
-          return -1;
-        }
-        
-        Serial.print("Message is ");
-        Serial.print(len);
-        Serial.println(" chars long");        
-        
-        //Generally server replies are not masked, but RFC does not forbid it
-        char mask[4];
-        if (masked > 0)
-        {
-          mask[0] = client.read();
-          mask[1] = client.read();
-          mask[2] = client.read();
-          mask[3] = client.read();
-        }
-        
-        char data[len+1]; //Max 16bit length message, so 65kbyte ...
-        for (uint8_t i=0; i<len; i++)
-        {
-          data[i] = client.read();
-          if (masked > 0) data[i] = data[i] ^ mask[i % 4];
+  //Read whatever has arrived without waiting for the rest of the frame.
+  //The parser keeps its state between calls, so frames may be split
+  //across any number of reads.
+  int available = client.available();
+  if (available <= 0) {
+    return 0;
+  }
+  if (available > (int) sizeof(_rx)) {
+    available = sizeof(_rx);
+  }
+  int count = client.read(_rx, available);
+  int idx = 0;
+  while (idx < count) {
+    WsChunk chunk;
+    int rc = _parser.parse(_rx + idx, count - idx, &chunk);
+    if (rc < 0) {
+      Serial.print("Protocol error ");
+      Serial.println(_parser.error());
+      fail((_parser.error() == WsParser::ERROR_TOO_LARGE) ?
+           WS_CLOSE_TOO_LARGE : WS_CLOSE_PROTOCOL_ERROR);
+      return -1;
+    }
+    idx += rc;
+    if (!chunk.ready) {
+      continue;
+    }
+    //The parser bounds the frame length to the size of _frame
+    if (chunk.first) {
+      _frameLength = 0;
+    }
+    memcpy(_frame + _frameLength, chunk.data, chunk.length);
+    _frameLength += chunk.length;
+    if (chunk.last) {
+      handleFrame(chunk.opcode, chunk.fin, _frame, _frameLength);
+      if (!_connected) {
+        break;  //closed by the frame, discard the rest
+      }
+    }
+  }
+  return 0;
+}
+
+void WebsocketClient::handleFrame(uint8_t op, boolean fin, uint8_t * data, uint16_t length)
+{
+  switch (op) {
+    case WS_OPCODE_CONTINUATION:
+    case WS_OPCODE_TEXT:
+    case WS_OPCODE_BINARY: {
+      uint8_t* msg;
+      uint32_t msgLength;
+      uint8_t msgOpcode;
+      int rc = _reassembler.add(op, fin, data, length, &msg, &msgLength, &msgOpcode);
+      if (rc == 1) {
+        msg[msgLength] = 0; // both buffers reserve space for the terminator
+        if (_fnc) {
+          _fnc((char*) msg, msgLength, msgOpcode);
         }
-        data[len] = NULL;
-        Serial.println("Frame contents : ");
-        Serial.println(data); //This is UTF-8 code, but for the general ASCII table UTF8 and ASCII are the same, so it wont matter if we dont send/recieve special chars.
-        _fnc(data);
-      } //Currently this code does not handle fragmented messenges, since a single message can be 64bit long, only streaming binary data seems likely to need fragmentation.
-      
-    } else if (op == 0x08)
-    {
+      } else if (rc) {
+        fail(rc);
+      }
+      break;
+    }
+    case WS_OPCODE_CLOSE:
       Serial.println("WS Disconnect opcode");
-      client.write(op); //RFC requires we return a close op code before closing the connection
-      delay(25);
+      //RFC requires we echo the status code before closing the connection
+      sendFrame(WS_OPCODE_CLOSE, (char*) data, (length >= 2) ? 2 : 0);
       client.stop();
-    } else if (op == 0x09)
-    {
-      Serial.println("Got ping ...");      
-      sendPong();
-    } else if (op = 0x10)
-    {
+      _connected = false;
+      break;
+    case WS_OPCODE_PING:
+      Serial.println("Got ping ...");
+      sendPong(data, length);
+      break;
+    case WS_OPCODE_PONG:
       Serial.println("Got pong ...");
-      c = client.read();
-      char masked = c & 0b10000000;
-      uint16_t len = c & 0b01111111;      
-      while (len > 0) //A pong can contain app data, but shouldnt if we didnt send any...
-      {
-        client.read();
-        len--;
-      }
-    } else {
-      Serial.print("Unknown opcode "); //Or not start of package if we failed to parse the entire previous one
+      break;
+    default:
+      Serial.print("Unknown opcode ");
       Serial.println(op);
-    }
+      fail(WS_CLOSE_PROTOCOL_ERROR);
+      break;
   }
-  return 0;
 }
 
-boolean WebsocketClient::sendPong()
+void WebsocketClient::fail(uint16_t status)
+{
+  sendClose(status);
+  client.stop();
+  _connected = false;
+}
+
+boolean WebsocketClient::sendClose(uint16_t status)
 {
-  client.write(0x8A); //Pong
-  client.write(0x00); //no mask, zero length
+  char payload[2] = {(char) (status >> 8), (char) (status & 0xFF)};
+  return sendFrame(WS_OPCODE_CLOSE, payload, sizeof(payload));
+}
+
+boolean WebsocketClient::sendPong(const uint8_t* data, uint8_t length)
+{
+  //A pong echoes the application data of the ping
+  return sendFrame(WS_OPCODE_PONG, (const char*) data, length);
 }
 
 boolean WebsocketClient::sendPing()
 {
-  client.write(0x89); //Ping
-  client.write(0x00); //no mask, zero length
+  return sendFrame(WS_OPCODE_PING, NULL, 0);
 }
 
 boolean WebsocketClient::sendMessage(char* msg, uint16_t length)
+{
+  return sendFrame(WS_OPCODE_TEXT, msg, length);
+}
+
+boolean WebsocketClient::sendBinary(const char* data, uint16_t length)
+{
+  return sendFrame(WS_OPCODE_BINARY, data, length);
+}
+
+boolean WebsocketClient::sendFrame(uint8_t opcode, const char* msg, uint16_t length)
 {
   /*
   +-+-+-+-+-------+-+-------------+-------------------------------+
@@ -341,10 +300,14 @@ boolean WebsocketClient::sendMessage(char* msg, uint16_t length)
   0x02: this frame includes binary data.
   0x08: this frame terminates the connection.
   0x09: this frame is a ping.
-  0x10: this frame is a pong.
+  0x0A: this frame is a pong.
   */
-    
-  client.write(0b10000001);
+  if (!client.connected()) {
+    return false;
+  }
+  //32-bit counts, since the header and a 65535 byte payload exceed 16 bits
+  uint32_t idx = 0;
+  _tx[idx++] = 0b10000000 | opcode;
   
   /*
   payload_len (7 bits): the length of the payload.
@@ -358,24 +321,42 @@ boolean WebsocketClient::sendMessage(char* msg, uint16_t length)
   
   if (length <= 125) 
   {
-    client.write(0b10000000 | length);
+    _tx[idx++] = 0b10000000 | length;
   }
   else
   {
-    client.write(0b11111110); //mask+126
-    client.write((uint8_t)(length >> 8));
-    client.write((uint8_t)(length & 0xFF));
+    _tx[idx++] = 0b11111110; //mask+126
+    _tx[idx++] = (uint8_t)(length >> 8);
+    _tx[idx++] = (uint8_t)(length & 0xFF);
   }
   //64bit outgoing messenges not supported
   
-  byte mask[4];
+  uint8_t mask[4];
   for (uint8_t i=0; i<4; i++)
   {
-    mask[i] = random(0, 255);
-    client.write(mask[i]);
+    mask[i] = random(0, 256);
+    _tx[idx++] = mask[i];
   }
-  for (uint16_t i=0; i<length; i++) {
-    client.write(msg[i] ^ mask[i % 4]);
+
+  //Mask the payload while copying it after the header so that the
+  //whole frame goes out with a single write
+  uint8_t phase = 0;
+  uint32_t pos = 0;
+  while (1) {
+    uint32_t n = length - pos;
+    if (n > sizeof(_tx) - idx) {
+      n = sizeof(_tx) - idx;
+    }
+    phase = ws_mask_copy(_tx + idx, (const uint8_t*) msg + pos, n, mask, phase);
+    pos += n;
+    idx += n;
+    if (client.write(_tx, idx) != idx) {
+      return false;
+    }
+    if (pos >= length) {
+      return true;
+    }
+    idx = 0;
   }
 }
 
@@ -3,7 +3,11 @@
   https://github.com/MORA99/Stokerbot/tree/master/Libraries/WebSocketClient
   Released into the public domain - http://unlicense.org
   
-  Note: This package includes Base64 and sha1 implementation that I did not write.
+  Note: Energia builds a library only from its own directory, so this package
+  includes copies of the shared WebSocket code in the common directory of
+  mcu_proto.  Edit the files in common, then run "make -C test energia_copies"
+  to update the copies.  "make -C test" checks that the copies match.
+  The copies include Base64 and sha1 implementations that I did not write.
   Base64 : https://github.com/adamvr/arduino-base64
   Sha1 : Part of https://code.google.com/p/cryptosuite/
   
@@ -17,9 +21,34 @@
 #include <WiFi.h>
 #include <WiFiClient.h>
 //#include <EthernetClient>
+#include "ws_parser.h"
+#include "reconnect.h"
+#include "ws_handshake.h"
+
+// The maximum received message size, excluding the null terminator.
+#ifndef WEBSOCKET_MAX_MESSAGE_SIZE
+#define WEBSOCKET_MAX_MESSAGE_SIZE 256
+#endif
+
+// The transmit buffer size which holds the frame header and masked payload.
+// Messages up to WEBSOCKET_MAX_MESSAGE_SIZE are sent with a single write.
+#define WEBSOCKET_TX_BUFFER_SIZE (WEBSOCKET_MAX_MESSAGE_SIZE + 8)
+
+// The number of received bytes read from the client at a time by run().
+#ifndef WEBSOCKET_RX_BUFFER_SIZE
+#define WEBSOCKET_RX_BUFFER_SIZE 128
+#endif
 
 typedef void (*onConnect)();
-typedef void (*onMessage)(char* msg);
+
+/**
+ * The received message callback.
+ *
+ * @param msg The message payload.  Text messages are null terminated.
+ * @param length The message length in bytes.
+ * @param opcode WS_OPCODE_TEXT or WS_OPCODE_BINARY.
+ */
+typedef void (*onMessage)(char* msg, uint16_t length, uint8_t opcode);
 
 class WebsocketClient
 {
@@ -31,29 +60,40 @@ class WebsocketClient
   uint16_t _port;
   char* _host;
   char* _path;
-  char _key[25];
+  WsHandshake _handshake;
   boolean _ssl;
   boolean _connected;
-  uint8_t _connectionTimer;
+  ReconnectScheduler _reconnect;
+  WsParser _parser;
+  uint8_t _rx[WEBSOCKET_RX_BUFFER_SIZE];
+  uint16_t _frameLength;
+  uint8_t _frame[WEBSOCKET_MAX_MESSAGE_SIZE + 1];
+  uint8_t _message[WEBSOCKET_MAX_MESSAGE_SIZE + 1];
+  uint8_t _tx[WEBSOCKET_TX_BUFFER_SIZE];
+  WsReassembler _reassembler;
   
-  boolean sendPong();
+  boolean sendPong(const uint8_t* data, uint8_t length);
+  boolean sendClose(uint16_t status);
+  boolean sendFrame(uint8_t opcode, const char* msg, uint16_t length);
+  void fail(uint16_t status);
   void connectRetry();
 
 public:
   WebsocketClient(char* host, uint16_t port, char* path, boolean ssl, 
                   onConnect fconnect, onMessage fmessage);
   boolean connect();
+  void setReconnect(uint32_t baseMs, uint32_t maxMs, uint32_t seed);
   int run();
   boolean sendPing();
   boolean sendMessage(char* msg, uint16_t length);
+  boolean sendBinary(const char* data, uint16_t length);
   
 private:
-  void generate_key();
-  boolean validate_accept_key(char * acceptKey);
   boolean client_connect();
-  void client_send_header();
+  boolean client_send_header();
   boolean client_validate_response();
-  boolean client_read_line(char * line, uint16_t length);
+  boolean client_read(uint8_t * data, uint16_t length);
+  void handleFrame(uint8_t op, boolean fin, uint8_t * data, uint16_t length);
 };
 #endif
 
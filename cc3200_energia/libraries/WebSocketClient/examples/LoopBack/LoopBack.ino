@@ -14,12 +14,12 @@ int clientid = 0;
 
 
 
-void newMessage(char* msg); //This function will be called when the websocket gets new data
-WebsocketClient wsc("echo.websocket.org", 80, "/", false, newMessage); //Public loopback service
-WebsocketClient wsc("echo.websocket.org", 443, "/", true, newMessage); //Public loopback service SSL
+void newMessage(char* msg, uint16_t length, uint8_t opcode); //This function will be called when the websocket gets new data
+WebsocketClient wsc("echo.websocket.org", 80, "/", false, NULL, newMessage); //Public loopback service
+//WebsocketClient wsc("echo.websocket.org", 443, "/", true, NULL, newMessage); //Public loopback service SSL
 
 
-void newMessage(char* msg)
+void newMessage(char* msg, uint16_t length, uint8_t opcode)
 {
   Serial.print("Got msg : ");
   Serial.println(msg);
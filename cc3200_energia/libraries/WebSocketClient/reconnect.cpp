@@ -0,0 +1,59 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "reconnect.h"
+
+ReconnectScheduler::ReconnectScheduler(uint32_t baseMs, uint32_t maxMs,
+                                       uint32_t seed)
+        : baseMs_(baseMs ? baseMs : 1)
+        , maxMs_(maxMs) {
+    this->seed(seed);
+    reset();
+}
+
+void ReconnectScheduler::seed(uint32_t seed) {
+    state_ = seed ? seed : 0x9E3779B9;  // xorshift must not be zero
+}
+
+void ReconnectScheduler::reset() {
+    failures_ = 0;
+    nextMs_ = 0;
+    waiting_ = false;
+}
+
+uint32_t ReconnectScheduler::random() {
+    uint32_t x = state_;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state_ = x;
+    return x;
+}
+
+uint32_t ReconnectScheduler::failed(uint32_t nowMs) {
+    // The exponential ceiling, saturating at maxMs_
+    uint32_t ceiling = baseMs_;
+    for (uint32_t i = 0; (i < failures_) && (ceiling < maxMs_) &&
+            (ceiling < 0x80000000); ++i) {
+        ceiling <<= 1;
+    }
+    if (ceiling > maxMs_) {
+        ceiling = maxMs_;
+    }
+    if (failures_ < 0xffffffff) {
+        ++failures_;
+    }
+    uint32_t delay = (uint32_t) (((uint64_t) random() * (ceiling + 1)) >> 32);
+    nextMs_ = nowMs + delay;
+    waiting_ = true;
+    return delay;
+}
+
+bool ReconnectScheduler::ready(uint32_t nowMs) const {
+    return !waiting_ || ((int32_t) (nowMs - nextMs_) >= 0);
+}
+
+uint32_t ReconnectScheduler::failures() const {
+    return failures_;
+}
@@ -2,7 +2,10 @@
 #define Sha1_h
 
 #include <inttypes.h>
+#include <stddef.h>
+#ifdef ARDUINO
 #include "Print.h"
+#endif
 
 #define HASH_LENGTH 20
 #define BLOCK_LENGTH 64
@@ -16,20 +19,35 @@ union _state {
   uint32_t w[HASH_LENGTH/4];
 };
 
-class Sha1Class : public Print
+/**
+ * SHA-1 message digest (FIPS 180-4).
+ *
+ * Feed data with update(), which hashes whole 64-byte blocks directly
+ * from the input.  The Print interface remains for compatibility and
+ * forwards to update().
+ */
+class Sha1Class
+#ifdef ARDUINO
+  : public Print
+#endif
 {
   public:
     void init(void);
+    void update(const void* data, size_t length);
     void initHmac(const uint8_t* secret, int secretLength);
     uint8_t* result(void);
     uint8_t* resultHmac(void);
     virtual size_t write(uint8_t);
+#ifdef ARDUINO
+    virtual size_t write(const uint8_t* buffer, size_t size);
     using Print::write;
+#else
+    size_t write(const uint8_t* buffer, size_t size);
+    size_t print(const char* str);
+#endif
   private:
     void pad();
-    void addUncounted(uint8_t data);
-    void hashBlock();
-    uint32_t rol32(uint32_t number, uint8_t bits);
+    void hashBlock(const uint8_t* block);
     _buffer buffer;
     uint8_t bufferOffset;
     _state state;
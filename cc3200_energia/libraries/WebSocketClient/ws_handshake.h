@@ -0,0 +1,113 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** WebSocket opening handshake for clients (RFC 6455 section 4.1).
+ *
+ * Generates the Sec-WebSocket-Key for each connection, formats the
+ * http upgrade request and parses the server response incrementally.
+ * The response may arrive in arbitrary chunks.  Parsing stops right
+ * after the blank line that ends the headers, so any frame bytes
+ * received with the response remain for the frame parser.  No memory
+ * is allocated.
+ */
+
+#ifndef WS_HANDSHAKE_H
+#define WS_HANDSHAKE_H
+
+#include <stdint.h>
+
+/** The maximum stored length of each response line.
+ *
+ * Longer lines are truncated, which is harmless for the headers that
+ * the handshake checks.
+ */
+#ifndef WS_HANDSHAKE_LINE_MAX
+#define WS_HANDSHAKE_LINE_MAX 80
+#endif
+
+class WsHandshake {
+public:
+    enum Status {
+        STATUS_PENDING = 0,  // More response bytes are needed
+        STATUS_DONE = 1,     // The server accepted the upgrade
+        STATUS_ERROR = -1    // The server rejected the upgrade
+    };
+
+    enum Error {
+        ERROR_NONE = 0,
+        ERROR_STATUS = 1,      // The response status was not 101
+        ERROR_UPGRADE = 2,     // Missing "Upgrade: websocket"
+        ERROR_CONNECTION = 3,  // Missing "Connection: Upgrade"
+        ERROR_ACCEPT = 4       // Missing or wrong Sec-WebSocket-Accept
+    };
+
+    WsHandshake();
+
+    /** Start a new handshake.
+     *
+     * @param nonce 16 random bytes which must differ for each
+     *      connection.
+     */
+    void start(const uint8_t * nonce);
+
+    /** Get the Base64 encoded Sec-WebSocket-Key.
+     *
+     * @return The null terminated key.
+     */
+    const char * key() const;
+
+    /** Format the http upgrade request.
+     *
+     * @param buf The output buffer.
+     * @param size The size of buf in bytes.
+     * @param host The server host name.
+     * @param port The server port included in the Host header, or 0 to
+     *      omit it.
+     * @param path The resource path, such as "/ws".
+     * @param protocol The optional Sec-WebSocket-Protocol or NULL.
+     * @return The request length excluding the null terminator, or -1 if
+     *      buf is too small.
+     */
+    int request(char * buf, int size, const char * host, uint16_t port,
+                const char * path, const char * protocol = 0) const;
+
+    /** Parse response bytes.
+     *
+     * @param data The received bytes.
+     * @param length The number of bytes in data.
+     * @return The number of bytes consumed.  Once status() is not
+     *      STATUS_PENDING, no more bytes are consumed and the remaining
+     *      bytes belong to the websocket frames.
+     */
+    int parse(const uint8_t * data, int length);
+
+    /** Get the handshake status.
+     *
+     * @return The status.
+     */
+    Status status() const;
+
+    /** Get the reason for STATUS_ERROR.
+     *
+     * @return The error.
+     */
+    Error error() const;
+
+private:
+    void parseLine();
+
+    char key_[25];
+    char accept_[29];      // The expected Sec-WebSocket-Accept value
+    char line_[WS_HANDSHAKE_LINE_MAX + 1];
+    uint16_t lineLength_;
+    bool statusLine_;      // True while parsing the status line
+    bool statusOk_;
+    bool upgrade_;
+    bool connection_;
+    bool accepted_;
+    Status status_;
+    Error error_;
+};
+
+#endif /* WS_HANDSHAKE_H */
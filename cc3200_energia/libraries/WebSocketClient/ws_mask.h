@@ -0,0 +1,46 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** WebSocket payload masking (RFC 6455 section 5.3).
+ *
+ * Masking and unmasking are the same operation: each payload byte i is
+ * XORed with mask[i % 4].  These routines process 32 or 64 bits at a
+ * time, or 16 bytes at a time on host builds with SSE2 or NEON.  The
+ * mask phase is carried between calls so that a payload may be masked
+ * in arbitrary chunks, such as the slices returned by WsParser.
+ *
+ * Define WS_MASK_NO_SIMD to use only the word loops.
+ */
+
+#ifndef WS_MASK_H
+#define WS_MASK_H
+
+#include <stdint.h>
+
+/** Mask or unmask bytes in place.
+ *
+ * @param data The bytes to modify.
+ * @param length The number of bytes in data.
+ * @param mask The 4-byte masking key.
+ * @param phase The index into mask for data[0], from 0 to 3.  Use 0 at
+ *      the start of the payload.
+ * @return The phase for the byte following data.
+ */
+uint8_t ws_mask(uint8_t * data, uint32_t length, const uint8_t * mask,
+                uint8_t phase);
+
+/** Mask or unmask bytes while copying.
+ *
+ * @param dst The output buffer which receives length bytes.  It may be
+ *      the same as src but must not otherwise overlap it.
+ * @param src The input bytes.
+ * @param length The number of bytes to copy.
+ * @param mask The 4-byte masking key.
+ * @param phase The index into mask for src[0], from 0 to 3.
+ * @return The phase for the byte following src.
+ */
+uint8_t ws_mask_copy(uint8_t * dst, const uint8_t * src, uint32_t length,
+                     const uint8_t * mask, uint8_t phase);
+
+#endif /* WS_MASK_H */
@@ -0,0 +1,197 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "ws_parser.h"
+#include "ws_mask.h"
+#include <string.h>
+
+WsParser::WsParser(uint32_t maxPayload) : maxPayload_(maxPayload) {
+    reset();
+}
+
+void WsParser::reset() {
+    state_ = STATE_HEADER0;
+    error_ = ERROR_NONE;
+    opcode_ = 0;
+    fin_ = false;
+    masked_ = false;
+    first_ = false;
+    headerBytes_ = 0;
+    length_ = 0;
+    remaining_ = 0;
+    for (int i = 0; i < 4; ++i) {
+        mask_[i] = 0;
+    }
+    maskPhase_ = 0;
+}
+
+bool WsParser::inFrame() const {
+    return state_ != STATE_HEADER0;
+}
+
+WsParser::Error WsParser::error() const {
+    return error_;
+}
+
+int WsParser::fail(Error error) {
+    state_ = STATE_ERROR;
+    error_ = error;
+    return -1;
+}
+
+bool WsParser::endLength() {
+    if (length_ > maxPayload_) {
+        error_ = ERROR_TOO_LARGE;
+        return false;
+    }
+    if ((opcode_ >= WS_OPCODE_CLOSE) && (length_ > WS_CONTROL_MAX_PAYLOAD)) {
+        error_ = ERROR_CONTROL;
+        return false;
+    }
+    if (masked_) {
+        headerBytes_ = 4;
+        state_ = STATE_MASK;
+    } else {
+        startPayload();
+    }
+    return true;
+}
+
+void WsParser::startPayload() {
+    remaining_ = (uint32_t) length_;
+    maskPhase_ = 0;
+    first_ = true;
+    state_ = STATE_PAYLOAD;
+}
+
+int WsParser::parse(uint8_t * data, int length, WsChunk * chunk) {
+    int idx = 0;
+    chunk->ready = false;
+
+    while (true) {
+        if (state_ == STATE_PAYLOAD) {
+            uint32_t n = (uint32_t) (length - idx);
+            if (remaining_ && !n) {
+                break;  // need more data
+            }
+            if (n > remaining_) {
+                n = remaining_;
+            }
+            uint8_t * p = data + idx;
+            if (masked_) {
+                maskPhase_ = ws_mask(p, n, mask_, maskPhase_);
+            }
+            remaining_ -= n;
+            idx += n;
+            chunk->ready = true;
+            chunk->opcode = opcode_;
+            chunk->fin = fin_;
+            chunk->first = first_;
+            chunk->last = (remaining_ == 0);
+            chunk->data = p;
+            chunk->length = n;
+            chunk->frameLength = (uint32_t) length_;
+            first_ = false;
+            if (!remaining_) {
+                state_ = STATE_HEADER0;
+            }
+            return idx;
+        }
+        if (idx >= length) {
+            break;
+        }
+
+        uint8_t c = data[idx++];
+        switch (state_) {
+            case STATE_HEADER0:
+                if (c & 0x70) {
+                    return fail(ERROR_RESERVED_BITS);
+                }
+                fin_ = (c & 0x80) != 0;
+                opcode_ = c & 0x0f;
+                if ((opcode_ > WS_OPCODE_BINARY && opcode_ < WS_OPCODE_CLOSE) ||
+                        (opcode_ > WS_OPCODE_PONG)) {
+                    return fail(ERROR_OPCODE);
+                }
+                if ((opcode_ >= WS_OPCODE_CLOSE) && !fin_) {
+                    return fail(ERROR_CONTROL);
+                }
+                state_ = STATE_HEADER1;
+                break;
+            case STATE_HEADER1:
+                masked_ = (c & 0x80) != 0;
+                length_ = c & 0x7f;
+                if (length_ >= 126) {
+                    headerBytes_ = (length_ == 126) ? 2 : 8;
+                    length_ = 0;
+                    state_ = STATE_LENGTH;
+                } else if (!endLength()) {
+                    return fail(error_);
+                }
+                break;
+            case STATE_LENGTH:
+                length_ = (length_ << 8) | c;
+                if (!--headerBytes_ && !endLength()) {
+                    return fail(error_);
+                }
+                break;
+            case STATE_MASK:
+                mask_[4 - headerBytes_] = c;
+                if (!--headerBytes_) {
+                    startPayload();
+                }
+                break;
+            default:
+                return -1;
+        }
+    }
+    return idx;
+}
+
+WsReassembler::WsReassembler(uint8_t * buffer, uint32_t size)
+        : buffer_(buffer)
+        , size_(size) {
+    reset();
+}
+
+void WsReassembler::reset() {
+    length_ = 0;
+    opcode_ = 0;
+}
+
+int WsReassembler::add(uint8_t opcode, bool fin, uint8_t * data, uint32_t length,
+                       uint8_t ** message, uint32_t * messageLength,
+                       uint8_t * messageOpcode) {
+    if (opcode == WS_OPCODE_CONTINUATION) {
+        if (!opcode_) {
+            return WS_CLOSE_PROTOCOL_ERROR;  // nothing to continue
+        }
+    } else if (opcode_) {
+        return WS_CLOSE_PROTOCOL_ERROR;  // previous message not finished
+    } else if (fin) {
+        // unfragmented, return in place
+        *message = data;
+        *messageLength = length;
+        *messageOpcode = opcode;
+        return 1;
+    } else {
+        opcode_ = opcode;
+        length_ = 0;
+    }
+
+    if (length > size_ - length_) {
+        reset();
+        return WS_CLOSE_TOO_LARGE;
+    }
+    memcpy(buffer_ + length_, data, length);
+    length_ += length;
+    if (!fin) {
+        return 0;
+    }
+    *message = buffer_;
+    *messageLength = length_;
+    *messageOpcode = opcode_;
+    opcode_ = 0;
+    return 1;
+}
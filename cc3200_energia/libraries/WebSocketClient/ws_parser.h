@@ -0,0 +1,162 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Incremental, zero-copy WebSocket frame parser (RFC 6455).
+ *
+ * The parser is fed arbitrary chunks of received bytes, such as the
+ * result of a single bulk socket receive.  Frame headers may be split
+ * across chunks.  Payload bytes are unmasked in place and returned as
+ * slices of the caller's buffer, so no payload copy is made.
+ */
+
+#ifndef WS_PARSER_H
+#define WS_PARSER_H
+
+#include <stdint.h>
+
+#define WS_OPCODE_CONTINUATION 0x0
+#define WS_OPCODE_TEXT         0x1
+#define WS_OPCODE_BINARY       0x2
+#define WS_OPCODE_CLOSE        0x8
+#define WS_OPCODE_PING         0x9
+#define WS_OPCODE_PONG         0xA
+
+#define WS_CLOSE_NORMAL          1000
+#define WS_CLOSE_PROTOCOL_ERROR  1002
+#define WS_CLOSE_TOO_LARGE       1009
+
+/** The maximum payload size for control frames. */
+#define WS_CONTROL_MAX_PAYLOAD 125
+
+/** A slice of a frame payload produced by WsParser::parse(). */
+struct WsChunk {
+    bool ready;            // True if this structure holds a chunk
+    uint8_t opcode;        // The frame opcode
+    bool fin;              // The frame FIN bit
+    bool first;            // True for the first chunk of the frame
+    bool last;             // True if this chunk completes the frame
+    uint8_t * data;        // The unmasked payload slice in the input buffer
+    uint32_t length;       // The payload slice length in bytes
+    uint32_t frameLength;  // The total payload length of the frame
+};
+
+class WsParser {
+public:
+    enum Error {
+        ERROR_NONE = 0,
+        ERROR_RESERVED_BITS = 1,  // RSV1-3 set without a negotiated extension
+        ERROR_TOO_LARGE = 2,      // Payload exceeds the maximum size
+        ERROR_OPCODE = 3,         // Reserved opcode
+        ERROR_CONTROL = 4         // Fragmented or oversized control frame
+    };
+
+    /** Construct a new instance.
+     *
+     * @param maxPayload The maximum allowed frame payload size in bytes.
+     */
+    WsParser(uint32_t maxPayload);
+
+    /** Reset the parser to expect the start of a new frame. */
+    void reset();
+
+    /** Parse received bytes.
+     *
+     * Parsing stops after each chunk so that the caller can process it.
+     * Call repeatedly, advancing data by the return value, until all bytes
+     * are consumed.  A chunk is produced for each contiguous run of payload
+     * bytes and for the completion of zero-length frames.
+     *
+     * @param data The received bytes.  Payload bytes are unmasked in place.
+     * @param length The number of bytes in data.
+     * @param chunk The chunk which is filled in when chunk->ready is true.
+     * @return The number of bytes consumed from data or -1 on a protocol
+     *      error.  Once an error occurs, the connection should be closed.
+     */
+    int parse(uint8_t * data, int length, WsChunk * chunk);
+
+    /** Check for a partially received frame.
+     *
+     * @return True if the parser is in the middle of a frame.
+     */
+    bool inFrame() const;
+
+    /** Get the most recent error.
+     *
+     * @return The error code.
+     */
+    Error error() const;
+
+private:
+    enum State {
+        STATE_HEADER0,
+        STATE_HEADER1,
+        STATE_LENGTH,
+        STATE_MASK,
+        STATE_PAYLOAD,
+        STATE_ERROR
+    };
+
+    int fail(Error error);
+    bool endLength();
+    void startPayload();
+
+    uint32_t maxPayload_;
+    State state_;
+    Error error_;
+    uint8_t opcode_;
+    bool fin_;
+    bool masked_;
+    bool first_;
+    uint8_t headerBytes_;    // Bytes remaining for STATE_LENGTH or STATE_MASK
+    uint64_t length_;        // The frame payload length
+    uint32_t remaining_;     // Payload bytes remaining in the frame
+    uint8_t mask_[4];
+    uint8_t maskPhase_;
+};
+
+/** Reassemble fragmented data messages into a bounded buffer.
+ *
+ * Unfragmented messages are returned in place without copying.  The
+ * payloads of fragmented messages are copied into the buffer provided
+ * to the constructor.  Control frames may be interleaved with the
+ * fragments and must not be passed to add().
+ */
+class WsReassembler {
+public:
+    /** Construct a new instance.
+     *
+     * @param buffer The buffer for reassembling fragmented messages.
+     * @param size The size of buffer in bytes, which is the maximum
+     *      fragmented message size.
+     */
+    WsReassembler(uint8_t * buffer, uint32_t size);
+
+    /** Discard any partially reassembled message. */
+    void reset();
+
+    /** Add a complete data frame.
+     *
+     * @param opcode The frame opcode: WS_OPCODE_TEXT, WS_OPCODE_BINARY or
+     *      WS_OPCODE_CONTINUATION.
+     * @param fin The frame FIN bit.
+     * @param data The unmasked frame payload.
+     * @param length The frame payload length.
+     * @param message Set to the complete message payload.
+     * @param messageLength Set to the complete message length.
+     * @param messageOpcode Set to WS_OPCODE_TEXT or WS_OPCODE_BINARY.
+     * @return 1 if a complete message is available, 0 if more fragments
+     *      are needed, or the WS_CLOSE_* status code on error.
+     */
+    int add(uint8_t opcode, bool fin, uint8_t * data, uint32_t length,
+            uint8_t ** message, uint32_t * messageLength,
+            uint8_t * messageOpcode);
+
+private:
+    uint8_t * buffer_;
+    uint32_t size_;
+    uint32_t length_;
+    uint8_t opcode_;  // The message opcode or 0 when not fragmented
+};
+
+#endif /* WS_PARSER_H */
@@ -0,0 +1,314 @@
+#include "Base64.h"
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BASE64_SIMD_AVX2 1
+#define BASE64_SIMD_SSSE3 1
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define BASE64_SIMD_SSSE3 1
+#endif
+
+const char b64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+		"abcdefghijklmnopqrstuvwxyz"
+		"0123456789+/";
+
+/* The 6-bit value for each character, or 0xFF for invalid characters.
+ * 0xFF matches the result of the original per character search, which
+ * returned -1 as an unsigned char. */
+static const unsigned char b64_decode_table[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+	0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+/* 'Private' declarations */
+static inline void a3_to_a4(unsigned char * a4, const unsigned char * a3);
+static inline void a4_to_a3(unsigned char * a3, const unsigned char * a4);
+
+/* Encode whole groups of 3 bytes, returning the number of characters. */
+static int encode_blocks(char * output, const unsigned char * input, int inputLen) {
+	int i = 0;
+	int encLen = 0;
+
+#if BASE64_SIMD_SSSE3
+	/* Wojciech Muła's method: spread 12 bytes into 16 lanes of 6-bit
+	 * indices, then translate the indices to characters with pshufb. */
+	const __m128i shuf = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'+' - 62, '/' - 63, 'A', 0, 0);
+#if BASE64_SIMD_AVX2
+	const __m256i shuf256 = _mm256_broadcastsi128_si256(shuf);
+	const __m256i shift_lut256 = _mm256_broadcastsi128_si256(shift_lut);
+	/* Each 128-bit lane loads 16 bytes and uses 12, so keep 4 spare bytes */
+	for (; i + 28 <= inputLen; i += 24, encLen += 32) {
+		__m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(
+				_mm_loadu_si128((const __m128i *) (input + i))),
+				_mm_loadu_si128((const __m128i *) (input + i + 12)), 1);
+		in = _mm256_shuffle_epi8(in, shuf256);
+		__m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+		__m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+		__m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+		__m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+		__m256i indices = _mm256_or_si256(t1, t3);
+		__m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+		__m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+		result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+		result = _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut256, result), indices);
+		_mm256_storeu_si256((__m256i *) (output + encLen), result);
+	}
+#endif
+	for (; i + 16 <= inputLen; i += 12, encLen += 16) {
+		__m128i in = _mm_loadu_si128((const __m128i *) (input + i));
+		in = _mm_shuffle_epi8(in, shuf);
+		__m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+		__m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+		__m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+		__m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+		__m128i indices = _mm_or_si128(t1, t3);
+		__m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+		__m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+		result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+		result = _mm_add_epi8(_mm_shuffle_epi8(shift_lut, result), indices);
+		_mm_storeu_si128((__m128i *) (output + encLen), result);
+	}
+#endif
+
+	for (; i + 3 <= inputLen; i += 3) {
+		unsigned int v = (input[i] << 16) | (input[i + 1] << 8) | input[i + 2];
+		output[encLen++] = b64_alphabet[v >> 18];
+		output[encLen++] = b64_alphabet[(v >> 12) & 0x3f];
+		output[encLen++] = b64_alphabet[(v >> 6) & 0x3f];
+		output[encLen++] = b64_alphabet[v & 0x3f];
+	}
+	return encLen;
+}
+
+#if BASE64_SIMD_SSSE3
+/* Decode 16 characters to 12 bytes.  Returns false, without writing
+ * output, if any character is not in the alphabet. */
+static inline bool decode_simd16(unsigned char * output, const char * input) {
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+			0, 0, 0, 0, 0, 0, 0, 0);
+	__m128i in = _mm_loadu_si128((const __m128i *) input);
+	__m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+	__m128i lo_nibbles = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+	__m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+	__m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+	if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()))) {
+		return false;
+	}
+	__m128i eq_2f = _mm_cmpeq_epi8(in, _mm_set1_epi8(0x2f));
+	__m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+	__m128i values = _mm_add_epi8(in, roll);
+	__m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+	__m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+	packed = _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	unsigned char tmp[16];
+	_mm_storeu_si128((__m128i *) tmp, packed);
+	memcpy(output, tmp, 12);
+	return true;
+}
+#endif
+
+/* Decode whole groups of 4 characters, returning the number of bytes. */
+static int decode_blocks(unsigned char * output, const char * input, int inputLen) {
+	int i = 0;
+	int decLen = 0;
+	unsigned char a4[4];
+
+	while (i + 4 <= inputLen) {
+#if BASE64_SIMD_SSSE3
+		if ((i + 16 <= inputLen) && decode_simd16(output + decLen, input + i)) {
+			i += 16;
+			decLen += 12;
+			continue;
+		}
+#endif
+		/* Invalid characters decode exactly as the original code did */
+		a4[0] = b64_decode_table[(unsigned char) input[i++]];
+		a4[1] = b64_decode_table[(unsigned char) input[i++]];
+		a4[2] = b64_decode_table[(unsigned char) input[i++]];
+		a4[3] = b64_decode_table[(unsigned char) input[i++]];
+		a4_to_a3(output + decLen, a4);
+		decLen += 3;
+	}
+	return decLen;
+}
+
+void base64_encode_init(struct base64_encoder_s * enc) {
+	enc->carryLen = 0;
+}
+
+int base64_encode_update(struct base64_encoder_s * enc, char * output,
+		const char * input, int inputLen) {
+	const unsigned char * in = (const unsigned char *) input;
+	int encLen = 0;
+
+	/* Complete the group carried from the previous call */
+	while (enc->carryLen && inputLen) {
+		enc->carry[enc->carryLen++] = *(in++);
+		inputLen--;
+		if (enc->carryLen == 3) {
+			encLen = encode_blocks(output, enc->carry, 3);
+			enc->carryLen = 0;
+		}
+	}
+
+	int n = inputLen - (inputLen % 3);
+	encLen += encode_blocks(output + encLen, in, n);
+	for (; n < inputLen; n++) {
+		enc->carry[enc->carryLen++] = in[n];
+	}
+	return encLen;
+}
+
+int base64_encode_final(struct base64_encoder_s * enc, char * output) {
+	int i = enc->carryLen;
+	int j;
+	int encLen = 0;
+	unsigned char a4[4];
+
+	if (i) {
+		for (j = i; j < 3; j++) {
+			enc->carry[j] = '\0';
+		}
+
+		a3_to_a4(a4, enc->carry);
+
+		for (j = 0; j < i + 1; j++) {
+			output[encLen++] = b64_alphabet[a4[j]];
+		}
+
+		while ((i++ < 3)) {
+			output[encLen++] = '=';
+		}
+	}
+	output[encLen] = '\0';
+	enc->carryLen = 0;
+	return encLen;
+}
+
+int base64_encode(char *output, char *input, int inputLen) {
+	struct base64_encoder_s enc;
+	base64_encode_init(&enc);
+	int encLen = base64_encode_update(&enc, output, input, inputLen);
+	return encLen + base64_encode_final(&enc, output + encLen);
+}
+
+void base64_decode_init(struct base64_decoder_s * dec) {
+	dec->carryLen = 0;
+	dec->done = 0;
+}
+
+int base64_decode_update(struct base64_decoder_s * dec, char * output,
+		const char * input, int inputLen) {
+	unsigned char * out = (unsigned char *) output;
+	int decLen = 0;
+
+	if (dec->done) {
+		return 0;
+	}
+
+	/* Decoding stops at the first '=' */
+	const char * pad = (const char *) memchr(input, '=', inputLen);
+	if (pad) {
+		inputLen = pad - input;
+		dec->done = 1;
+	}
+
+	/* Complete the group carried from the previous call */
+	while (dec->carryLen && inputLen) {
+		dec->carry[dec->carryLen++] = b64_decode_table[(unsigned char) *(input++)];
+		inputLen--;
+		if (dec->carryLen == 4) {
+			a4_to_a3(out, dec->carry);
+			decLen = 3;
+			dec->carryLen = 0;
+		}
+	}
+
+	int n = inputLen - (inputLen % 4);
+	decLen += decode_blocks(out + decLen, input, n);
+	for (; n < inputLen; n++) {
+		dec->carry[dec->carryLen++] = b64_decode_table[(unsigned char) input[n]];
+	}
+	return decLen;
+}
+
+int base64_decode_final(struct base64_decoder_s * dec, char * output) {
+	int i = dec->carryLen;
+	int j;
+	int decLen = 0;
+	unsigned char a3[3];
+
+	if (i) {
+		for (j = i; j < 4; j++) {
+			dec->carry[j] = b64_decode_table[0];
+		}
+
+		a4_to_a3(a3, dec->carry);
+
+		for (j = 0; j < i - 1; j++) {
+			output[decLen++] = a3[j];
+		}
+	}
+	output[decLen] = '\0';
+	dec->carryLen = 0;
+	dec->done = 0;
+	return decLen;
+}
+
+int base64_decode(char * output, char * input, int inputLen) {
+	struct base64_decoder_s dec;
+	base64_decode_init(&dec);
+	int decLen = base64_decode_update(&dec, output, input, inputLen);
+	return decLen + base64_decode_final(&dec, output + decLen);
+}
+
+int base64_enc_len(int plainLen) {
+	int n = plainLen;
+	return (n + 2 - ((n + 2) % 3)) / 3 * 4;
+}
+
+int base64_dec_len(char * input, int inputLen) {
+	int i = 0;
+	int numEq = 0;
+	for(i = inputLen - 1; input[i] == '='; i--) {
+		numEq++;
+	}
+
+	return ((6 * inputLen) / 8) - numEq;
+}
+
+static inline void a3_to_a4(unsigned char * a4, const unsigned char * a3) {
+	a4[0] = (a3[0] & 0xfc) >> 2;
+	a4[1] = ((a3[0] & 0x03) << 4) + ((a3[1] & 0xf0) >> 4);
+	a4[2] = ((a3[1] & 0x0f) << 2) + ((a3[2] & 0xc0) >> 6);
+	a4[3] = (a3[2] & 0x3f);
+}
+
+static inline void a4_to_a3(unsigned char * a3, const unsigned char * a4) {
+	a3[0] = (a4[0] << 2) + ((a4[1] & 0x30) >> 4);
+	a3[1] = ((a4[1] & 0xf) << 4) + ((a4[2] & 0x3c) >> 2);
+	a3[2] = ((a4[2] & 0x3) << 6) + a4[3];
+}
@@ -0,0 +1,242 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "hsv.h"
+#include <math.h>
+
+#if defined(HSV_NO_SIMD)
+// scalar only
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define HSV_SIMD_AVX2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HSV_SIMD_SSE2 1
+#endif
+
+const pixel_layout_s PIXEL_LAYOUT_APA102 = {4, 3, 2, 1};
+const pixel_layout_s PIXEL_LAYOUT_RGB = {3, 0, 1, 2};
+const pixel_layout_s PIXEL_LAYOUT_GRB = {3, 1, 0, 2};
+const pixel_layout_s PIXEL_LAYOUT_RBG = {3, 0, 2, 1};
+
+// The component values for each hue sector are {w, y, z, x} where
+//   w = v
+//   x = v * (1 - s)
+//   y = v * (1 - s * f)
+//   z = v * (1 - s * (1 - f))
+// and f is the fractional position within the sector.  This table selects
+// the component for red, green and blue in each of the six sectors.
+static const uint8_t SECTOR[6][3] = {
+    {0, 2, 3},  // w, z, x
+    {1, 0, 3},  // y, w, x
+    {3, 0, 2},  // x, w, z
+    {3, 1, 0},  // x, y, w
+    {2, 3, 0},  // z, x, w
+    {0, 3, 1},  // w, x, y
+};
+
+/** Divide by 255 with rounding, valid for x <= 65025. */
+static inline uint32_t div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+uint16_t hsv_hue(float h) {
+    h = h - floor(h);
+    return (uint16_t) (((uint32_t) (h * 65536.0f + 0.5f)) & 0xffff);
+}
+
+uint8_t hsv_unit(float x) {
+    if (x <= 0.0f) {
+        return 0;
+    } else if (x >= 1.0f) {
+        return 255;
+    }
+    return (uint8_t) (x * 255.0f + 0.5f);
+}
+
+static inline void hsv_sector(uint16_t h, uint8_t v, uint32_t vs,
+                              uint8_t * r, uint8_t * g, uint8_t * b) {
+    uint32_t h6 = ((uint32_t) h) * 6;
+    uint32_t f = h6 & 0xffff;
+    const uint8_t * sector = SECTOR[h6 >> 16];
+    uint8_t q = (uint8_t) ((vs * f + 0x8000) >> 16);
+    uint8_t c[4];
+    c[0] = v;                       // w
+    c[1] = v - q;                   // y
+    c[3] = v - (uint8_t) vs;        // x
+    c[2] = c[3] + q;                // z
+    *r = c[sector[0]];
+    *g = c[sector[1]];
+    *b = c[sector[2]];
+}
+
+void hsv_to_rgb(uint16_t h, uint8_t s, uint8_t v, uint8_t * rgb) {
+    uint32_t vs = div255(((uint32_t) v) * s);
+    hsv_sector(h, v, vs, rgb, rgb + 1, rgb + 2);
+}
+
+#if HSV_SIMD_AVX2 || HSV_SIMD_SSE2
+
+// The SIMD paths compute 16-bit lanes with exactly the same arithmetic as
+// hsv_sector() so that the results are bit-identical to the scalar path.
+// The rounded high product (vs * f + 0x8000) >> 16 is computed as
+// mulhi + (mullo >> 15).
+
+#if HSV_SIMD_AVX2
+typedef __m256i vec_t;
+#define HSV_LANES 16
+#define vec_set1(x)       _mm256_set1_epi16((short) (x))
+#define vec_and(a, b)     _mm256_and_si256(a, b)
+#define vec_or(a, b)      _mm256_or_si256(a, b)
+#define vec_andnot(a, b)  _mm256_andnot_si256(a, b)
+#define vec_add(a, b)     _mm256_add_epi16(a, b)
+#define vec_sub(a, b)     _mm256_sub_epi16(a, b)
+#define vec_mullo(a, b)   _mm256_mullo_epi16(a, b)
+#define vec_mulhi(a, b)   _mm256_mulhi_epu16(a, b)
+#define vec_srli(a, n)    _mm256_srli_epi16(a, n)
+#define vec_slli(a, n)    _mm256_slli_epi16(a, n)
+#define vec_cmpeq(a, b)   _mm256_cmpeq_epi16(a, b)
+#define vec_store(p, a)   _mm256_storeu_si256((__m256i *) (p), a)
+static inline vec_t vec_lane_index() {
+    return _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7,
+                             8, 9, 10, 11, 12, 13, 14, 15);
+}
+#else
+typedef __m128i vec_t;
+#define HSV_LANES 8
+#define vec_set1(x)       _mm_set1_epi16((short) (x))
+#define vec_and(a, b)     _mm_and_si128(a, b)
+#define vec_or(a, b)      _mm_or_si128(a, b)
+#define vec_andnot(a, b)  _mm_andnot_si128(a, b)
+#define vec_add(a, b)     _mm_add_epi16(a, b)
+#define vec_sub(a, b)     _mm_sub_epi16(a, b)
+#define vec_mullo(a, b)   _mm_mullo_epi16(a, b)
+#define vec_mulhi(a, b)   _mm_mulhi_epu16(a, b)
+#define vec_srli(a, n)    _mm_srli_epi16(a, n)
+#define vec_slli(a, n)    _mm_slli_epi16(a, n)
+#define vec_cmpeq(a, b)   _mm_cmpeq_epi16(a, b)
+#define vec_store(p, a)   _mm_storeu_si128((__m128i *) (p), a)
+static inline vec_t vec_lane_index() {
+    return _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+}
+#endif
+
+static inline vec_t vec_select(vec_t mask, vec_t a, vec_t b) {
+    return vec_or(vec_and(mask, a), vec_andnot(mask, b));
+}
+
+static inline void hsv_sector_simd(vec_t h, vec_t v, vec_t vs,
+                                   vec_t * r, vec_t * g, vec_t * b) {
+    const vec_t six = vec_set1(6);
+    vec_t f = vec_mullo(h, six);
+    vec_t sector = vec_mulhi(h, six);
+    vec_t q = vec_add(vec_mulhi(f, vs), vec_srli(vec_mullo(f, vs), 15));
+    vec_t w = v;
+    vec_t y = vec_sub(v, q);
+    vec_t x = vec_sub(v, vs);
+    vec_t z = vec_add(x, q);
+    vec_t s0 = vec_cmpeq(sector, vec_set1(0));
+    vec_t s1 = vec_cmpeq(sector, vec_set1(1));
+    vec_t s2 = vec_cmpeq(sector, vec_set1(2));
+    vec_t s3 = vec_cmpeq(sector, vec_set1(3));
+    vec_t s4 = vec_cmpeq(sector, vec_set1(4));
+    vec_t s5 = vec_cmpeq(sector, vec_set1(5));
+    *r = vec_select(vec_or(s0, s5), w, vec_select(s1, y, vec_select(s4, z, x)));
+    *g = vec_select(vec_or(s1, s2), w, vec_select(s0, z, vec_select(s3, y, x)));
+    *b = vec_select(vec_or(s3, s4), w, vec_select(s2, z, vec_select(s5, y, x)));
+}
+
+/** Store APA102 pixels (0xFF, B, G, R) preserving the first byte. */
+static inline void store_apa102(uint8_t * buf, vec_t r, vec_t g, vec_t b) {
+    vec_t lo = vec_slli(b, 8);
+    vec_t hi = vec_or(g, vec_slli(r, 8));
+#if HSV_SIMD_AVX2
+    __m256i p0 = _mm256_unpacklo_epi16(lo, hi);  // pixels 0-3, 8-11
+    __m256i p1 = _mm256_unpackhi_epi16(lo, hi);  // pixels 4-7, 12-15
+    __m256i w0 = _mm256_permute2x128_si256(p0, p1, 0x20);
+    __m256i w1 = _mm256_permute2x128_si256(p0, p1, 0x31);
+    const __m256i keep = _mm256_set1_epi32(0xff);
+    __m256i * dst = (__m256i *) buf;
+    w0 = _mm256_or_si256(w0, _mm256_and_si256(keep, _mm256_loadu_si256(dst)));
+    w1 = _mm256_or_si256(w1, _mm256_and_si256(keep, _mm256_loadu_si256(dst + 1)));
+    _mm256_storeu_si256(dst, w0);
+    _mm256_storeu_si256(dst + 1, w1);
+#else
+    __m128i w0 = _mm_unpacklo_epi16(lo, hi);  // pixels 0-3
+    __m128i w1 = _mm_unpackhi_epi16(lo, hi);  // pixels 4-7
+    const __m128i keep = _mm_set1_epi32(0xff);
+    __m128i * dst = (__m128i *) buf;
+    w0 = _mm_or_si128(w0, _mm_and_si128(keep, _mm_loadu_si128(dst)));
+    w1 = _mm_or_si128(w1, _mm_and_si128(keep, _mm_loadu_si128(dst + 1)));
+    _mm_storeu_si128(dst, w0);
+    _mm_storeu_si128(dst + 1, w1);
+#endif
+}
+
+/** Convert whole groups of HSV_LANES pixels.
+ *
+ * @return The number of pixels converted.
+ */
+static int hsv_to_rgb_strip_simd(uint16_t h, uint16_t h_step,
+                                 uint8_t v, uint32_t vs,
+                                 uint8_t * buf, int count,
+                                 const pixel_layout_s * layout) {
+    int groups = count / HSV_LANES;
+    vec_t hv = vec_add(vec_set1(h), vec_mullo(vec_lane_index(), vec_set1(h_step)));
+    vec_t h_incr = vec_set1((uint16_t) (h_step * HSV_LANES));
+    vec_t vv = vec_set1(v);
+    vec_t vsv = vec_set1(vs);
+    vec_t r, g, b;
+    bool apa102 = (layout->stride == 4) && (layout->r == 3) &&
+                  (layout->g == 2) && (layout->b == 1);
+    uint8_t stride = layout->stride;
+    for (int k = 0; k < groups; ++k) {
+        hsv_sector_simd(hv, vv, vsv, &r, &g, &b);
+        hv = vec_add(hv, h_incr);
+        if (apa102) {
+            store_apa102(buf, r, g, b);
+            buf += HSV_LANES * 4;
+        } else {
+            uint16_t rl[HSV_LANES];
+            uint16_t gl[HSV_LANES];
+            uint16_t bl[HSV_LANES];
+            vec_store(rl, r);
+            vec_store(gl, g);
+            vec_store(bl, b);
+            for (int i = 0; i < HSV_LANES; ++i) {
+                buf[layout->r] = (uint8_t) rl[i];
+                buf[layout->g] = (uint8_t) gl[i];
+                buf[layout->b] = (uint8_t) bl[i];
+                buf += stride;
+            }
+        }
+    }
+    return groups * HSV_LANES;
+}
+
+#endif /* SIMD */
+
+void hsv_to_rgb_strip(uint16_t h, uint16_t h_step, uint8_t s, uint8_t v,
+                      uint8_t * buf, int count,
+                      const pixel_layout_s * layout) {
+    uint32_t vs = div255(((uint32_t) v) * s);
+    uint8_t stride = layout->stride;
+    int i = 0;
+#if HSV_SIMD_AVX2 || HSV_SIMD_SSE2
+    i = hsv_to_rgb_strip_simd(h, h_step, v, vs, buf, count, layout);
+    h += (uint16_t) (i * h_step);
+    buf += i * stride;
+#endif
+    uint8_t * r = buf + layout->r;
+    uint8_t * g = buf + layout->g;
+    uint8_t * b = buf + layout->b;
+    for (; i < count; ++i) {
+        hsv_sector(h, v, vs, r, g, b);
+        h += h_step;
+        r += stride;
+        g += stride;
+        b += stride;
+    }
+}
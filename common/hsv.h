@@ -0,0 +1,85 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Integer hue, saturation, value to red, green, blue conversion.
+ *
+ * The conversion uses only integer multiplies and shifts so that it runs
+ * quickly on processors without a floating point unit.  The results are
+ * within 1 LSB of the floating point conversion at
+ * http://www.easyrgb.com/index.php?X=MATH&H=21#text21
+ *
+ * Host builds compiled with SSE2 or AVX2 enabled (for example -msse2 or
+ * -mavx2) convert strips 8 or 16 pixels at a time.  The vectorized
+ * results are bit-identical to the scalar path.  Define HSV_NO_SIMD to
+ * build only the scalar path.
+ */
+
+#ifndef HSV_H
+#define HSV_H
+
+#include <stdint.h>
+
+/** The byte layout of a single pixel within an LED strip buffer. */
+struct pixel_layout_s {
+    uint8_t stride;  // The total bytes per pixel
+    uint8_t r;       // The red byte offset within the pixel
+    uint8_t g;       // The green byte offset within the pixel
+    uint8_t b;       // The blue byte offset within the pixel
+};
+
+/** APA102 layout: 0xFF (global brightness), blue, green, red. */
+extern const pixel_layout_s PIXEL_LAYOUT_APA102;
+
+/** NeoPixel WS2811 & TM1803 layout: red, green, blue. */
+extern const pixel_layout_s PIXEL_LAYOUT_RGB;
+
+/** NeoPixel WS2812 & WS2812B layout: green, red, blue. */
+extern const pixel_layout_s PIXEL_LAYOUT_GRB;
+
+/** NeoPixel TM1829 layout: red, blue, green. */
+extern const pixel_layout_s PIXEL_LAYOUT_RBG;
+
+/** Convert a floating point hue to the 16-bit fixed-point hue.
+ *
+ * @param h The hue.  Only the fractional part is used.
+ * @return The hue where 65536 is one full rotation.
+ */
+uint16_t hsv_hue(float h);
+
+/** Convert a floating point saturation or value to 8 bits.
+ *
+ * @param x The value from 0.0 to 1.0.  Values outside this range are
+ *      clamped.
+ * @return The value from 0 to 255.
+ */
+uint8_t hsv_unit(float x);
+
+/** Convert a single hue, saturation, value to red, green, blue.
+ *
+ * @param h The hue where 65536 is one full rotation.
+ * @param s The saturation from 0 to 255.
+ * @param v The value/intensity from 0 to 255.
+ * @param rgb The output red, green, blue values from 0 to 255.
+ */
+void hsv_to_rgb(uint16_t h, uint8_t s, uint8_t v, uint8_t * rgb);
+
+/** Convert a strip of pixels with evenly spaced hues.
+ *
+ * Pixel k receives hue h + k * h_step (modulo one rotation).  The bytes
+ * of each pixel not covered by the layout's r, g and b offsets are left
+ * unmodified.
+ *
+ * @param h The hue of the first pixel where 65536 is one full rotation.
+ * @param h_step The hue increment between adjacent pixels.
+ * @param s The saturation from 0 to 255 for all pixels.
+ * @param v The value/intensity from 0 to 255 for all pixels.
+ * @param buf The strip buffer which receives the pixels.
+ * @param count The number of pixels to convert.
+ * @param layout The byte layout of each pixel in buf.
+ */
+void hsv_to_rgb_strip(uint16_t h, uint16_t h_step, uint8_t s, uint8_t v,
+                      uint8_t * buf, int count,
+                      const pixel_layout_s * layout);
+
+#endif /* HSV_H */
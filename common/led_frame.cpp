@@ -0,0 +1,560 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "led_frame.h"
+#include <string.h>
+
+static inline uint16_t read_u16(const uint8_t * p) {
+    return ((uint16_t) p[0] << 8) | p[1];
+}
+
+static inline void write_u16(uint8_t * p, uint16_t value) {
+    p[0] = (uint8_t) (value >> 8);
+    p[1] = (uint8_t) value;
+}
+
+/** Get a pixel from a strip buffer as 0x00RRGGBB. */
+static inline uint32_t load_pixel(const uint8_t * p, const pixel_layout_s * layout) {
+    return ((uint32_t) p[layout->r] << 16) | ((uint32_t) p[layout->g] << 8) |
+            p[layout->b];
+}
+
+static inline void store_pixel(uint8_t * p, const pixel_layout_s * layout,
+                               uint32_t rgb) {
+    p[layout->r] = (uint8_t) (rgb >> 16);
+    p[layout->g] = (uint8_t) (rgb >> 8);
+    p[layout->b] = (uint8_t) rgb;
+}
+
+/** Convert 0x00RRGGBB to the wire value for the pixel format. */
+static inline uint32_t pack_pixel(uint32_t rgb, uint8_t format) {
+    if (format == LED_FRAME_RGB565) {
+        return ((rgb >> 8) & 0xf800) | ((rgb >> 5) & 0x07e0) | ((rgb >> 3) & 0x001f);
+    }
+    return rgb;
+}
+
+static inline void write_pixel(uint8_t * out, uint32_t value, int pixelSize) {
+    if (pixelSize == 3) {
+        out[0] = (uint8_t) (value >> 16);
+        out[1] = (uint8_t) (value >> 8);
+        out[2] = (uint8_t) value;
+    } else {
+        write_u16(out, (uint16_t) value);
+    }
+}
+
+static inline uint32_t read_value(const uint8_t * p, int pixelSize) {
+    if (pixelSize == 3) {
+        return ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+    }
+    return read_u16(p);
+}
+
+/** Convert the wire value for the pixel format to 0x00RRGGBB. */
+static inline uint32_t unpack_pixel(uint32_t value, uint8_t format) {
+    if (format == LED_FRAME_RGB565) {
+        // Replicate the upper bits so that full scale maps to 255
+        uint32_t r = (value >> 11) & 0x1f;
+        uint32_t g = (value >> 5) & 0x3f;
+        uint32_t b = value & 0x1f;
+        r = (r << 3) | (r >> 2);
+        g = (g << 2) | (g >> 4);
+        b = (b << 3) | (b >> 2);
+        return (r << 16) | (g << 8) | b;
+    }
+    return value;
+}
+
+/** Read a wire pixel as 0x00RRGGBB. */
+static inline uint32_t read_pixel(const uint8_t * p, uint8_t format) {
+    return unpack_pixel(read_value(p, (format == LED_FRAME_RGB565) ? 2 : 3), format);
+}
+
+/** XOR a wire value into a strip pixel. */
+static inline void xor_pixel(uint8_t * p, const pixel_layout_s * layout,
+                             uint8_t format, uint32_t value) {
+    uint32_t x = pack_pixel(load_pixel(p, layout), format) ^ value;
+    store_pixel(p, layout, unpack_pixel(x, format));
+}
+
+/** Swap the red, green and blue bytes of two strip pixels. */
+static inline void swap_pixel(uint8_t * a, uint8_t * b, const pixel_layout_s * layout) {
+    uint8_t t;
+    t = a[layout->r]; a[layout->r] = b[layout->r]; b[layout->r] = t;
+    t = a[layout->g]; a[layout->g] = b[layout->g]; b[layout->g] = t;
+    t = a[layout->b]; a[layout->b] = b[layout->b]; b[layout->b] = t;
+}
+
+/** Reverse the order of the pixels in [a, b), leaving any other bytes. */
+static void reverse_pixels(uint8_t * a, uint8_t * b, const pixel_layout_s * layout) {
+    b -= layout->stride;
+    while (a < b) {
+        swap_pixel(a, b, layout);
+        a += layout->stride;
+        b -= layout->stride;
+    }
+}
+
+/** Move pixel i to (i + shift) modulo count, in place. */
+static void rotate_pixels(uint8_t * p, int count, const pixel_layout_s * layout, int shift) {
+    if (count <= 1) {
+        return;
+    }
+    shift %= count;
+    if (shift < 0) {
+        shift += count;
+    }
+    if (shift) {
+        uint8_t * mid = p + shift * layout->stride;
+        uint8_t * end = p + count * layout->stride;
+        reverse_pixels(p, end, layout);
+        reverse_pixels(p, mid, layout);
+        reverse_pixels(mid, end, layout);
+    }
+}
+
+/** Get the wire value XOR between pixel i and its rotated previous pixel. */
+static inline uint32_t delta_pixel(const uint8_t * pixels, const uint8_t * previous,
+                                   int count, const pixel_layout_s * layout,
+                                   uint8_t format, int shift, int i) {
+    int k = i - shift;
+    if (k < 0) {
+        k += count;
+    } else if (k >= count) {
+        k -= count;
+    }
+    return pack_pixel(load_pixel(pixels + i * layout->stride, layout), format) ^
+            pack_pixel(load_pixel(previous + k * layout->stride, layout), format);
+}
+
+int led_frame_pixel_size(uint8_t format) {
+    switch (format) {
+        case LED_FRAME_RGB888: return 3;
+        case LED_FRAME_RGB565: return 2;
+        default: return 0;
+    }
+}
+
+bool led_frame_parse_header(const uint8_t * data, uint32_t length,
+                            LedFrameHeader * header) {
+    if ((length < LED_FRAME_HEADER_SIZE) || (data[0] != LED_FRAME_MAGIC)) {
+        return false;
+    }
+    header->format = data[1] >> 4;
+    header->encoding = data[1] & 0x0f;
+    header->device = data[2];
+    header->strip = data[3];
+    header->sequence = read_u16(data + 4);
+    header->start = read_u16(data + 6);
+    header->count = read_u16(data + 8);
+    return true;
+}
+
+LedFrameDecoder::LedFrameDecoder(uint8_t device, uint8_t strip)
+        : device_(device)
+        , strip_(strip)
+        , error_(ERROR_NONE)
+        , synced_(false)
+        , sequence_(0) {
+    memset(&header_, 0, sizeof(header_));
+}
+
+void LedFrameDecoder::reset() {
+    synced_ = false;
+}
+
+const LedFrameHeader & LedFrameDecoder::header() const {
+    return header_;
+}
+
+LedFrameDecoder::Error LedFrameDecoder::error() const {
+    return error_;
+}
+
+int LedFrameDecoder::fail(Error error) {
+    error_ = error;
+    synced_ = false;
+    return -1;
+}
+
+bool LedFrameDecoder::validateRle(const uint8_t * body, uint32_t length,
+                                  int pixelSize) const {
+    uint32_t idx = 0;
+    uint32_t pixels = 0;
+    while (idx < length) {
+        uint8_t c = body[idx++];
+        uint32_t n = (c & 0x7f) + 1;
+        uint32_t sz = (c & 0x80) ? pixelSize : n * pixelSize;
+        if (sz > length - idx) {
+            return false;
+        }
+        idx += sz;
+        pixels += n;
+        if (pixels > header_.count) {
+            return false;
+        }
+    }
+    return pixels == header_.count;
+}
+
+bool LedFrameDecoder::validateDelta(const uint8_t * body, uint32_t length,
+                                    int pixelSize) const {
+    uint32_t idx = 0;
+    uint32_t pixels = 0;
+    if (length && (body[0] == LED_FRAME_OP_ROTATE)) {
+        if (length < 3) {
+            return false;
+        }
+        idx = 3;
+    }
+    while (idx < length) {
+        uint8_t c = body[idx++];
+        uint32_t n = (c & 0x3f) + 1;
+        uint32_t sz;
+        switch (c & 0xc0) {
+            case LED_FRAME_OP_SKIP: sz = 0; break;
+            case LED_FRAME_OP_XOR: sz = n * pixelSize; break;
+            case LED_FRAME_OP_REPEAT: sz = pixelSize; break;
+            default: return false;  // rotate is only allowed first
+        }
+        if (sz > length - idx) {
+            return false;
+        }
+        idx += sz;
+        pixels += n;
+        if (pixels > header_.count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int LedFrameDecoder::decode(const uint8_t * data, uint32_t length,
+                            uint8_t * pixels, int count,
+                            const pixel_layout_s * layout) {
+    if (!led_frame_parse_header(data, length, &header_)) {
+        return fail(ERROR_HEADER);
+    }
+    if (((header_.device != LED_FRAME_ID_ALL) && (header_.device != device_)) ||
+            ((header_.strip != LED_FRAME_ID_ALL) && (header_.strip != strip_))) {
+        return 0;
+    }
+    int pixelSize = led_frame_pixel_size(header_.format);
+    if (!pixelSize) {
+        return fail(ERROR_FORMAT);
+    }
+    if ((int) header_.start + (int) header_.count > count) {
+        return fail(ERROR_RANGE);
+    }
+
+    const uint8_t * body = data + LED_FRAME_HEADER_SIZE;
+    uint32_t bodyLength = length - LED_FRAME_HEADER_SIZE;
+    uint8_t stride = layout->stride;
+    uint8_t * p = pixels + header_.start * stride;
+    uint8_t * p_end = p + header_.count * stride;
+
+    if (header_.encoding == LED_FRAME_RAW) {
+        if (bodyLength != (uint32_t) header_.count * pixelSize) {
+            return fail(ERROR_BODY);
+        }
+        if ((header_.format == LED_FRAME_RGB888) && (stride == 3) &&
+                (layout->r == 0) && (layout->g == 1) && (layout->b == 2)) {
+            memcpy(p, body, bodyLength);  // wire order matches the strip
+        } else {
+            for (; p < p_end; p += stride, body += pixelSize) {
+                store_pixel(p, layout, read_pixel(body, header_.format));
+            }
+        }
+    } else if (header_.encoding == LED_FRAME_RLE) {
+        if (!validateRle(body, bodyLength, pixelSize)) {
+            return fail(ERROR_BODY);
+        }
+        while (p < p_end) {
+            uint8_t c = *body++;
+            int n = (c & 0x7f) + 1;
+            if (c & 0x80) {
+                uint32_t rgb = read_pixel(body, header_.format);
+                body += pixelSize;
+                for (; n; --n, p += stride) {
+                    store_pixel(p, layout, rgb);
+                }
+            } else {
+                for (; n; --n, p += stride, body += pixelSize) {
+                    store_pixel(p, layout, read_pixel(body, header_.format));
+                }
+            }
+        }
+    } else if (header_.encoding == LED_FRAME_DELTA) {
+        if (!synced_ || (header_.sequence != (uint16_t) (sequence_ + 1))) {
+            return fail(ERROR_SEQUENCE);
+        }
+        if (!validateDelta(body, bodyLength, pixelSize)) {
+            return fail(ERROR_BODY);
+        }
+        const uint8_t * body_end = body + bodyLength;
+        if ((body < body_end) && (body[0] == LED_FRAME_OP_ROTATE)) {
+            rotate_pixels(p, header_.count, layout, (int16_t) read_u16(body + 1));
+            body += 3;
+        }
+        while (body < body_end) {
+            uint8_t c = *body++;
+            int n = (c & 0x3f) + 1;
+            if ((c & 0xc0) == LED_FRAME_OP_SKIP) {
+                p += n * stride;
+            } else if ((c & 0xc0) == LED_FRAME_OP_XOR) {
+                for (; n; --n, p += stride, body += pixelSize) {
+                    xor_pixel(p, layout, header_.format, read_value(body, pixelSize));
+                }
+            } else {
+                uint32_t x = read_value(body, pixelSize);
+                body += pixelSize;
+                for (; n; --n, p += stride) {
+                    xor_pixel(p, layout, header_.format, x);
+                }
+            }
+        }
+    } else {
+        return fail(ERROR_ENCODING);
+    }
+    error_ = ERROR_NONE;
+    synced_ = true;
+    sequence_ = header_.sequence;
+    return header_.count;
+}
+
+LedFrameEncoder::LedFrameEncoder(uint8_t device, uint8_t strip, uint8_t format)
+        : device_(device)
+        , strip_(strip)
+        , format_(format)
+        , sequence_(0) {
+}
+
+uint16_t LedFrameEncoder::sequence() const {
+    return sequence_;
+}
+
+int LedFrameEncoder::maxSize(int count) const {
+    // RLE frames never exceed the raw size
+    return LED_FRAME_HEADER_SIZE + count * led_frame_pixel_size(format_);
+}
+
+int LedFrameEncoder::encodeRle(const uint8_t * pixels, int count,
+                               const pixel_layout_s * layout,
+                               uint8_t * out, int size) const {
+    int pixelSize = led_frame_pixel_size(format_);
+    uint8_t stride = layout->stride;
+    int idx = 0;
+    int i = 0;
+    uint32_t value = count ? pack_pixel(load_pixel(pixels, layout), format_) : 0;
+
+    while (i < count) {
+        // Measure the run of identical pixels starting at i
+        int run = 1;
+        uint32_t next = value;
+        while ((i + run < count) && (run < LED_FRAME_RLE_MAX)) {
+            next = pack_pixel(load_pixel(pixels + (i + run) * stride, layout), format_);
+            if (next != value) {
+                break;
+            }
+            ++run;
+        }
+        if (run > 1) {
+            if (size - idx < 1 + pixelSize) {
+                return -1;
+            }
+            out[idx++] = (uint8_t) (0x80 | (run - 1));
+            write_pixel(out + idx, value, pixelSize);
+            idx += pixelSize;
+            i += run;
+            if (i < count) {
+                value = (next != value) ? next :
+                        pack_pixel(load_pixel(pixels + i * stride, layout), format_);
+            }
+            continue;
+        }
+
+        // Emit literals until the next run of 2 or more pixels
+        int ctrl = idx++;
+        int n = 0;
+        while ((i < count) && (n < LED_FRAME_RLE_MAX)) {
+            next = (i + 1 < count) ?
+                    pack_pixel(load_pixel(pixels + (i + 1) * stride, layout), format_) :
+                    ~value;
+            if ((n > 0) && (next == value)) {
+                break;  // a run starts at i
+            }
+            if (size - idx < pixelSize) {
+                return -1;
+            }
+            write_pixel(out + idx, value, pixelSize);
+            idx += pixelSize;
+            ++n;
+            ++i;
+            value = next;
+        }
+        out[ctrl] = (uint8_t) (n - 1);
+    }
+    return idx;
+}
+
+int LedFrameEncoder::encode(const uint8_t * pixels, int count,
+                            const pixel_layout_s * layout, uint8_t * out,
+                            int size, uint8_t encoding, uint16_t start) {
+    int pixelSize = led_frame_pixel_size(format_);
+    if (!pixelSize || (count < 0) || (count > 0xffff) ||
+            (size < LED_FRAME_HEADER_SIZE)) {
+        return -1;
+    }
+    uint8_t * body = out + LED_FRAME_HEADER_SIZE;
+    int bodySize = size - LED_FRAME_HEADER_SIZE;
+    int rawLength = count * pixelSize;
+    int bodyLength = -1;
+
+    if ((encoding == LED_FRAME_RLE) && count) {
+        // Only keep the RLE body if it is smaller than the raw pixels
+        int limit = (bodySize < rawLength) ? bodySize : rawLength - 1;
+        bodyLength = encodeRle(pixels, count, layout, body, limit);
+    }
+    if (bodyLength < 0) {
+        if (bodySize < rawLength) {
+            return -1;
+        }
+        encoding = LED_FRAME_RAW;
+        uint8_t stride = layout->stride;
+        for (int i = 0; i < count; ++i) {
+            write_pixel(body + i * pixelSize,
+                        pack_pixel(load_pixel(pixels + i * stride, layout), format_),
+                        pixelSize);
+        }
+        bodyLength = rawLength;
+    }
+
+    return writeHeader(out, encoding, start, count, bodyLength);
+}
+
+int LedFrameEncoder::writeHeader(uint8_t * out, uint8_t encoding,
+                                 uint16_t start, int count, int bodyLength) {
+    out[0] = LED_FRAME_MAGIC;
+    out[1] = (uint8_t) ((format_ << 4) | encoding);
+    out[2] = device_;
+    out[3] = strip_;
+    write_u16(out + 4, sequence_++);
+    write_u16(out + 6, start);
+    write_u16(out + 8, (uint16_t) count);
+    return LED_FRAME_HEADER_SIZE + bodyLength;
+}
+
+int LedFrameEncoder::bestShift(const uint8_t * pixels, const uint8_t * previous,
+                               int count, const pixel_layout_s * layout,
+                               int maxShift) const {
+    if (maxShift >= count) {
+        maxShift = count - 1;
+    }
+    int best = 0;
+    int bestScore = -1;
+    // Try 0, 1, -1, 2, -2, ... so that ties favor the smallest shift
+    for (int k = 0; k <= 2 * maxShift; ++k) {
+        int shift = (k & 1) ? (k + 1) / 2 : -(k / 2);
+        int score = 0;
+        for (int i = 0; i < count; ++i) {
+            if (!delta_pixel(pixels, previous, count, layout, format_, shift, i)) {
+                ++score;
+            }
+        }
+        if (score > bestScore) {
+            best = shift;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+int LedFrameEncoder::encodeDeltaBody(const uint8_t * pixels, const uint8_t * previous,
+                                     int count, const pixel_layout_s * layout,
+                                     int shift, uint8_t * out, int size) const {
+    int pixelSize = led_frame_pixel_size(format_);
+    int idx = 0;
+    int i = 0;
+
+    if (shift) {
+        if (size < 3) {
+            return -1;
+        }
+        out[idx++] = LED_FRAME_OP_ROTATE;
+        write_u16(out + idx, (uint16_t) shift);
+        idx += 2;
+    }
+
+    while (i < count) {
+        uint32_t x = delta_pixel(pixels, previous, count, layout, format_, shift, i);
+        int n = 1;
+        while ((i + n < count) && (n < LED_FRAME_DELTA_MAX) &&
+               (delta_pixel(pixels, previous, count, layout, format_, shift, i + n) == x)) {
+            ++n;
+        }
+        if (!x) {
+            if (i + n >= count) {
+                break;  // trailing pixels are unchanged
+            }
+            if (size - idx < 1) {
+                return -1;
+            }
+            out[idx++] = (uint8_t) (LED_FRAME_OP_SKIP | (n - 1));
+            i += n;
+        } else if (n > 1) {
+            if (size - idx < 1 + pixelSize) {
+                return -1;
+            }
+            out[idx++] = (uint8_t) (LED_FRAME_OP_REPEAT | (n - 1));
+            write_pixel(out + idx, x, pixelSize);
+            idx += pixelSize;
+            i += n;
+        } else {
+            // Emit literals until an unchanged pixel or a repeated value
+            int ctrl = idx++;
+            n = 0;
+            while ((i < count) && (n < LED_FRAME_DELTA_MAX)) {
+                x = delta_pixel(pixels, previous, count, layout, format_, shift, i);
+                if ((n > 0) && (!x || ((i + 1 < count) &&
+                        (delta_pixel(pixels, previous, count, layout, format_, shift, i + 1) == x)))) {
+                    break;
+                }
+                if (size - idx < pixelSize) {
+                    return -1;
+                }
+                write_pixel(out + idx, x, pixelSize);
+                idx += pixelSize;
+                ++n;
+                ++i;
+            }
+            out[ctrl] = (uint8_t) (LED_FRAME_OP_XOR | (n - 1));
+        }
+    }
+    return idx;
+}
+
+int LedFrameEncoder::encodeDelta(const uint8_t * pixels, const uint8_t * previous,
+                                 int count, const pixel_layout_s * layout,
+                                 uint8_t * out, int size, uint16_t start,
+                                 int maxShift) {
+    int pixelSize = led_frame_pixel_size(format_);
+    if (!pixelSize || (count < 0) || (count > 0xffff) ||
+            (size < LED_FRAME_HEADER_SIZE)) {
+        return -1;
+    }
+    if (previous && count) {
+        // Only keep the delta body if it is smaller than the raw pixels
+        int bodySize = size - LED_FRAME_HEADER_SIZE;
+        int rawLength = count * pixelSize;
+        int limit = (bodySize < rawLength) ? bodySize : rawLength - 1;
+        int shift = bestShift(pixels, previous, count, layout, maxShift);
+        int bodyLength = encodeDeltaBody(pixels, previous, count, layout, shift,
+                                         out + LED_FRAME_HEADER_SIZE, limit);
+        if (bodyLength >= 0) {
+            return writeHeader(out, LED_FRAME_DELTA, start, count, bodyLength);
+        }
+    }
+    return encode(pixels, count, layout, out, size, LED_FRAME_RLE, start);
+}
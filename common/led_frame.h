@@ -0,0 +1,270 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Compact binary LED frame format.
+ *
+ * LED frames are sent as WebSocket binary messages so that the server can
+ * stream arbitrary animations rather than selecting a mode that each
+ * device renders locally.  A frame consists of a 10-byte header followed
+ * by the body:
+ *
+ *   offset  size  field
+ *   0       1     LED_FRAME_MAGIC ('L')
+ *   1       1     pixel format (upper nibble) | encoding (lower nibble)
+ *   2       1     device ID, or LED_FRAME_ID_ALL
+ *   3       1     strip ID, or LED_FRAME_ID_ALL
+ *   4       2     sequence number, big-endian
+ *   6       2     first pixel, big-endian
+ *   8       2     pixel count, big-endian
+ *
+ * The body holds count pixels in the pixel format:
+ *   - LED_FRAME_RAW: the pixels, unencoded.
+ *   - LED_FRAME_RLE: a series of packets, each starting with a control
+ *     byte c.  If c & 0x80, the next pixel repeats (c & 0x7f) + 1 times.
+ *     Otherwise, c + 1 literal pixels follow.
+ *   - LED_FRAME_DELTA: patches against the previous frame with the
+ *     preceding sequence number, which must already be in the strip
+ *     buffer.  The body is a series of ops, each starting with a control
+ *     byte c with n = (c & 0x3f) + 1:
+ *       - LED_FRAME_OP_SKIP: leave the next n pixels unchanged.
+ *       - LED_FRAME_OP_XOR: n pixel values follow which are XORed into
+ *         the next n pixels.
+ *       - LED_FRAME_OP_REPEAT: one pixel value follows which is XORed
+ *         into each of the next n pixels.
+ *       - LED_FRAME_OP_ROTATE: only allowed as the first op.  A signed,
+ *         big-endian 16-bit shift follows.  Pixel i of the frame is first
+ *         replaced by pixel (i - shift) modulo count, which turns
+ *         scrolling patterns into mostly skipped pixels.
+ *     Pixels after the last op are unchanged.  XOR is applied to the
+ *     pixel values in the frame's pixel format.
+ *
+ * Pixels are decoded directly into the strip buffer of an APA102 or
+ * Adafruit_NeoPixel using its pixel_layout_s, so no intermediate copy of
+ * the frame is made.
+ */
+
+#ifndef LED_FRAME_H
+#define LED_FRAME_H
+
+#include <stdint.h>
+#include "hsv.h"
+
+#define LED_FRAME_MAGIC        0x4C
+#define LED_FRAME_HEADER_SIZE  10
+
+/** The device or strip ID that addresses every device or strip. */
+#define LED_FRAME_ID_ALL       0xFF
+
+// Pixel formats
+#define LED_FRAME_RGB888       0x0  // red, green, blue: 3 bytes per pixel
+#define LED_FRAME_RGB565       0x1  // 5-6-5 bits, big-endian: 2 bytes per pixel
+
+// Encodings
+#define LED_FRAME_RAW          0x0
+#define LED_FRAME_RLE          0x1
+#define LED_FRAME_DELTA        0x2
+
+// LED_FRAME_DELTA ops
+#define LED_FRAME_OP_SKIP      0x00
+#define LED_FRAME_OP_XOR       0x40
+#define LED_FRAME_OP_REPEAT    0x80
+#define LED_FRAME_OP_ROTATE    0xC0
+
+/** The maximum number of pixels in a single RLE packet. */
+#define LED_FRAME_RLE_MAX      128
+
+/** The maximum number of pixels in a single LED_FRAME_DELTA op. */
+#define LED_FRAME_DELTA_MAX    64
+
+/** The default rotation search range for LedFrameEncoder::encodeDelta(). */
+#define LED_FRAME_DELTA_SHIFT  4
+
+/** The decoded LED frame header. */
+struct LedFrameHeader {
+    uint8_t format;     // The pixel format, LED_FRAME_RGB888 or LED_FRAME_RGB565
+    uint8_t encoding;   // The body encoding, LED_FRAME_RAW, _RLE or _DELTA
+    uint8_t device;     // The destination device ID
+    uint8_t strip;      // The destination strip ID
+    uint16_t sequence;  // The frame sequence number
+    uint16_t start;     // The first pixel
+    uint16_t count;     // The number of pixels
+};
+
+/** Get the number of bytes per pixel.
+ *
+ * @param format The pixel format.
+ * @return The bytes per pixel or 0 for an unknown format.
+ */
+int led_frame_pixel_size(uint8_t format);
+
+/** Parse an LED frame header.
+ *
+ * @param data The received message.
+ * @param length The number of bytes in data.
+ * @param header The header which is filled in on success.
+ * @return True if data starts with a valid header, otherwise false.
+ */
+bool led_frame_parse_header(const uint8_t * data, uint32_t length,
+                            LedFrameHeader * header);
+
+class LedFrameDecoder {
+public:
+    enum Error {
+        ERROR_NONE = 0,
+        ERROR_HEADER = 1,    // Truncated header or bad magic
+        ERROR_FORMAT = 2,    // Unknown pixel format
+        ERROR_ENCODING = 3,  // Unknown encoding
+        ERROR_RANGE = 4,     // Pixels outside the strip
+        ERROR_BODY = 5,      // Body does not hold exactly count pixels
+        ERROR_SEQUENCE = 6   // Delta frame without its previous frame
+    };
+
+    /** Construct a new instance.
+     *
+     * @param device This device's ID.
+     * @param strip The ID of the strip decoded by this instance.
+     */
+    LedFrameDecoder(uint8_t device, uint8_t strip);
+
+    /** Discard the previous frame so that delta frames are rejected until
+     * the next RAW or RLE frame, such as after reconnecting.
+     */
+    void reset();
+
+    /** Decode a frame into a strip buffer.
+     *
+     * The frame is fully validated before any pixel is written, so the
+     * strip buffer is unmodified on error.  Only the red, green and blue
+     * bytes of each pixel are written, which leaves the APA102 global
+     * brightness byte intact.
+     *
+     * LED_FRAME_DELTA frames are applied in place, so the strip buffer
+     * must still hold the previously decoded frame.  With a double
+     * buffered APA102, the back buffer holds the frame before that one
+     * after swap(), so decode each frame into both buffers or use a
+     * single buffer.  Any error, including a gap in the sequence
+     * numbers, rejects delta frames until the next RAW or RLE frame.
+     *
+     * @param data The received message.
+     * @param length The number of bytes in data.
+     * @param pixels The strip buffer, such as APA102::getPixels() or
+     *      Adafruit_NeoPixel::getPixels().
+     * @param count The number of pixels in the strip buffer.
+     * @param layout The byte layout of each pixel in the strip buffer.
+     * @return The number of pixels written, 0 if the frame is addressed
+     *      to a different device or strip, or -1 on error.
+     */
+    int decode(const uint8_t * data, uint32_t length, uint8_t * pixels,
+               int count, const pixel_layout_s * layout);
+
+    /** Get the header of the most recently decoded frame.
+     *
+     * @return The header.
+     */
+    const LedFrameHeader & header() const;
+
+    /** Get the most recent error.
+     *
+     * @return The error code.
+     */
+    Error error() const;
+
+private:
+    int fail(Error error);
+    bool validateRle(const uint8_t * body, uint32_t length, int pixelSize) const;
+    bool validateDelta(const uint8_t * body, uint32_t length, int pixelSize) const;
+
+    uint8_t device_;
+    uint8_t strip_;
+    LedFrameHeader header_;
+    Error error_;
+    bool synced_;        // True if the strip holds frame sequence_
+    uint16_t sequence_;  // The sequence number of the last decoded frame
+};
+
+class LedFrameEncoder {
+public:
+    /** Construct a new instance.
+     *
+     * @param device The destination device ID.
+     * @param strip The destination strip ID.
+     * @param format The pixel format.
+     */
+    LedFrameEncoder(uint8_t device, uint8_t strip,
+                    uint8_t format = LED_FRAME_RGB888);
+
+    /** Get the worst case encoded size.
+     *
+     * @param count The number of pixels.
+     * @return The maximum number of bytes produced by encode().
+     */
+    int maxSize(int count) const;
+
+    /** Encode pixels from a strip buffer.
+     *
+     * RLE frames which would be larger than the raw pixels are sent as
+     * LED_FRAME_RAW instead.  The sequence number increments with each
+     * encoded frame.
+     *
+     * @param pixels The first pixel to encode in the strip buffer.
+     * @param count The number of pixels to encode.
+     * @param layout The byte layout of each pixel in the strip buffer.
+     * @param out The output buffer.
+     * @param size The size of out in bytes.
+     * @param encoding The body encoding, LED_FRAME_RAW or LED_FRAME_RLE.
+     * @param start The first pixel number stored in the header.
+     * @return The frame length in bytes or -1 if out is too small.
+     */
+    int encode(const uint8_t * pixels, int count,
+               const pixel_layout_s * layout, uint8_t * out, int size,
+               uint8_t encoding = LED_FRAME_RLE, uint16_t start = 0);
+
+    /** Encode pixels as a delta against the previous frame.
+     *
+     * The rotation within maxShift pixels that leaves the most pixels
+     * unchanged is applied before the XOR patches.  If the delta would be
+     * larger than the raw pixels, or previous is NULL, the frame is
+     * encoded with LED_FRAME_RLE instead.  Pass NULL as previous to force
+     * a keyframe, such as when a device connects.
+     *
+     * @param pixels The first pixel to encode in the strip buffer.
+     * @param previous The first pixel of the previously encoded frame in
+     *      a strip buffer with the same layout, or NULL.
+     * @param count The number of pixels to encode.
+     * @param layout The byte layout of each pixel in both strip buffers.
+     * @param out The output buffer.
+     * @param size The size of out in bytes.
+     * @param start The first pixel number stored in the header.
+     * @param maxShift The maximum rotation to consider in pixels.
+     * @return The frame length in bytes or -1 if out is too small.
+     */
+    int encodeDelta(const uint8_t * pixels, const uint8_t * previous,
+                    int count, const pixel_layout_s * layout, uint8_t * out,
+                    int size, uint16_t start = 0,
+                    int maxShift = LED_FRAME_DELTA_SHIFT);
+
+    /** Get the sequence number of the next frame.
+     *
+     * @return The sequence number.
+     */
+    uint16_t sequence() const;
+
+private:
+    int encodeRle(const uint8_t * pixels, int count,
+                  const pixel_layout_s * layout, uint8_t * out, int size) const;
+    int bestShift(const uint8_t * pixels, const uint8_t * previous, int count,
+                  const pixel_layout_s * layout, int maxShift) const;
+    int encodeDeltaBody(const uint8_t * pixels, const uint8_t * previous,
+                        int count, const pixel_layout_s * layout, int shift,
+                        uint8_t * out, int size) const;
+    int writeHeader(uint8_t * out, uint8_t encoding, uint16_t start,
+                    int count, int bodyLength);
+
+    uint8_t device_;
+    uint8_t strip_;
+    uint8_t format_;
+    uint16_t sequence_;
+};
+
+#endif /* LED_FRAME_H */
@@ -0,0 +1,79 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Reconnect scheduling with jittered exponential backoff.
+ *
+ * When the server restarts, every device loses its connection at the
+ * same time.  Retrying at fixed intervals keeps the devices in lock-step
+ * so that they all hit the server together.  This scheduler uses "full
+ * jitter": after the nth consecutive failure, the next attempt occurs
+ * after a uniformly random delay from 0 to min(maxMs, baseMs * 2^n).
+ * Seed each device differently, such as from its MAC address, so that
+ * the delays differ between devices.
+ *
+ * The scheduler does not read a clock.  The caller passes the current
+ * time in milliseconds, which may wrap around.
+ */
+
+#ifndef RECONNECT_H
+#define RECONNECT_H
+
+#include <stdint.h>
+
+class ReconnectScheduler {
+public:
+    /** Construct a new instance.
+     *
+     * @param baseMs The maximum delay after the first failure.
+     * @param maxMs The upper limit for the maximum delay.
+     * @param seed The random seed, which should differ between devices.
+     */
+    ReconnectScheduler(uint32_t baseMs = 500, uint32_t maxMs = 60000,
+                       uint32_t seed = 1);
+
+    /** Change the random seed.
+     *
+     * @param seed The new seed.  Zero is replaced with a fixed value.
+     */
+    void seed(uint32_t seed);
+
+    /** Indicate a successful connection.
+     *
+     * The failure count is cleared and the next attempt is allowed
+     * immediately.
+     */
+    void reset();
+
+    /** Indicate a failed attempt or a lost connection.
+     *
+     * @param nowMs The current time in milliseconds.
+     * @return The delay until the next attempt in milliseconds.
+     */
+    uint32_t failed(uint32_t nowMs);
+
+    /** Check if the next attempt is due.
+     *
+     * @param nowMs The current time in milliseconds.
+     * @return True if a connection attempt should be made.
+     */
+    bool ready(uint32_t nowMs) const;
+
+    /** Get the number of consecutive failures.
+     *
+     * @return The failures since the last reset().
+     */
+    uint32_t failures() const;
+
+private:
+    uint32_t random();
+
+    uint32_t baseMs_;
+    uint32_t maxMs_;
+    uint32_t state_;     // The xorshift32 random number generator state
+    uint32_t failures_;
+    uint32_t nextMs_;    // The time of the next attempt
+    bool waiting_;       // True if nextMs_ is valid
+};
+
+#endif /* RECONNECT_H */
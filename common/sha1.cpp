@@ -0,0 +1,203 @@
+#include <string.h>
+//#include <avr/io.h>
+//#include <avr/pgmspace.h>
+#include "sha1.h"
+
+#define SHA1_K0 0x5a827999
+#define SHA1_K20 0x6ed9eba1
+#define SHA1_K40 0x8f1bbcdc
+#define SHA1_K60 0xca62c1d6
+
+static const uint32_t sha1InitState[] = {
+  0x67452301, // H0
+  0xefcdab89, // H1
+  0x98badcfe, // H2
+  0x10325476, // H3
+  0xc3d2e1f0  // H4
+};
+
+static inline uint32_t rol32(uint32_t number, uint8_t bits) {
+  return ((number << bits) | (number >> (32-bits)));
+}
+
+static inline uint32_t load_be32(const uint8_t* p) {
+  return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static inline void store_be32(uint8_t* p, uint32_t x) {
+  p[0] = x >> 24;
+  p[1] = x >> 16;
+  p[2] = x >> 8;
+  p[3] = x;
+}
+
+void Sha1Class::init(void) {
+  memcpy(state.w,sha1InitState,HASH_LENGTH);
+  byteCount = 0;
+  bufferOffset = 0;
+}
+
+// The message schedule uses a rolling 16 word window
+#define SHA1_W(i) (w[(i)&15] = rol32(w[((i)+13)&15] ^ w[((i)+8)&15] ^ w[((i)+2)&15] ^ w[(i)&15], 1))
+
+// Each round updates e and b in place.  The caller rotates the variable
+// names rather than moving values between them.
+#define SHA1_R0(a,b,c,d,e,i) e += rol32(a,5) + (d ^ (b & (c ^ d))) + SHA1_K0 + w[i]; b = rol32(b,30);
+#define SHA1_R1(a,b,c,d,e,i) e += rol32(a,5) + (d ^ (b & (c ^ d))) + SHA1_K0 + SHA1_W(i); b = rol32(b,30);
+#define SHA1_R2(a,b,c,d,e,i) e += rol32(a,5) + (b ^ c ^ d) + SHA1_K20 + SHA1_W(i); b = rol32(b,30);
+#define SHA1_R3(a,b,c,d,e,i) e += rol32(a,5) + ((b & c) | (d & (b | c))) + SHA1_K40 + SHA1_W(i); b = rol32(b,30);
+#define SHA1_R4(a,b,c,d,e,i) e += rol32(a,5) + (b ^ c ^ d) + SHA1_K60 + SHA1_W(i); b = rol32(b,30);
+
+void Sha1Class::hashBlock(const uint8_t* block) {
+  uint32_t w[16];
+  uint32_t a,b,c,d,e;
+
+  for (uint8_t i=0; i<16; i++) {
+    w[i] = load_be32(block + 4*i);
+  }
+  a=state.w[0];
+  b=state.w[1];
+  c=state.w[2];
+  d=state.w[3];
+  e=state.w[4];
+  SHA1_R0(a, b, c, d, e, 0); SHA1_R0(e, a, b, c, d, 1); SHA1_R0(d, e, a, b, c, 2); SHA1_R0(c, d, e, a, b, 3); SHA1_R0(b, c, d, e, a, 4);
+  SHA1_R0(a, b, c, d, e, 5); SHA1_R0(e, a, b, c, d, 6); SHA1_R0(d, e, a, b, c, 7); SHA1_R0(c, d, e, a, b, 8); SHA1_R0(b, c, d, e, a, 9);
+  SHA1_R0(a, b, c, d, e, 10); SHA1_R0(e, a, b, c, d, 11); SHA1_R0(d, e, a, b, c, 12); SHA1_R0(c, d, e, a, b, 13); SHA1_R0(b, c, d, e, a, 14);
+  SHA1_R0(a, b, c, d, e, 15); SHA1_R1(e, a, b, c, d, 16); SHA1_R1(d, e, a, b, c, 17); SHA1_R1(c, d, e, a, b, 18); SHA1_R1(b, c, d, e, a, 19);
+  SHA1_R2(a, b, c, d, e, 20); SHA1_R2(e, a, b, c, d, 21); SHA1_R2(d, e, a, b, c, 22); SHA1_R2(c, d, e, a, b, 23); SHA1_R2(b, c, d, e, a, 24);
+  SHA1_R2(a, b, c, d, e, 25); SHA1_R2(e, a, b, c, d, 26); SHA1_R2(d, e, a, b, c, 27); SHA1_R2(c, d, e, a, b, 28); SHA1_R2(b, c, d, e, a, 29);
+  SHA1_R2(a, b, c, d, e, 30); SHA1_R2(e, a, b, c, d, 31); SHA1_R2(d, e, a, b, c, 32); SHA1_R2(c, d, e, a, b, 33); SHA1_R2(b, c, d, e, a, 34);
+  SHA1_R2(a, b, c, d, e, 35); SHA1_R2(e, a, b, c, d, 36); SHA1_R2(d, e, a, b, c, 37); SHA1_R2(c, d, e, a, b, 38); SHA1_R2(b, c, d, e, a, 39);
+  SHA1_R3(a, b, c, d, e, 40); SHA1_R3(e, a, b, c, d, 41); SHA1_R3(d, e, a, b, c, 42); SHA1_R3(c, d, e, a, b, 43); SHA1_R3(b, c, d, e, a, 44);
+  SHA1_R3(a, b, c, d, e, 45); SHA1_R3(e, a, b, c, d, 46); SHA1_R3(d, e, a, b, c, 47); SHA1_R3(c, d, e, a, b, 48); SHA1_R3(b, c, d, e, a, 49);
+  SHA1_R3(a, b, c, d, e, 50); SHA1_R3(e, a, b, c, d, 51); SHA1_R3(d, e, a, b, c, 52); SHA1_R3(c, d, e, a, b, 53); SHA1_R3(b, c, d, e, a, 54);
+  SHA1_R3(a, b, c, d, e, 55); SHA1_R3(e, a, b, c, d, 56); SHA1_R3(d, e, a, b, c, 57); SHA1_R3(c, d, e, a, b, 58); SHA1_R3(b, c, d, e, a, 59);
+  SHA1_R4(a, b, c, d, e, 60); SHA1_R4(e, a, b, c, d, 61); SHA1_R4(d, e, a, b, c, 62); SHA1_R4(c, d, e, a, b, 63); SHA1_R4(b, c, d, e, a, 64);
+  SHA1_R4(a, b, c, d, e, 65); SHA1_R4(e, a, b, c, d, 66); SHA1_R4(d, e, a, b, c, 67); SHA1_R4(c, d, e, a, b, 68); SHA1_R4(b, c, d, e, a, 69);
+  SHA1_R4(a, b, c, d, e, 70); SHA1_R4(e, a, b, c, d, 71); SHA1_R4(d, e, a, b, c, 72); SHA1_R4(c, d, e, a, b, 73); SHA1_R4(b, c, d, e, a, 74);
+  SHA1_R4(a, b, c, d, e, 75); SHA1_R4(e, a, b, c, d, 76); SHA1_R4(d, e, a, b, c, 77); SHA1_R4(c, d, e, a, b, 78); SHA1_R4(b, c, d, e, a, 79);
+  state.w[0] += a;
+  state.w[1] += b;
+  state.w[2] += c;
+  state.w[3] += d;
+  state.w[4] += e;
+}
+
+void Sha1Class::update(const void* data, size_t length) {
+  const uint8_t* p = (const uint8_t*) data;
+  byteCount += length;
+
+  // Complete a partially filled block
+  if (bufferOffset) {
+    size_t n = BLOCK_LENGTH - bufferOffset;
+    if (n > length) {
+      n = length;
+    }
+    memcpy(buffer.b + bufferOffset, p, n);
+    bufferOffset += n;
+    p += n;
+    length -= n;
+    if (bufferOffset < BLOCK_LENGTH) {
+      return;
+    }
+    hashBlock(buffer.b);
+    bufferOffset = 0;
+  }
+
+  // Hash whole blocks straight from the input
+  for (; length >= BLOCK_LENGTH; p += BLOCK_LENGTH, length -= BLOCK_LENGTH) {
+    hashBlock(p);
+  }
+  memcpy(buffer.b, p, length);
+  bufferOffset = length;
+}
+
+size_t Sha1Class::write(uint8_t data) {
+  update(&data, 1);
+  return 1;
+}
+
+size_t Sha1Class::write(const uint8_t* buffer, size_t size) {
+  update(buffer, size);
+  return size;
+}
+
+#ifndef ARDUINO
+size_t Sha1Class::print(const char* str) {
+  return write((const uint8_t*) str, strlen(str));
+}
+#endif
+
+void Sha1Class::pad() {
+  // Implement SHA-1 padding (fips180-2 §5.1.1)
+
+  // Pad with 0x80 followed by 0x00 until the end of the block
+  buffer.b[bufferOffset++] = 0x80;
+  if (bufferOffset > BLOCK_LENGTH - 8) {
+    memset(buffer.b + bufferOffset, 0, BLOCK_LENGTH - bufferOffset);
+    hashBlock(buffer.b);
+    bufferOffset = 0;
+  }
+  memset(buffer.b + bufferOffset, 0, BLOCK_LENGTH - 8 - bufferOffset);
+
+  // Append the length in bits in the last 8 bytes.  We're only using
+  // 32 bit byte counts, but SHA-1 supports 64 bit bit counts.
+  store_be32(buffer.b + BLOCK_LENGTH - 8, byteCount >> 29);
+  store_be32(buffer.b + BLOCK_LENGTH - 4, byteCount << 3);
+  hashBlock(buffer.b);
+  bufferOffset = 0;
+}
+
+
+uint8_t* Sha1Class::result(void) {
+  // Pad to complete the last block
+  pad();
+  
+  // Store the hash in big endian byte order
+  uint32_t h[HASH_LENGTH/4];
+  memcpy(h, state.w, HASH_LENGTH);
+  for (int i=0; i<5; i++) {
+    store_be32(state.b + 4*i, h[i]);
+  }
+  
+  // Return pointer to hash (20 characters)
+  return state.b;
+}
+
+#define HMAC_IPAD 0x36
+#define HMAC_OPAD 0x5c
+
+void Sha1Class::initHmac(const uint8_t* key, int keyLength) {
+  uint8_t i;
+  uint8_t pad[BLOCK_LENGTH];
+  memset(keyBuffer,0,BLOCK_LENGTH);
+  if (keyLength > BLOCK_LENGTH) {
+    // Hash long keys
+    init();
+    update(key, keyLength);
+    memcpy(keyBuffer,result(),HASH_LENGTH);
+  } else {
+    // Block length keys are used as is
+    memcpy(keyBuffer,key,keyLength);
+  }
+  // Start inner hash
+  init();
+  for (i=0; i<BLOCK_LENGTH; i++) {
+    pad[i] = keyBuffer[i] ^ HMAC_IPAD;
+  }
+  update(pad, BLOCK_LENGTH);
+}
+
+uint8_t* Sha1Class::resultHmac(void) {
+  uint8_t i;
+  uint8_t pad[BLOCK_LENGTH];
+  // Complete inner hash
+  memcpy(innerHash,result(),HASH_LENGTH);
+  // Calculate outer hash
+  init();
+  for (i=0; i<BLOCK_LENGTH; i++) pad[i] = keyBuffer[i] ^ HMAC_OPAD;
+  update(pad, BLOCK_LENGTH);
+  update(innerHash, HASH_LENGTH);
+  return result();
+}
+Sha1Class Sha1;
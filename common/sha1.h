@@ -0,0 +1,61 @@
+#ifndef Sha1_h
+#define Sha1_h
+
+#include <inttypes.h>
+#include <stddef.h>
+#ifdef ARDUINO
+#include "Print.h"
+#endif
+
+#define HASH_LENGTH 20
+#define BLOCK_LENGTH 64
+
+union _buffer {
+  uint8_t b[BLOCK_LENGTH];
+  uint32_t w[BLOCK_LENGTH/4];
+};
+union _state {
+  uint8_t b[HASH_LENGTH];
+  uint32_t w[HASH_LENGTH/4];
+};
+
+/**
+ * SHA-1 message digest (FIPS 180-4).
+ *
+ * Feed data with update(), which hashes whole 64-byte blocks directly
+ * from the input.  The Print interface remains for compatibility and
+ * forwards to update().
+ */
+class Sha1Class
+#ifdef ARDUINO
+  : public Print
+#endif
+{
+  public:
+    void init(void);
+    void update(const void* data, size_t length);
+    void initHmac(const uint8_t* secret, int secretLength);
+    uint8_t* result(void);
+    uint8_t* resultHmac(void);
+    virtual size_t write(uint8_t);
+#ifdef ARDUINO
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+#else
+    size_t write(const uint8_t* buffer, size_t size);
+    size_t print(const char* str);
+#endif
+  private:
+    void pad();
+    void hashBlock(const uint8_t* block);
+    _buffer buffer;
+    uint8_t bufferOffset;
+    _state state;
+    uint32_t byteCount;
+    uint8_t keyBuffer[BLOCK_LENGTH];
+    uint8_t innerHash[HASH_LENGTH];
+    
+};
+extern Sha1Class Sha1;
+
+#endif
@@ -0,0 +1,210 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Lock-free single-producer, single-consumer ring buffer.
+ *
+ * One thread (or interrupt) pushes fixed-size records while another
+ * thread pops them, without locks and without disabling interrupts.
+ * Each index is written by only one side.  The producer publishes a
+ * record by storing the head index with release semantics after writing
+ * the record, and the consumer loads the head with acquire semantics
+ * before reading it.  The same applies to the tail in the other
+ * direction.  Each side also keeps a cached copy of the other side's
+ * index so that it only reads the shared index when the ring appears
+ * full or empty.
+ *
+ * Records can be copied in and out with push() and pop(), or accessed in
+ * place with the zero-copy write()/commit() and drain() functions.
+ * drain() processes every available record and releases them together
+ * with a single index update.
+ *
+ * Example:
+ * @code
+ * SpscRing<Command, 16> ring;
+ *
+ * // producer
+ * Command * cmd = ring.write();
+ * if (cmd) {
+ *     cmd->type = CMD_MODE;
+ *     ring.commit();
+ * }
+ *
+ * // consumer
+ * ring.drain(handle_command);
+ * @endcode
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** The padding between the producer and consumer indices in bytes. */
+#ifndef SPSC_RING_CACHE_LINE
+#define SPSC_RING_CACHE_LINE 64
+#endif
+
+#if defined(__ARMCC_VERSION) && (__ARMCC_VERSION < 6000000)
+// ARM Compiler 5: the DMB orders the record accesses against the index
+#define SPSC_RING_LOAD_ACQUIRE(x) spsc_ring_load_acquire(&(x))
+#define SPSC_RING_STORE_RELEASE(x, v) do { __dmb(0xF); (x) = (v); } while (0)
+static inline uint32_t spsc_ring_load_acquire(const volatile uint32_t * x) {
+    uint32_t v = *x;
+    __dmb(0xF);
+    return v;
+}
+#else
+#define SPSC_RING_LOAD_ACQUIRE(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define SPSC_RING_STORE_RELEASE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#endif
+
+/** The ring buffer.
+ *
+ * @param T The record type, which must be copyable with operator=.
+ * @param N The capacity in records, which must be a power of two.
+ */
+template <typename T, uint32_t N>
+class SpscRing {
+public:
+    /** Construct a new, empty instance. */
+    SpscRing() : head_(0), tailCache_(0), tail_(0), headCache_(0) {
+        // Fails to compile if N is not a power of two
+        typedef char N_must_be_a_power_of_two[((N & (N - 1)) == 0 && N) ? 1 : -1];
+        (void) sizeof(N_must_be_a_power_of_two);
+    }
+
+    /** Get the capacity.
+     *
+     * @return The maximum number of records.
+     */
+    uint32_t capacity() const {
+        return N;
+    }
+
+    /** Get the number of records.
+     *
+     * The result is approximate while the other side is active.
+     *
+     * @return The number of records in the ring.
+     */
+    uint32_t size() const {
+        return SPSC_RING_LOAD_ACQUIRE(head_) - SPSC_RING_LOAD_ACQUIRE(tail_);
+    }
+
+    /** Get the next record to write.  Producer only.
+     *
+     * @return The record which is published by commit(), or NULL if the
+     *      ring is full.  Calling write() again before commit() returns
+     *      the same record.
+     */
+    T * write() {
+        uint32_t head = head_;
+        if (head - tailCache_ >= N) {
+            tailCache_ = SPSC_RING_LOAD_ACQUIRE(tail_);
+            if (head - tailCache_ >= N) {
+                return NULL;
+            }
+        }
+        return &items_[head & (N - 1)];
+    }
+
+    /** Publish the record returned by write().  Producer only. */
+    void commit() {
+        SPSC_RING_STORE_RELEASE(head_, head_ + 1);
+    }
+
+    /** Copy a record into the ring.  Producer only.
+     *
+     * @param item The record.
+     * @return True on success or false if the ring is full.
+     */
+    bool push(const T & item) {
+        T * slot = write();
+        if (!slot) {
+            return false;
+        }
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    /** Get the oldest record without removing it.  Consumer only.
+     *
+     * @return The record which is removed by release(), or NULL if the
+     *      ring is empty.
+     */
+    T * read() {
+        uint32_t tail = tail_;
+        if (tail == headCache_) {
+            headCache_ = SPSC_RING_LOAD_ACQUIRE(head_);
+            if (tail == headCache_) {
+                return NULL;
+            }
+        }
+        return &items_[tail & (N - 1)];
+    }
+
+    /** Remove the record returned by read().  Consumer only. */
+    void release() {
+        SPSC_RING_STORE_RELEASE(tail_, tail_ + 1);
+    }
+
+    /** Copy the oldest record out of the ring.  Consumer only.
+     *
+     * @param item The record which is filled in on success.
+     * @return True on success or false if the ring is empty.
+     */
+    bool pop(T * item) {
+        T * slot = read();
+        if (!slot) {
+            return false;
+        }
+        *item = *slot;
+        release();
+        return true;
+    }
+
+    /** Process all available records in place.  Consumer only.
+     *
+     * The records are released together after the last call to fn, so
+     * the producer does not see free space until drain() returns.
+     *
+     * @param fn The function or function object called as fn(T &) for
+     *      each record, oldest first.
+     * @param max The maximum number of records to process.
+     * @return The number of records processed.
+     */
+    template <typename F>
+    uint32_t drain(F & fn, uint32_t max = N) {
+        uint32_t tail = tail_;
+        headCache_ = SPSC_RING_LOAD_ACQUIRE(head_);
+        uint32_t count = headCache_ - tail;
+        if (count > max) {
+            count = max;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            fn(items_[(tail + i) & (N - 1)]);
+        }
+        if (count) {
+            SPSC_RING_STORE_RELEASE(tail_, tail + count);
+        }
+        return count;
+    }
+
+private:
+    // Written by the producer
+    volatile uint32_t head_;
+    uint32_t tailCache_;
+    uint8_t producerPad_[SPSC_RING_CACHE_LINE - 2 * sizeof(uint32_t)];
+
+    // Written by the consumer
+    volatile uint32_t tail_;
+    uint32_t headCache_;
+    uint8_t consumerPad_[SPSC_RING_CACHE_LINE - 2 * sizeof(uint32_t)];
+
+    T items_[N];
+};
+
+#endif /* SPSC_RING_H */
@@ -0,0 +1,187 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "ws_handshake.h"
+#include "sha1.h"
+#include "Base64.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+static const char GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+/** Compare the start of str to prefix, ignoring case. */
+static bool starts_with(const char * str, const char * prefix) {
+    for (; *prefix; ++str, ++prefix) {
+        if (tolower((unsigned char) *str) != tolower((unsigned char) *prefix)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Check for token in a comma separated header value, ignoring case. */
+static bool has_token(const char * value, const char * token) {
+    int n = strlen(token);
+    while (*value) {
+        while ((*value == ' ') || (*value == '\t') || (*value == ',')) {
+            ++value;
+        }
+        const char * end = value;
+        while (*end && (*end != ',')) {
+            ++end;
+        }
+        const char * last = end;
+        while ((last > value) && ((last[-1] == ' ') || (last[-1] == '\t'))) {
+            --last;
+        }
+        if (((last - value) == n) && starts_with(value, token)) {
+            return true;
+        }
+        value = end;
+    }
+    return false;
+}
+
+/** Get the value of header name in line, or NULL if line is a different header. */
+static const char * header_value(const char * line, const char * name) {
+    int n = strlen(name);
+    if (!starts_with(line, name) || (line[n] != ':')) {
+        return 0;
+    }
+    line += n + 1;
+    while ((*line == ' ') || (*line == '\t')) {
+        ++line;
+    }
+    return line;
+}
+
+WsHandshake::WsHandshake() {
+    key_[0] = 0;
+    accept_[0] = 0;
+    lineLength_ = 0;
+    statusLine_ = true;
+    statusOk_ = false;
+    upgrade_ = false;
+    connection_ = false;
+    accepted_ = false;
+    status_ = STATUS_ERROR;  // start() not yet called
+    error_ = ERROR_NONE;
+}
+
+void WsHandshake::start(const uint8_t * nonce) {
+    char nonceCopy[16];
+    memcpy(nonceCopy, nonce, sizeof(nonceCopy));
+    base64_encode(key_, nonceCopy, sizeof(nonceCopy));
+
+    // The server responds with Base64(SHA-1(key + GUID))
+    Sha1Class sha1;
+    sha1.init();
+    sha1.print(key_);
+    sha1.print(GUID);
+    base64_encode(accept_, (char *) sha1.result(), HASH_LENGTH);
+
+    lineLength_ = 0;
+    statusLine_ = true;
+    statusOk_ = false;
+    upgrade_ = false;
+    connection_ = false;
+    accepted_ = false;
+    status_ = STATUS_PENDING;
+    error_ = ERROR_NONE;
+}
+
+const char * WsHandshake::key() const {
+    return key_;
+}
+
+int WsHandshake::request(char * buf, int size, const char * host, uint16_t port,
+                         const char * path, const char * protocol) const {
+    char hostPort[8] = "";
+    if (port) {
+        snprintf(hostPort, sizeof(hostPort), ":%u", (unsigned int) port);
+    }
+    int len = snprintf(buf, size,
+            "GET %s HTTP/1.1\r\n"
+            "Host: %s%s\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Key: %s\r\n"
+            "%s%s%s"
+            "Sec-WebSocket-Version: 13\r\n"
+            "\r\n",
+            path, host, hostPort, key_,
+            protocol ? "Sec-WebSocket-Protocol: " : "",
+            protocol ? protocol : "",
+            protocol ? "\r\n" : "");
+    if ((len < 0) || (len >= size)) {
+        return -1;
+    }
+    return len;
+}
+
+void WsHandshake::parseLine() {
+    const char * value;
+    if (statusLine_) {
+        // "HTTP/1.1 101 Switching Protocols"
+        statusLine_ = false;
+        const char * code = strchr(line_, ' ');
+        statusOk_ = starts_with(line_, "HTTP/") && code && (strncmp(code + 1, "101", 3) == 0);
+    } else if ((value = header_value(line_, "Upgrade")) != 0) {
+        upgrade_ = has_token(value, "websocket");
+    } else if ((value = header_value(line_, "Connection")) != 0) {
+        connection_ = has_token(value, "Upgrade");
+    } else if ((value = header_value(line_, "Sec-WebSocket-Accept")) != 0) {
+        accepted_ = (strncmp(value, accept_, 28) == 0) &&
+                ((value[28] == 0) || (value[28] == ' ') || (value[28] == '\t'));
+    }
+}
+
+int WsHandshake::parse(const uint8_t * data, int length) {
+    int idx = 0;
+    while ((status_ == STATUS_PENDING) && (idx < length)) {
+        char c = (char) data[idx++];
+        if (c != '\n') {
+            if (lineLength_ < WS_HANDSHAKE_LINE_MAX) {
+                line_[lineLength_] = c;
+            }
+            if (lineLength_ < 0xffff) {
+                ++lineLength_;
+            }
+            continue;
+        }
+        // End of line: strip the optional carriage return
+        uint16_t n = (lineLength_ < WS_HANDSHAKE_LINE_MAX) ? lineLength_ : WS_HANDSHAKE_LINE_MAX;
+        if ((lineLength_ <= WS_HANDSHAKE_LINE_MAX) && n && (line_[n - 1] == '\r')) {
+            --n;
+        }
+        line_[n] = 0;
+        lineLength_ = 0;
+        if (n || statusLine_) {
+            parseLine();
+            continue;
+        }
+
+        // The blank line ends the headers
+        if (!statusOk_) {
+            error_ = ERROR_STATUS;
+        } else if (!upgrade_) {
+            error_ = ERROR_UPGRADE;
+        } else if (!connection_) {
+            error_ = ERROR_CONNECTION;
+        } else if (!accepted_) {
+            error_ = ERROR_ACCEPT;
+        }
+        status_ = (error_ == ERROR_NONE) ? STATUS_DONE : STATUS_ERROR;
+    }
+    return idx;
+}
+
+WsHandshake::Status WsHandshake::status() const {
+    return status_;
+}
+
+WsHandshake::Error WsHandshake::error() const {
+    return error_;
+}
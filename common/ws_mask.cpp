@@ -0,0 +1,78 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "ws_mask.h"
+#include <string.h>
+
+#if defined(WS_MASK_NO_SIMD)
+// words only
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define WS_MASK_SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define WS_MASK_SIMD_NEON 1
+#endif
+
+// Use 64-bit words on 64-bit hosts and 32-bit words on the Cortex-M.
+// The word accesses use memcpy which compiles to single unaligned
+// loads and stores on both.
+#if defined(__SIZEOF_POINTER__) && (__SIZEOF_POINTER__ >= 8)
+typedef uint64_t ws_word_t;
+#else
+typedef uint32_t ws_word_t;
+#endif
+
+uint8_t ws_mask(uint8_t * data, uint32_t length, const uint8_t * mask,
+                uint8_t phase) {
+    return ws_mask_copy(data, data, length, mask, phase);
+}
+
+uint8_t ws_mask_copy(uint8_t * dst, const uint8_t * src, uint32_t length,
+                     const uint8_t * mask, uint8_t phase) {
+    // The mask rotated to the current phase and repeated.  Whole words
+    // and vectors are multiples of 4 bytes, so the phase is unchanged
+    // until the tail.
+    uint8_t m[16];
+    phase &= 3;
+    for (int i = 0; i < 16; ++i) {
+        m[i] = mask[(phase + i) & 3];
+    }
+    uint32_t idx = 0;
+
+#if WS_MASK_SIMD_SSE2
+    __m128i mv = _mm_loadu_si128((const __m128i *) m);
+    for (; idx + 16 <= length; idx += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + idx));
+        _mm_storeu_si128((__m128i *) (dst + idx), _mm_xor_si128(v, mv));
+    }
+#elif WS_MASK_SIMD_NEON
+    uint8x16_t mv = vld1q_u8(m);
+    for (; idx + 16 <= length; idx += 16) {
+        vst1q_u8(dst + idx, veorq_u8(vld1q_u8(src + idx), mv));
+    }
+#endif
+
+    ws_word_t mw;
+    memcpy(&mw, m, sizeof(mw));
+    for (; idx + 4 * sizeof(mw) <= length; idx += 4 * sizeof(mw)) {
+        ws_word_t w[4];
+        memcpy(w, src + idx, sizeof(w));
+        w[0] ^= mw;
+        w[1] ^= mw;
+        w[2] ^= mw;
+        w[3] ^= mw;
+        memcpy(dst + idx, w, sizeof(w));
+    }
+    for (; idx + sizeof(mw) <= length; idx += sizeof(mw)) {
+        ws_word_t w;
+        memcpy(&w, src + idx, sizeof(w));
+        w ^= mw;
+        memcpy(dst + idx, &w, sizeof(w));
+    }
+    for (uint32_t k = 0; idx < length; ++idx, ++k) {
+        dst[idx] = src[idx] ^ m[k];
+    }
+    return (uint8_t) ((phase + length) & 3);
+}
@@ -4,28 +4,74 @@
 
 #include "APA102.h"
 
-APA102::APA102(int pixels, SPI * spi) 
+const int SOF_BYTES = 4;
+
+APA102::APA102(int pixels, SPI * spi, bool doubleBuffer)
         : spi_(spi)
+        , frame_(NULL)
+        , back_(NULL)
         , data_(NULL)
+        , frameSize_(0)
         , pixels_(0)
+        , busy_(false)
+        , callback_(NULL)
 {
+    frames_[0] = NULL;
+    frames_[1] = NULL;
     if (pixels > 0) {
-        data_ = new uint8_t[pixels * 4];
-        if (data_) {
-            pixels_ = pixels;
-            clear();
+        int eof_bytes = pixels / 2 / 8;
+        if (eof_bytes < 4) {
+            eof_bytes = 4;
+        }
+        frameSize_ = SOF_BYTES + pixels * 4 + eof_bytes;
+        pixels_ = pixels;
+        frames_[0] = allocFrame();
+        if (doubleBuffer) {
+            frames_[1] = allocFrame();
+        }
+        if (!frames_[0] || (doubleBuffer && !frames_[1])) {
+            frameSize_ = 0;
+            pixels_ = 0;
+            return;
         }
+        frame_ = frames_[0];
+        back_ = doubleBuffer ? frames_[1] : frames_[0];
+        data_ = back_ + SOF_BYTES;
     }
 }
-    
+
 APA102::~APA102() {
-    if (data_) {
-        delete [] data_;
+    for (int i = 0; i < 2; ++i) {
+        if (frames_[i]) {
+            delete [] frames_[i];
+        }
     }
 }
-    
+
+uint8_t * APA102::allocFrame() {
+    uint8_t * frame = new uint8_t[frameSize_];
+    if (frame) {
+        // start of frame
+        for (int i = 0; i < SOF_BYTES; ++i) {
+            frame[i] = 0x00;
+        }
+        // pixels, all black at global brightness
+        for (int i = SOF_BYTES; i < SOF_BYTES + pixels_ * 4; i += 4) {
+            frame[i] = 0xFF;
+            frame[i + 1] = 0;
+            frame[i + 2] = 0;
+            frame[i + 3] = 0;
+        }
+        // end of frame
+        for (int i = SOF_BYTES + pixels_ * 4; i < frameSize_; ++i) {
+            frame[i] = 0xFF;
+        }
+    }
+    return frame;
+}
+
 bool APA102::setRGB(int pixel, int r, int g, int b) {
-    if ((pixel < 0) || (pixel > pixels_)) {
+    if ((pixel < 0) || (pixel >= pixels_)) {
         return false;
     }
     int offset = pixel * 4;
@@ -36,30 +82,27 @@ bool APA102::setRGB(int pixel, int r, int g, int b) {
 }
 
 bool APA102::setHSV(int pixel, float h, float s, float v) {
-    if (s == 0.0f) {
-        int a = int(floor(255 * v + 0.5f));
-        return setRGB(pixel, a, a, a);
-    }
-    h = h - floor(h);
-    h = h * 6.0f;
-    int i = int(floor(h));
-    float f = h - i; // fractional part of h
-    float xf = v * (1.0f - s);
-    float yf = v * (1.0f - s * f);
-    float zf = v * (1.0f - s * (1.0f - f));
-    uint8_t x = uint8_t(floor(255 * xf + 0.5f));
-    uint8_t y = uint8_t(floor(255 * yf + 0.5f));
-    uint8_t z = uint8_t(floor(255 * zf + 0.5f));
-    uint8_t w = uint8_t(floor(255 * v + 0.5f));
-    switch (i) {
-        case 0:  return setRGB(pixel, w, z, x);
-        case 1:  return setRGB(pixel, y, w, x);
-        case 2:  return setRGB(pixel, x, w, z);
-        case 3:  return setRGB(pixel, x, y, w);
-        case 4:  return setRGB(pixel, z, x, w);
-        case 5:  return setRGB(pixel, w, x, y);
-        default: return setRGB(pixel, 0, 0, 0);
+    uint8_t rgb[3];
+    hsv_to_rgb(hsv_hue(h), hsv_unit(s), hsv_unit(v), rgb);
+    return setRGB(pixel, rgb[0], rgb[1], rgb[2]);
+}
+
+bool APA102::setHSVStrip(int pixel, int count, uint16_t h, uint16_t h_step,
+                         uint8_t s, uint8_t v) {
+    if ((pixel < 0) || (count < 0) || (pixel + count > pixels_)) {
+        return false;
     }
+    hsv_to_rgb_strip(h, h_step, s, v, data_ + pixel * 4, count,
+                     &PIXEL_LAYOUT_APA102);
+    return true;
+}
+
+uint8_t * APA102::getPixels() const {
+    return data_;
+}
+
+int APA102::numPixels() const {
+    return pixels_;
 }
 
 void APA102::clear() {
@@ -72,24 +115,66 @@ void APA102::clear() {
     }
 }
 
+bool APA102::swap() {
+    if (frame_ == back_) {
+        return true;
+    }
+    bool rv = false;
+    __disable_irq();
+    if (!busy_) {
+        uint8_t * frame = frame_;
+        frame_ = back_;
+        back_ = frame;
+        data_ = back_ + SOF_BYTES;
+        rv = true;
+    }
+    __enable_irq();
+    return rv;
+}
+
+void APA102::copyFront() {
+    if (frame_ != back_) {
+        memcpy(data_, frame_ + SOF_BYTES, pixels_ * 4);
+    }
+}
+
 void APA102::refresh() {
-    // start of frame
-    spi_->write(0x00);
-    spi_->write(0x00);
-    spi_->write(0x00);
-    spi_->write(0x00);
-    
-    for (int i = 0; i < pixels_ * 4; ++i) {
-        spi_->write(data_[i]);
+    while (busy_) {
+        // wait for any asynchronous refresh to complete
+    }
+    for (int i = 0; i < frameSize_; ++i) {
+        spi_->write(frame_[i]);
     }
+}
 
-    // end of frame
-    int eof_bytes = pixels_ / 2 / 8;
-    if (eof_bytes < 4) {
-        eof_bytes = 4;
+#if DEVICE_SPI_ASYNCH
+bool APA102::refreshAsync(void (*callback)(void)) {
+    if (busy_) {
+        return false;
     }
-    for (int i = 0; i < eof_bytes; ++i) {
-        spi_->write(0xFF);
+    if (!frameSize_) {
+        return true;
     }
+    busy_ = true;
+    callback_ = callback;
+    event_callback_t cbk(this, &APA102::onTransferComplete);
+    if (spi_->transfer(frame_, frameSize_, (uint8_t *) NULL, 0, cbk,
+                       SPI_EVENT_COMPLETE | SPI_EVENT_ERROR)) {
+        busy_ = false;
+        return false;
+    }
+    return true;
 }
+#endif
 
+bool APA102::isBusy() const {
+    return busy_;
+}
+
+void APA102::onTransferComplete(int event) {
+    (void) event;
+    busy_ = false;
+    if (callback_) {
+        callback_();
+    }
+}
@@ -3,9 +3,18 @@
 // http://opensource.org/licenses/MIT
 
 #include "mbed.h"
+#include "hsv.h"
 
 /** Controller for APA102 LEDs.
  * Used for controlling one or more APA102 RGB LEDs over SPI.
+ *
+ * The pixel data is stored in place within the complete wire frame
+ * (start frame, pixel data, end frame) so that the frame can be sent to
+ * the SPI peripheral as a single contiguous transfer.
+ *
+ * In double buffered mode, setRGB(), setHSV() and clear() modify the back
+ * buffer while refresh() sends the front buffer.  Call swap() to publish
+ * the back buffer once the frame is fully rendered.
  */
 class APA102 {
 public:
@@ -14,12 +23,14 @@ public:
      * @param pixels The total number of pixels in the array.
      * @param spi The SPI interface controlling the pixels.  This interface
      *      must not be connected to any other devices.
+     * @param doubleBuffer True to allocate separate front and back buffers
+     *      or false to render directly into the buffer being refreshed.
      */
-    APA102(int pixels, SPI * spi);
-    
+    APA102(int pixels, SPI * spi, bool doubleBuffer = false);
+
     /** Destructor */
     ~APA102();
-    
+
     /** Set a pixel using red, green, blue.
      *
      * @param pixel The pixel number.
@@ -27,9 +38,9 @@ public:
      * @param g The green value from 0 to 255.
      * @param b The blue value from 0 to 255.
      * @return True on success or false on failure.
-     */ 
+     */
     bool setRGB(int pixel, int r, int g, int b);
-    
+
     /** Set a pixel using hue, saturation, value.
      *
      * @param pixel The pixel number.
@@ -41,15 +52,103 @@ public:
      * @see http://www.easyrgb.com/index.php?X=MATH&H=21#text21
      */
     bool setHSV(int pixel, float h, float s, float v);
-    
+
+    /** Set a range of pixels to evenly spaced hues.
+     *
+     * @param pixel The first pixel number.
+     * @param count The number of pixels to set.
+     * @param h The hue of the first pixel where 65536 is one full rotation.
+     * @param h_step The hue increment between adjacent pixels.
+     * @param s The saturation from 0 to 255.
+     * @param v The value/intensity from 0 to 255.
+     * @return True on success or false on failure.
+     *
+     * @see hsv_to_rgb_strip()
+     */
+    bool setHSVStrip(int pixel, int count, uint16_t h, uint16_t h_step,
+                     uint8_t s, uint8_t v);
+
+    /** Get the pixel data being rendered.
+     *
+     * The buffer holds numPixels() pixels in the PIXEL_LAYOUT_APA102
+     * layout.  In double buffered mode, this is the back buffer and the
+     * pointer changes with each swap().  Use this buffer to decode frames
+     * in place, such as with LedFrameDecoder::decode().
+     *
+     * @return The pixel data.
+     */
+    uint8_t * getPixels() const;
+
+    /** Get the number of pixels.
+     *
+     * @return The number of pixels in the array.
+     */
+    int numPixels() const;
+
     /** Clear the array and set all LEDs to black. */
     void clear();
-    
-    /** Refresh the array with the buffered values. */
+
+    /** Publish the back buffer to the refresh path.
+     *
+     * The front and back buffers are exchanged atomically.  The new back
+     * buffer holds the previously published frame, so the caller must
+     * render every pixel before the next swap.  In single buffered mode,
+     * this function does nothing.
+     *
+     * @return True on success or false if an asynchronous refresh is still
+     *      reading the front buffer.
+     */
+    bool swap();
+
+    /** Copy the published pixels into the back buffer.
+     *
+     * After swap(), the back buffer holds an older frame.  Call this
+     * function to render the next frame incrementally from the published
+     * one, such as when applying LED_FRAME_DELTA frames.  In single
+     * buffered mode, this function does nothing.
+     */
+    void copyFront();
+
+    /** Refresh the array with the buffered values.
+     *
+     * This function blocks until the entire frame has been written.
+     */
     void refresh();
 
+#if DEVICE_SPI_ASYNCH
+    /** Start an asynchronous refresh of the array with the buffered values.
+     *
+     * The complete wire frame is handed to the SPI peripheral as a single
+     * transfer and this function returns immediately.  In single buffered
+     * mode, the buffered values must not be modified until the transfer
+     * completes.
+     *
+     * @param callback The function called from interrupt context when the
+     *      transfer completes, or NULL.
+     * @return True if the transfer started or false if a previous
+     *      transfer is still in progress.
+     */
+    bool refreshAsync(void (*callback)(void) = NULL);
+#endif
+
+    /** Check for an asynchronous refresh in progress.
+     *
+     * @return True if a refresh is in progress, otherwise false.
+     */
+    bool isBusy() const;
+
 private:
+    void onTransferComplete(int event);
+
+    uint8_t * allocFrame();
+
     SPI * spi_;
-    uint8_t * data_;
+    uint8_t * frames_[2];
+    uint8_t * frame_;  // The complete wire frame sent by refresh
+    uint8_t * back_;   // The complete wire frame being rendered
+    uint8_t * data_;   // The pixel data within back_
+    int frameSize_;
     int pixels_;
+    volatile bool busy_;
+    void (*callback_)(void);
 };
@@ -1,24 +1,43 @@
 #include "Websocket.h"
+#include "ws_mask.h"
 
 #define MAX_TRY_WRITE 20
-#define MAX_TRY_READ 10
 
 //Debug is disabled by default
 #if 0
-#define DBG(x, ...) std::printf("[WebSocket : DBG]"x"\r\n", ##__VA_ARGS__); 
-#define WARN(x, ...) std::printf("[WebSocket : WARN]"x"\r\n", ##__VA_ARGS__); 
-#define ERR(x, ...) std::printf("[WebSocket : ERR]"x"\r\n", ##__VA_ARGS__); 
+#define DBG(x, ...) std::printf("[WebSocket : DBG]" x "\r\n", ##__VA_ARGS__); 
+#define WARN(x, ...) std::printf("[WebSocket : WARN]" x "\r\n", ##__VA_ARGS__); 
+#define ERR(x, ...) std::printf("[WebSocket : ERR]" x "\r\n", ##__VA_ARGS__); 
 #else
 #define DBG(x, ...) 
 #define WARN(x, ...)
 #define ERR(x, ...) 
 #endif
 
-#define INFO(x, ...) printf("[WebSocket : INFO]"x"\r\n", ##__VA_ARGS__); 
+#define INFO(x, ...) printf("[WebSocket : INFO]" x "\r\n", ##__VA_ARGS__); 
 
-Websocket::Websocket(char * url) {
+Websocket::Websocket(char * url)
+        : parser(WEBSOCKET_MAX_MESSAGE_SIZE)
+        , reassembler(msg_buf, sizeof(msg_buf)) {
     fillFields(url);
     socket.set_blocking(false, 400);
+    rx_len = 0;
+    rx_pos = 0;
+    frame_start = 0;
+    frame_pending = false;
+    tx_len = 0;
+    tx_sent = 0;
+    txq_head = 0;
+    txq_bytes = 0;
+    txq_count = 0;
+    txq_dropped = 0;
+    txq_policy = QUEUE_DROP_OLDEST;
+    txq_timeout_ms = 1000;
+    ws_state = STATE_CLOSED;
+    clock_ms = 0;
+    clock_us = 0;
+    handshake_start = 0;
+    clock.start();
 }
 
 void Websocket::fillFields(char * url) {
@@ -115,90 +134,154 @@ int Websocket::parseURL(const char* url, char* scheme, size_t maxSchemeLen, char
 
 
 bool Websocket::connect() {
-    char cmd[200];
-
-    while (socket.connect(host, port) < 0) {
-        ERR("Unable to connect to (%s) on port (%d)", host, port);
-        wait(0.2);
-        return false;
+    if (ws_state != STATE_CLOSED) {
+        socket.close();
+        ws_state = STATE_CLOSED;
+    }
+    reconnect.reset();
+    while (!poll()) {
+        if (ws_state == STATE_CLOSED) {
+            return false;
+        }
+        wait_ms(1);
     }
+    return true;
+}
 
-    // sent http header to upgrade to the ws protocol
-    sprintf(cmd, "GET %s HTTP/1.1\r\n", path);
-    write(cmd, strlen(cmd));
-    
-    sprintf(cmd, "Host: %s:%d\r\n", host, port);
-    write(cmd, strlen(cmd));
+uint32_t Websocket::now_ms() {
+    // Timer::read_us() overflows after 35 minutes, so accumulate instead
+    clock_us += clock.read_us();
+    clock.reset();
+    clock_ms += clock_us / 1000;
+    clock_us %= 1000;
+    return clock_ms;
+}
 
-    sprintf(cmd, "Upgrade: WebSocket\r\n");
-    write(cmd, strlen(cmd));
+void Websocket::setReconnect(uint32_t base_ms, uint32_t max_ms, uint32_t seed) {
+    reconnect = ReconnectScheduler(base_ms, max_ms, seed);
+}
 
-    sprintf(cmd, "Connection: Upgrade\r\n");
-    write(cmd, strlen(cmd));
+Websocket::State Websocket::state() {
+    return ws_state;
+}
 
-    sprintf(cmd, "Sec-WebSocket-Key: L159VM0TWUzyDxwJEIEzjw==\r\n");
-    write(cmd, strlen(cmd));
+bool Websocket::retry(uint32_t now) {
+    socket.close();
+    ws_state = STATE_CLOSED;
+    uint32_t delay = reconnect.failed(now);
+    INFO("Reconnect in %lu ms", (unsigned long) delay);
+    return false;
+}
 
-    sprintf(cmd, "Sec-WebSocket-Version: 13\r\n\r\n");
-    int ret = write(cmd, strlen(cmd));
-    if (ret != strlen(cmd)) {
-        close();
-        ERR("Could not send request");
-        return false;
+bool Websocket::poll() {
+    uint32_t now = now_ms();
+    switch (ws_state) {
+        case STATE_CLOSED:
+            if (!reconnect.ready(now)) {
+                return false;
+            }
+            parser.reset();
+            reassembler.reset();
+            rx_len = 0;
+            rx_pos = 0;
+            frame_start = 0;
+            frame_pending = false;
+            tx_len = 0;  // discard any frame left over from the previous connection
+            tx_sent = 0;
+            ws_state = STATE_TCP_CONNECT;
+            // fall through
+        case STATE_TCP_CONNECT:
+            if (socket.connect(host, port) < 0) {
+                ERR("Unable to connect to (%s) on port (%d)", host, port);
+                return retry(now);
+            }
+            ws_state = STATE_UPGRADE;
+            // fall through
+        case STATE_UPGRADE:
+            if (sendRequest() < 0) {
+                ERR("Could not send request");
+                return retry(now);
+            }
+            handshake_start = now;
+            ws_state = STATE_AWAIT_ACCEPT;
+            // fall through
+        case STATE_AWAIT_ACCEPT:
+            return awaitAccept(now);
+        case STATE_OPEN:
+            if (socket.is_connected()) {
+                return true;
+            }
+            WARN("Connection was closed by server");
+            return retry(now);
     }
+    return false;
+}
 
-    ret = read(cmd, 200, 100);
-    if (ret < 0) {
-        close();
-        ERR("Could not receive answer\r\n");
-        return false;
+bool Websocket::awaitAccept(uint32_t now) {
+    socket.set_blocking(false, 1);
+    int ret = socket.receive((char *) rx_buf + rx_len, sizeof(rx_buf) - rx_len);
+    socket.set_blocking(false, 2000);
+    if (ret > 0) {
+        rx_len += ret;
     }
-
-    cmd[ret] = '\0';
-    DBG("recv: %s\r\n", cmd);
-
-    if ( strstr(cmd, "DdLWT/1JcX+nQFHebYP+rqEx5xI=") == NULL ) {
-        ERR("Wrong answer from server, got \"%s\" instead\r\n", cmd);
-        do {
-            ret = read(cmd, 200, 100);
-            if (ret < 0) {
-                ERR("Could not receive answer\r\n");
-                return false;
-            }
-            cmd[ret] = '\0';
-            printf("%s",cmd);
-        } while (ret > 0);
-        close();
+    rx_pos += handshake.parse(rx_buf + rx_pos, rx_len - rx_pos);
+
+    if (handshake.status() == WsHandshake::STATUS_PENDING) {
+        rx_len = 0;  // the handshake consumed everything
+        rx_pos = 0;
+        if (!socket.is_connected() ||
+                (now - handshake_start >= WEBSOCKET_HANDSHAKE_TIMEOUT_MS)) {
+            ERR("Could not receive answer\r\n");
+            return retry(now);
+        }
         return false;
+    } else if (handshake.status() != WsHandshake::STATUS_DONE) {
+        ERR("Wrong answer from server, error %d\r\n", handshake.error());
+        return retry(now);
     }
 
+    // Keep any frame bytes that arrived with the response for read()
+    ws_state = STATE_OPEN;
+    reconnect.reset();
     INFO("\r\nhost: %s\r\npath: %s\r\nport: %d\r\n\r\n", host, path, port);
     return true;
 }
 
+int Websocket::sendRequest() {
+    // Send the http header to upgrade to the ws protocol with a single write
+    uint8_t nonce[16];
+    for (int i = 0; i < 16; i++) {
+        nonce[i] = rand() & 0xff;
+    }
+    handshake.start(nonce);
+    int len = handshake.request(tx_buf, sizeof(tx_buf), host, port, path);
+    if (len < 0) {
+        return -1;
+    }
+    return (write(tx_buf, len) == len) ? len : -1;
+}
+
 int Websocket::sendLength(uint32_t len, char * msg) {
 
     if (len < 126) {
         msg[0] = len | (1<<7);
         return 1;
-    } else if (len < 65535) {
+    } else if (len <= 0xffff) {
         msg[0] = 126 | (1<<7);
         msg[1] = (len >> 8) & 0xff;
         msg[2] = len & 0xff;
         return 3;
     } else {
+        // 64-bit length in network byte order
         msg[0] = 127 | (1<<7);
-        for (int i = 0; i < 8; i++) {
-            msg[i+1] = (len >> i*8) & 0xff;
+        for (int i = 0; i < 4; i++) {
+            msg[i+1] = 0;
+            msg[i+5] = (len >> (24 - i*8)) & 0xff;
         }
         return 9;
     }
 }
 
-int Websocket::readChar(char * pC, bool block) {
-    return read(pC, 1, 1);
-}
-
 int Websocket::sendOpcode(uint8_t opcode, char * msg) {
     msg[0] = 0x80 | (opcode & 0x0f);
     return 1;
@@ -206,103 +289,326 @@ int Websocket::sendOpcode(uint8_t opcode, char * msg) {
 
 int Websocket::sendMask(char * msg) {
     for (int i = 0; i < 4; i++) {
-        msg[i] = 0;
+        msg[i] = rand() & 0xff;
     }
     return 4;
 }
 
-int Websocket::send(char * str) {
-    char msg[strlen(str) + 15];
-    int idx = 0;
-    idx = sendOpcode(0x01, msg);
-    idx += sendLength(strlen(str), msg + idx);
+int Websocket::sendHeader(uint8_t opcode, uint32_t len, char * msg, uint8_t * mask) {
+    int idx = sendOpcode(opcode, msg);
+    idx += sendLength(len, msg + idx);
     idx += sendMask(msg + idx);
-    memcpy(msg+idx, str, strlen(str));
-    int res = write(msg, idx + strlen(str));
-    return res;
-}
-
-
-bool Websocket::read(char * message) {
-    int i = 0;
-    uint32_t len_msg;
-    char opcode = 0;
-    char c;
-    char mask[4] = {0, 0, 0, 0};
-    bool is_masked = false;
-    Timer tmr;
-
-    // read the opcode
-    tmr.start();
-    while (true) {
-        if (tmr.read() > 3) {
-            DBG("timeout ws\r\n");
-            return false;
+    memcpy(mask, msg + idx - 4, 4);
+    return idx;
+}
+
+int Websocket::sendFrame(uint8_t opcode, const char * data, int len) {
+    uint8_t mask[4];
+    uint8_t phase = 0;
+    int pos = 0;
+    int total = 0;
+
+    // Finish any queued frames first so that the frames do not interleave
+    if (!drainTx(true)) {
+        return -1;
+    }
+    int idx = sendHeader(opcode, len, tx_buf, mask);
+
+    // Mask the payload while copying it after the header so that the
+    // frame goes out in a single write.
+    while (1) {
+        int n = len - pos;
+        if (n > (int) sizeof(tx_buf) - idx) {
+            n = sizeof(tx_buf) - idx;
         }
-        
-        if(!socket.is_connected())
-        {
-            WARN("Connection was closed by server");
-            return false;
+        phase = ws_mask_copy((uint8_t *) tx_buf + idx, (const uint8_t *) data + pos,
+                             n, mask, phase);
+        pos += n;
+        idx += n;
+        int res = write(tx_buf, idx);
+        if (res != idx) {
+            if (res > 0) {
+                // A partial frame leaves the stream unusable
+                ERR("Partial frame write");
+                socket.close();
+            }
+            return -1;
+        }
+        total += idx;
+        if (pos >= len) {
+            return total;
         }
+        idx = 0;
+    }
+}
 
-        socket.set_blocking(false, 1);
-        if (socket.receive(&opcode, 1) != 1) {
+bool Websocket::drainTx(bool block) {
+    if (tx_sent < tx_len) {
+        int res;
+        if (block) {
+            res = write(tx_buf + tx_sent, tx_len - tx_sent);
+        } else {
+            socket.set_blocking(false, 1);
+            res = socket.send(tx_buf + tx_sent, tx_len - tx_sent);
             socket.set_blocking(false, 2000);
+        }
+        if (res > 0) {
+            tx_sent += res;
+        }
+        if (tx_sent < tx_len) {
+            if (block) {
+                ERR("Partial frame write");
+                socket.close();
+                tx_len = 0;
+                tx_sent = 0;
+            }
             return false;
         }
+    }
+    tx_len = 0;
+    tx_sent = 0;
+    return true;
+}
 
-        socket.set_blocking(false, 2000);
+void Websocket::queueWrite(const uint8_t * src, int len) {
+    int tail = (txq_head + txq_bytes) % WEBSOCKET_TX_QUEUE_SIZE;
+    int n = WEBSOCKET_TX_QUEUE_SIZE - tail;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(txq_buf + tail, src, n);
+    memcpy(txq_buf, src + n, len - n);
+    txq_bytes += len;
+}
 
-        if (opcode == 0x81)
-            break;
+void Websocket::queueRead(uint8_t * dst, int len) {
+    int n = WEBSOCKET_TX_QUEUE_SIZE - txq_head;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(dst, txq_buf + txq_head, n);
+    memcpy(dst + n, txq_buf, len - n);
+    txq_head = (txq_head + len) % WEBSOCKET_TX_QUEUE_SIZE;
+    txq_bytes -= len;
+}
+
+void Websocket::queueDropOldest() {
+    uint8_t hdr[3];
+    queueRead(hdr, sizeof(hdr));
+    int len = (hdr[1] << 8) | hdr[2];
+    txq_head = (txq_head + len) % WEBSOCKET_TX_QUEUE_SIZE;
+    txq_bytes -= len;
+    --txq_count;
+    ++txq_dropped;
+}
+
+bool Websocket::queue(const char * data, int length, uint8_t opcode) {
+    // Each message is stored as the opcode, the 16-bit length and the payload
+    int need = length + 3;
+    if ((length < 0) || (length > WEBSOCKET_MAX_MESSAGE_SIZE) ||
+            (need > WEBSOCKET_TX_QUEUE_SIZE)) {
+        ++txq_dropped;
+        return false;
     }
-    DBG("opcode: 0x%X\r\n", opcode);
-
-    readChar(&c);
-    len_msg = c & 0x7f;
-    is_masked = c & 0x80;
-    if (len_msg == 126) {
-        readChar(&c);
-        len_msg = c << 8;
-        readChar(&c);
-        len_msg += c;
-    } else if (len_msg == 127) {
-        len_msg = 0;
-        for (int i = 0; i < 8; i++) {
-            readChar(&c);
-            len_msg += (c << (7-i)*8);
+    if (txq_bytes + need > WEBSOCKET_TX_QUEUE_SIZE) {
+        if (txq_policy == QUEUE_DROP_OLDEST) {
+            while (txq_bytes + need > WEBSOCKET_TX_QUEUE_SIZE) {
+                queueDropOldest();
+            }
+        } else if (txq_policy == QUEUE_DROP_NEWEST) {
+            ++txq_dropped;
+            return false;
+        } else {
+            Timer timer;
+            timer.start();
+            while (txq_bytes + need > WEBSOCKET_TX_QUEUE_SIZE) {
+                if ((flush() < 0) || (timer.read_ms() >= txq_timeout_ms)) {
+                    ++txq_dropped;
+                    return false;
+                }
+                wait_ms(1);
+            }
         }
     }
+    uint8_t hdr[3] = {opcode, (uint8_t) (length >> 8), (uint8_t) (length & 0xff)};
+    queueWrite(hdr, sizeof(hdr));
+    queueWrite((const uint8_t *) data, length);
+    ++txq_count;
+    return true;
+}
 
-    if (len_msg == 0) {
-        return false;
+int Websocket::flush() {
+    if (!is_connected()) {
+        return -1;
     }
-    DBG("length: %d\r\n", len_msg);
-    
-    if (is_masked) {
-        for (i = 0; i < 4; i++)
-            readChar(&c);
-        mask[i] = c;
+    if (!drainTx(false)) {
+        return txq_count;
+    }
+
+    // Coalesce as many queued messages as fit into a single write
+    while (txq_count) {
+        int len = (txq_buf[(txq_head + 1) % WEBSOCKET_TX_QUEUE_SIZE] << 8) |
+                  txq_buf[(txq_head + 2) % WEBSOCKET_TX_QUEUE_SIZE];
+        if (tx_len + len + 8 > (int) sizeof(tx_buf)) {
+            break;  // maximum header is 4 bytes plus the 4 byte mask
+        }
+        uint8_t hdr[3];
+        uint8_t mask[4];
+        queueRead(hdr, sizeof(hdr));
+        tx_len += sendHeader(hdr[0], len, tx_buf + tx_len, mask);
+        queueRead((uint8_t *) tx_buf + tx_len, len);
+        ws_mask((uint8_t *) tx_buf + tx_len, len, mask, 0);
+        tx_len += len;
+        --txq_count;
+    }
+    drainTx(false);
+    return txq_count;
+}
+
+void Websocket::setQueuePolicy(QueuePolicy policy, int timeout_ms) {
+    txq_policy = policy;
+    txq_timeout_ms = timeout_ms;
+}
+
+int Websocket::queueDepth() {
+    return txq_count;
+}
+
+uint32_t Websocket::droppedCount() {
+    return txq_dropped;
+}
+
+int Websocket::send(char * str) {
+    return sendFrame(WS_OPCODE_TEXT, str, strlen(str));
+}
+
+int Websocket::sendBinary(const char * data, int length) {
+    return sendFrame(WS_OPCODE_BINARY, data, length);
+}
+
+void Websocket::fail(uint16_t status) {
+    char payload[2] = {(char) (status >> 8), (char) (status & 0xff)};
+    ERR("Closing with status %d", status);
+    if (socket.is_connected()) {
+        sendFrame(WS_OPCODE_CLOSE, payload, sizeof(payload));
+        socket.close();
     }
+    rx_pos = rx_len;
+}
 
-    int nb = read(message, len_msg, len_msg);
-    if (nb != len_msg)
+bool Websocket::parseMessage(char ** message, int * length, uint8_t * opcode) {
+    while (rx_pos < rx_len) {
+        WsChunk chunk;
+        int ret = parser.parse(rx_buf + rx_pos, rx_len - rx_pos, &chunk);
+        if (ret < 0) {
+            ERR("Protocol error %d", parser.error());
+            if (parser.error() == WsParser::ERROR_TOO_LARGE) {
+                fail(WS_CLOSE_TOO_LARGE);
+            } else {
+                fail(WS_CLOSE_PROTOCOL_ERROR);
+            }
+            return false;
+        }
+        rx_pos += ret;
+        if (!chunk.ready) {
+            continue;
+        }
+        if (chunk.first) {
+            frame_start = chunk.data - rx_buf;
+            frame_pending = true;
+        }
+        if (!chunk.last) {
+            continue;
+        }
+        frame_pending = false;
+        char * payload = (char *) (rx_buf + frame_start);
+        switch (chunk.opcode) {
+            case WS_OPCODE_PING:
+                DBG("ping\r\n");
+                sendFrame(WS_OPCODE_PONG, payload, chunk.frameLength);
+                break;
+            case WS_OPCODE_PONG:
+                break;
+            case WS_OPCODE_CLOSE:
+                // Echo the status code then close the connection
+                WARN("Connection was closed by server");
+                sendFrame(WS_OPCODE_CLOSE, payload, (chunk.frameLength >= 2) ? 2 : 0);
+                socket.close();
+                rx_pos = rx_len;  // ignore anything sent after the close
+                return false;
+            default: {
+                uint8_t * msg;
+                uint32_t msg_len;
+                uint8_t msg_opcode;
+                int rc = reassembler.add(chunk.opcode, chunk.fin, (uint8_t *) payload,
+                                         chunk.frameLength, &msg, &msg_len, &msg_opcode);
+                if (rc == 1) {
+                    *message = (char *) msg;
+                    *length = msg_len;
+                    if (opcode) {
+                        *opcode = msg_opcode;
+                    }
+                    return true;
+                } else if (rc) {
+                    fail(rc);
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+void Websocket::compact() {
+    // Keep the payload of a partially received frame contiguous
+    int keep = frame_pending ? frame_start : rx_pos;
+    if (keep > 0) {
+        memmove(rx_buf, rx_buf + keep, rx_len - keep);
+        rx_len -= keep;
+        rx_pos -= keep;
+        frame_start -= keep;
+    }
+}
+
+bool Websocket::read(char ** message, int * length, uint8_t * opcode) {
+    if (ws_state != STATE_OPEN) {
         return false;
+    }
 
-    for (i = 0; i < len_msg; i++) {
-        message[i] = message[i] ^ mask[i % 4];
+    // Parse any bytes remaining from the previous receive first
+    if (parseMessage(message, length, opcode)) {
+        return true;
     }
 
-    message[len_msg] = '\0';
+    if (!socket.is_connected()) {
+        WARN("Connection was closed by server");
+        return false;
+    }
 
-    return true;
+    compact();
+    socket.set_blocking(false, 1);
+    int ret = socket.receive((char *) rx_buf + rx_len, sizeof(rx_buf) - rx_len);
+    socket.set_blocking(false, 2000);
+    if (ret <= 0) {
+        return false;
+    }
+    rx_len += ret;
+    return parseMessage(message, length, opcode);
 }
 
 bool Websocket::close() {
-    if (!is_connected())
+    if (!is_connected()) {
+        if (ws_state != STATE_CLOSED) {
+            socket.close();  // abandon the connection attempt
+            ws_state = STATE_CLOSED;
+        }
         return false;
+    }
 
+    char payload[2] = {(char) (WS_CLOSE_NORMAL >> 8), (char) (WS_CLOSE_NORMAL & 0xff)};
+    sendFrame(WS_OPCODE_CLOSE, payload, sizeof(payload));
+    ws_state = STATE_CLOSED;
     int ret = socket.close();
     if (ret < 0) {
         ERR("Could not disconnect");
@@ -312,7 +618,7 @@ bool Websocket::close() {
 }
 
 bool Websocket::is_connected() {
-    return socket.is_connected();
+    return (ws_state == STATE_OPEN) && socket.is_connected();
 }
 
 char* Websocket::getPath() {
@@ -341,20 +647,3 @@ int Websocket::write(char * str, int len) {
     
     return (idx == 0) ? -1 : idx;
 }
-
-int Websocket::read(char * str, int len, int min_len) {
-    int res = 0, idx = 0;
-    
-    for (int j = 0; j < MAX_TRY_WRITE; j++) {
-
-        if ((res = socket.receive_all(str + idx, len - idx)) == -1)
-            continue;
-
-        idx += res;
-        
-        if (idx == len || (min_len != -1 && idx > min_len))
-            return idx;
-    }
-    
-    return (idx == 0) ? -1 : idx;
-}
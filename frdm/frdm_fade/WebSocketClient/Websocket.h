@@ -34,6 +34,37 @@
 #include "mbed.h"
 
 #include "TCPSocketConnection.h"
+#include "ws_parser.h"
+#include "reconnect.h"
+#include "ws_handshake.h"
+
+/** The maximum received message payload size in bytes. */
+#ifndef WEBSOCKET_MAX_MESSAGE_SIZE
+#define WEBSOCKET_MAX_MESSAGE_SIZE 1024
+#endif
+
+/** The receive buffer size, which also holds the headers and any following frames. */
+#define WEBSOCKET_RX_BUFFER_SIZE (WEBSOCKET_MAX_MESSAGE_SIZE + 64)
+
+/** The transmit buffer size which holds a frame header and masked payload.
+ *
+ * Frames up to WEBSOCKET_MAX_MESSAGE_SIZE are sent with a single write.
+ * Larger frames continue in buffer-sized writes.
+ */
+#define WEBSOCKET_TX_BUFFER_SIZE (WEBSOCKET_MAX_MESSAGE_SIZE + 14)
+
+/** The maximum time to wait for the server's upgrade response. */
+#ifndef WEBSOCKET_HANDSHAKE_TIMEOUT_MS
+#define WEBSOCKET_HANDSHAKE_TIMEOUT_MS 5000
+#endif
+
+/** The outbound message queue size in bytes.
+ *
+ * Each queued message uses its length plus 3 bytes.
+ */
+#ifndef WEBSOCKET_TX_QUEUE_SIZE
+#define WEBSOCKET_TX_QUEUE_SIZE 2048
+#endif
 
 /** Websocket client Class.
  *
@@ -55,8 +86,10 @@
  *    while (1) {
  *        int res = ws.send("WebSocket Hello World!");
  *
- *        if (ws.read(recv)) {
- *            printf("rcv: %s\r\n", recv);
+ *        char * recv;
+ *        int recv_len;
+ *        if (ws.read(&recv, &recv_len)) {
+ *            printf("rcv: %.*s\r\n", recv_len, recv);
  *        }
  *
  *        wait(0.1);
@@ -68,6 +101,22 @@
 class Websocket
 {
     public:
+        /** The action taken when queue() finds the outbound queue full. */
+        enum QueuePolicy {
+            QUEUE_DROP_OLDEST,  // Discard the oldest queued messages
+            QUEUE_DROP_NEWEST,  // Discard the new message
+            QUEUE_BLOCK         // Flush until space is available or timeout
+        };
+
+        /** The connection state advanced by poll(). */
+        enum State {
+            STATE_CLOSED,        // Waiting for the next connection attempt
+            STATE_TCP_CONNECT,   // Opening the TCP connection
+            STATE_UPGRADE,       // Sending the http upgrade request
+            STATE_AWAIT_ACCEPT,  // Receiving the upgrade response
+            STATE_OPEN           // The websocket is connected
+        };
+
         /**
         * Constructor
         *
@@ -76,29 +125,135 @@ class Websocket
         Websocket(char * url);
 
         /**
-        * Connect to the websocket url
+        * Connect to the websocket url, blocking until complete
         *
         *@return true if the connection is established, false otherwise
         */
         bool connect();
 
+        /**
+        * Advance the connection state machine
+        *
+        * Call regularly from the network loop.  When the connection is
+        * closed or lost, poll() reconnects after a jittered exponential
+        * backoff delay.  The upgrade response is received without
+        * blocking.  Opening the TCP connection still blocks since
+        * TCPSocketConnection has no asynchronous connect.
+        *
+        * @return true if the websocket is connected
+        */
+        bool poll();
+
+        /**
+        * Get the connection state
+        *
+        * @return the state
+        */
+        State state();
+
+        /**
+        * Configure the reconnect backoff
+        *
+        * @param base_ms The maximum delay after the first failure
+        * @param max_ms The upper limit for the delay
+        * @param seed The random seed which should differ between devices,
+        *      such as a hash of the MAC address
+        */
+        void setReconnect(uint32_t base_ms, uint32_t max_ms, uint32_t seed);
+
         /**
         * Send a string according to the websocket format (see rfc 6455)
         *
         * @param str string to be sent
         *
-        * @returns the number of bytes sent
+        * @returns the number of bytes sent, including the frame header,
+        *      or -1 on error
         */
         int send(char * str);
 
         /**
-        * Read a websocket message
+        * Send binary data according to the websocket format (see rfc 6455)
         *
-        * @param message pointer to the string to be read (null if drop frame)
+        * @param data The data to be sent
+        * @param length The length of data in bytes
         *
-        * @return true if a websocket frame has been read
+        * @returns the number of bytes sent, including the frame header,
+        *      or -1 on error
         */
-        bool read(char * message);
+        int sendBinary(const char * data, int length);
+
+        /**
+        * Queue a message for transmission by flush()
+        *
+        * The message is copied, so the caller may reuse data immediately.
+        * When the queue is full, the queue policy decides whether older
+        * messages or this message are dropped, or whether to wait.
+        *
+        * @param data The message payload
+        * @param length The length of data in bytes, up to
+        *      WEBSOCKET_MAX_MESSAGE_SIZE
+        * @param opcode WS_OPCODE_TEXT or WS_OPCODE_BINARY
+        *
+        * @return true if the message was queued, false if it was dropped
+        */
+        bool queue(const char * data, int length, uint8_t opcode = WS_OPCODE_TEXT);
+
+        /**
+        * Transmit queued messages without blocking
+        *
+        * Call regularly from the network loop.  As many queued messages
+        * as fit are framed together and submitted with a single write.
+        * Each message remains a separate websocket frame.  Bytes that
+        * the socket does not accept are retried on the next call.
+        *
+        * @return the number of messages still waiting, or -1 on error
+        */
+        int flush();
+
+        /**
+        * Set the policy used when the outbound queue is full
+        *
+        * @param policy The policy
+        * @param timeout_ms The maximum time that queue() waits for
+        *      QUEUE_BLOCK before dropping the new message
+        */
+        void setQueuePolicy(QueuePolicy policy, int timeout_ms = 1000);
+
+        /**
+        * Get the number of queued messages, excluding those being sent
+        *
+        * @return the queue depth in messages
+        */
+        int queueDepth();
+
+        /**
+        * Get the number of messages dropped because the queue was full
+        *
+        * @return the total drop count since construction
+        */
+        uint32_t droppedCount();
+
+        /**
+        * Read a websocket message without blocking
+        *
+        * Each call performs at most one bulk receive from the socket and
+        * parses the received bytes incrementally.  Unfragmented message
+        * payloads are not copied.  Fragmented messages are reassembled
+        * into a bounded buffer.  Pings are answered with pongs and a
+        * close from the server is echoed before the socket closes.
+        * Messages larger than WEBSOCKET_MAX_MESSAGE_SIZE close the
+        * connection.
+        *
+        * @param message Set to the message payload, which remains valid
+        *      until the next call to read.  The payload is not null
+        *      terminated.
+        * @param length Set to the message payload length in bytes.
+        * @param opcode If not NULL, set to the message opcode,
+        *      WS_OPCODE_TEXT or WS_OPCODE_BINARY.
+        *
+        * @return true if a websocket message has been read
+        */
+        bool read(char ** message, int * length, uint8_t * opcode = NULL);
 
         /**
         * To see if there is a websocket connection active
@@ -108,7 +263,7 @@ class Websocket
         bool is_connected();
 
         /**
-        * Close the websocket connection
+        * Send a close frame and close the websocket connection
         *
         * @return true if the connection has been closed, false otherwise
         */
@@ -125,10 +280,17 @@ class Websocket
 
         void fillFields(char * url);
         int parseURL(const char* url, char* scheme, size_t maxSchemeLen, char* host, size_t maxHostLen, uint16_t* port, char* path, size_t maxPathLen); //Parse URL
+        int sendFrame(uint8_t opcode, const char * data, int len);
+        void fail(uint16_t status);
         int sendOpcode(uint8_t opcode, char * msg);
         int sendLength(uint32_t len, char * msg);
         int sendMask(char * msg);
-        int readChar(char * pC, bool block = true);
+        int sendRequest();
+        int sendHeader(uint8_t opcode, uint32_t len, char * msg, uint8_t * mask);
+        bool drainTx(bool block);
+        void queueRead(uint8_t * dst, int len);
+        void queueWrite(const uint8_t * src, int len);
+        void queueDropOldest();
         
         char scheme[8];
         uint16_t port;
@@ -137,8 +299,40 @@ class Websocket
         
         TCPSocketConnection socket;
 
-        int read(char * buf, int len, int min_len = -1);
         int write(char * buf, int len);
+        bool awaitAccept(uint32_t now);
+        bool retry(uint32_t now);
+        uint32_t now_ms();
+        bool parseMessage(char ** message, int * length, uint8_t * opcode);
+        void compact();
+
+        State ws_state;
+        ReconnectScheduler reconnect;
+        Timer clock;
+        uint32_t clock_ms;       // milliseconds since construction
+        uint32_t clock_us;       // microseconds not yet added to clock_ms
+        uint32_t handshake_start;
+        WsHandshake handshake;
+
+        WsParser parser;
+        WsReassembler reassembler;
+        uint8_t msg_buf[WEBSOCKET_MAX_MESSAGE_SIZE];
+        uint8_t rx_buf[WEBSOCKET_RX_BUFFER_SIZE];
+        char tx_buf[WEBSOCKET_TX_BUFFER_SIZE];
+        int tx_len;        // bytes staged in tx_buf
+        int tx_sent;       // staged bytes already accepted by the socket
+
+        uint8_t txq_buf[WEBSOCKET_TX_QUEUE_SIZE];
+        int txq_head;      // offset of the oldest queued byte
+        int txq_bytes;     // queued bytes including message headers
+        int txq_count;     // queued messages
+        uint32_t txq_dropped;
+        QueuePolicy txq_policy;
+        int txq_timeout_ms;
+        int rx_len;        // bytes received into rx_buf
+        int rx_pos;        // bytes consumed by the parser
+        int frame_start;   // offset of the current frame payload in rx_buf
+        bool frame_pending;
 };
 
 #endif
@@ -6,6 +6,8 @@
 #include "EthernetInterface.h"
 #include "Websocket.h"
 #include "APA102.h"
+#include "led_frame.h"
+#include "spsc_ring.h"
 
 DigitalOut led_red(LED_RED);
 DigitalOut led_green(LED_GREEN);
@@ -14,9 +16,60 @@ DigitalIn sw3(SW3);
 Serial pc(USBTX, USBRX);
 SPI spi(D11, D12, D13); // mosi, miso, sclk
 const int LED_COUNT = 60;
-APA102 apa102(LED_COUNT, &spi);
+const int FRAME_PERIOD_MS = 10;
+APA102 apa102(LED_COUNT, &spi, true);
+const uint8_t LED_DEVICE_ID = 1;  // LED frame device ID
+const uint8_t LED_STRIP_ID = 0;   // LED frame strip ID
 
-Mail<int, 16> mail_box;
+enum led_command_e {
+    CMD_MODE,   // value is the new mode
+    CMD_FRAME   // data holds an LED frame message of length bytes
+};
+
+/** A command from the network thread to led_thread. */
+struct LedCommand {
+    uint8_t type;     // led_command_e
+    uint8_t value;
+    uint16_t length;
+    uint8_t data[LED_FRAME_HEADER_SIZE + LED_COUNT * 3];
+};
+
+SpscRing<LedCommand, 8> led_commands;
+
+enum led_mode_e {MODE_OFF, MODE_ROTATE_HUE, MODE_STREAM};
+
+/** Apply the commands drained from led_commands in led_thread. */
+struct LedCommandHandler {
+    int mode;
+    float brightness;
+    LedFrameDecoder decoder;
+
+    LedCommandHandler()
+            : mode(MODE_OFF)
+            , brightness(0.0f)
+            , decoder(LED_DEVICE_ID, LED_STRIP_ID) {
+    }
+
+    void operator()(LedCommand & cmd) {
+        if (cmd.type == CMD_MODE) {
+            if (cmd.value) {
+                brightness = 1.0f;
+            }
+            mode = cmd.value ? MODE_ROTATE_HUE : MODE_OFF;
+            decoder.reset();
+        } else if (cmd.type == CMD_FRAME) {
+            // Frames are decoded into the back buffer which holds the
+            // published frame, see copyFront()
+            if (mode != MODE_STREAM) {
+                decoder.reset();
+            }
+            if (decoder.decode(cmd.data, cmd.length, apa102.getPixels(),
+                               apa102.numPixels(), &PIXEL_LAYOUT_APA102) > 0) {
+                mode = MODE_STREAM;
+            }
+        }
+    }
+};
 
 
 void led_thread(void const *argument)
@@ -24,7 +77,6 @@ void led_thread(void const *argument)
     float offset = 0.0f;
     const float iter_incr = 0.005f;
     const float led_incr = 1.0f / LED_COUNT;
-    float value = 0;
     
     spi.format(8, 0);
     spi.frequency(1000000);
@@ -32,36 +84,27 @@ void led_thread(void const *argument)
     apa102.setRGB(0, 255, 0, 0);
     apa102.setRGB(1, 0, 255, 0);
     apa102.setRGB(2, 0, 0, 255);
+    apa102.swap();
     apa102.refresh();
     Thread::wait(1000);
     
-    int mode = 0;
+    LedCommandHandler commands;
     const float BRIGHTNESS = 0.1f;
-    float brightness = BRIGHTNESS;
+    Timer frame_timer;
+    int frame_deadline = 0;
+    frame_timer.start();
     
     while (true) {
-        brightness = BRIGHTNESS;
+        commands.brightness = BRIGHTNESS;
         
-        osEvent evt = mail_box.get(0);
-        if (evt.status == osEventMail) {
-            int *mail = (int *) evt.value.p;
-            int mode_new = *mail;
-            mail_box.free(mail);
-            if (mode_new) {
-                brightness = 1.0f;
-            }
-            mode = mode_new;
-        }
+        // Apply every pending command with a single ring update
+        led_commands.drain(commands);
         
-        if (mode) {
-            value = offset;
-            for (int i = 0; i < LED_COUNT; ++i) {
-                apa102.setHSV(i, value, 1.0f, brightness);
-                value += led_incr;
-                if (value >= 1.0f) {
-                    value -= 1.0f;
-                }
-            }
+        if (commands.mode == MODE_STREAM) {
+            // the frames are already decoded into the back buffer
+        } else if (commands.mode == MODE_ROTATE_HUE) {
+            apa102.setHSVStrip(0, LED_COUNT, hsv_hue(offset), hsv_hue(led_incr),
+                               255, hsv_unit(commands.brightness));
             offset += iter_incr;
             if (offset >= 1.0f) {
                 offset -= 1.0f;
@@ -69,14 +112,67 @@ void led_thread(void const *argument)
         } else {
             apa102.clear();
         }
+        
+        // Publish the rendered frame once the previous transfer completes
+        while (!apa102.swap()) {
+            Thread::yield();
+        }
+        if (commands.mode == MODE_STREAM) {
+            apa102.copyFront();  // delta frames patch the published frame
+        }
+#if DEVICE_SPI_ASYNCH
+        apa102.refreshAsync();
+#else
         apa102.refresh();
-        Thread::wait(10);
+#endif
+
+        frame_deadline += FRAME_PERIOD_MS;
+        int remaining = frame_deadline - frame_timer.read_ms();
+        if (remaining > 0) {
+            Thread::wait(remaining);
+        } else {
+            frame_deadline = frame_timer.read_ms(); // overrun, resynchronize
+        }
+    }
+}
+
+
+/** Post a command to led_thread without blocking.
+ *
+ * @return The command to fill in and publish with led_commands.commit(),
+ *      or NULL if the ring is full.
+ */
+static LedCommand * led_command(uint8_t type) {
+    LedCommand * cmd = led_commands.write();
+    if (!cmd) {
+        return NULL;
+    }
+    cmd->type = type;
+    cmd->value = 0;
+    cmd->length = 0;
+    return cmd;
+}
+
+
+static bool msg_equals(const char * msg, int length, const char * str) {
+    return (length == (int) strlen(str)) && (memcmp(msg, str, length) == 0);
+}
+
+
+/** FNV-1a hash, used to give each device a different reconnect seed. */
+static uint32_t hash_str(const char * str) {
+    uint32_t h = 2166136261u;
+    while (*str) {
+        h = (h ^ (uint8_t) *str++) * 16777619u;
     }
+    return h;
 }
 
 
 int main() {
-    char recv[256];
+    char * recv;
+    int recv_len;
+    uint8_t recv_opcode;
  
     pc.baud(115200);
     pc.printf("FRDM-K64F booted.\r\n");
@@ -99,13 +195,17 @@ int main() {
     pc.printf("IP Address is %s\r\n", eth.getIPAddress());
  
     Websocket ws("ws://mcu_proto.jetperch.com/ws");
+    uint32_t seed = hash_str(eth.getMACAddress());
+    srand(seed);  // Sec-WebSocket-Key nonces
+    ws.setReconnect(500, 60000, seed);
  
     while (1) {
-        if (!ws.is_connected()) {
+        if (!ws.poll()) {
+            if (led_red == 1) {
+                pc.printf("Websocket not connected\r\n");
+            }
             led_red = 0;
-            pc.printf("Websocket not connected\r\n");
-            ws.connect();
-            wait(1.0);
+            wait(0.01);
             continue;
         }
         
@@ -116,17 +216,37 @@ int main() {
 
         led_red = 1;
         //ws.send("WebSocket Hello World over Ethernet");
-        if (ws.read(recv)) {
-            pc.printf("rcv: %s\r\n", recv);
-            if (strcmp(recv, "mbed_ON") == 0) {
+        if (ws.read(&recv, &recv_len, &recv_opcode)) {
+            if (recv_opcode == WS_OPCODE_BINARY) {
+                // LED frames stream quickly, so read again without waiting.
+                // A dropped frame makes the decoder wait for a keyframe.
+                LedCommand * cmd = NULL;
+                if (recv_len <= (int) sizeof(cmd->data)) {
+                    cmd = led_command(CMD_FRAME);
+                }
+                if (cmd) {
+                    memcpy(cmd->data, recv, recv_len);
+                    cmd->length = recv_len;
+                    led_commands.commit();
+                }
+                ws.flush();
+                continue;
+            }
+            pc.printf("rcv: %.*s\r\n", recv_len, recv);
+            if (msg_equals(recv, recv_len, "mbed_ON")) {
                 led_green = 1;
-            } else if (strcmp(recv, "mbed_OFF") == 0) {
+            } else if (msg_equals(recv, recv_len, "mbed_OFF")) {
                 led_green = 0;
             }
-            int *mail = mail_box.alloc();
-            *mail = led_green;
-            mail_box.put(mail);
+            LedCommand * cmd = led_command(CMD_MODE);
+            if (cmd) {
+                cmd->value = led_green;
+                led_commands.commit();
+            } else {
+                pc.printf("LED command dropped\r\n");
+            }
         }
+        ws.flush();
         pc.printf(".");
         wait(0.1);
     }
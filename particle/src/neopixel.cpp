@@ -38,8 +38,29 @@
 
 #include "neopixel.h"
 
+// Gamma 2.8 correction table used by the lossless brightness mode.
+static const uint8_t gamma8[256] = {
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,
+    1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,
+    2,  3,  3,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,  5,  5,  5,
+    5,  6,  6,  6,  6,  7,  7,  7,  7,  8,  8,  8,  9,  9,  9, 10,
+   10, 10, 11, 11, 11, 12, 12, 13, 13, 13, 14, 14, 15, 15, 16, 16,
+   17, 17, 18, 18, 19, 19, 20, 20, 21, 21, 22, 22, 23, 24, 24, 25,
+   25, 26, 27, 27, 28, 29, 29, 30, 31, 32, 32, 33, 34, 35, 35, 36,
+   37, 38, 39, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 50,
+   51, 52, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 66, 67, 68,
+   69, 70, 72, 73, 74, 75, 77, 78, 79, 81, 82, 83, 85, 86, 87, 89,
+   90, 92, 93, 95, 96, 98, 99,101,102,104,105,107,109,110,112,114,
+  115,117,119,120,122,124,126,127,129,131,133,135,137,138,140,142,
+  144,146,148,150,152,154,156,158,160,162,164,167,169,171,173,175,
+  177,180,182,184,186,189,191,193,196,198,200,203,205,208,210,213,
+  215,218,220,223,225,228,231,233,236,239,241,244,247,249,252,255
+};
+
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) : \
-  numLEDs(n), numBytes(n*3), type(t), pin(p), pixels(NULL)
+  numLEDs(n), numBytes(n*3), type(t), pin(p), brightness(0), pixels(NULL),
+  lut(NULL), gamma(false), maxIrqOffTime(0), endTime(0)
 {
   if((pixels = (uint8_t *)malloc(numBytes))) {
     memset(pixels, 0, numBytes);
@@ -48,6 +69,7 @@ Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) : \
 
 Adafruit_NeoPixel::~Adafruit_NeoPixel() {
   if(pixels) free(pixels);
+  if(lut) free(lut);
   pinMode(pin, INPUT);
 }
 
@@ -84,15 +106,68 @@ void Adafruit_NeoPixel::show(void) {
   // instances on different pins can be quickly issued in succession (each
   // instance doesn't delay the next).
 
-  __disable_irq(); // Need 100% focus on instruction timing
+  // Optionally split the strip into chunks so that interrupts are only
+  // disabled for maxIrqOffTime microseconds at a time.  Interrupts are
+  // briefly enabled between chunks while the data line idles.  If an
+  // interrupt handler holds the line idle for the full latch time, the
+  // strip latches the partial frame and the output restarts at the first
+  // pixel.  After SHOW_MAX_RESTARTS such restarts, the remainder of the
+  // frame is sent as a single chunk.
+  uint16_t chunkBytes = numBytes;
+  if(maxIrqOffTime) {
+    uint16_t chunkPixels = maxIrqOffTime / pixelTime();
+    if(chunkPixels < 1) chunkPixels = 1;
+    if((uint32_t)chunkPixels * 3 < numBytes) chunkBytes = chunkPixels * 3;
+  }
+
+  uint16_t offset = 0;
+  uint8_t  restarts = 0;
+  uint32_t chunkEnd = 0;
+  while(offset < numBytes) {
+    __disable_irq(); // Need 100% focus on instruction timing
+    if(offset && ((micros() - chunkEnd) >= wait_time)) {
+      // The strip may have latched.  micros() only resolves 1us, so hold
+      // the line idle until the latch is certain before restarting.
+      while((micros() - chunkEnd) <= wait_time);
+      offset = 0; // strip latched, restart at the first pixel
+      if(++restarts >= SHOW_MAX_RESTARTS) chunkBytes = numBytes;
+    }
+    uint16_t n = numBytes - offset;
+    if(n > chunkBytes) n = chunkBytes;
+    showBytes(pixels + offset, n);
+    chunkEnd = micros();
+    __enable_irq();
+    offset += n;
+  }
+  endTime = micros(); // Save EOD time for latch on next call
+}
+
+// Return the worst-case time to send one pixel in microseconds: 24 of the
+// slowest measured bits below plus about 0.5us to load the next pixel.
+uint16_t Adafruit_NeoPixel::pixelTime(void) const {
+  switch(type) {
+    case WS2811: // WS2811 = 2.5us per bit
+      return 61;
+    case TM1803: // TM1803 = 2.04us per bit
+      return 50;
+    case TM1829: // TM1829 = 1.111us per bit
+      return 28;
+    case WS2812B: // WS2812 & WS2812B = 1.264us per bit
+    default:
+      return 31;
+  }
+}
 
+// Send 'count' bytes with interrupts disabled by the caller.
+void Adafruit_NeoPixel::showBytes(uint8_t *data, uint16_t count) {
   volatile uint32_t 
     c,    // 24-bit pixel color
     mask; // 8-bit mask
-  volatile uint16_t i = numBytes; // Output loop counter
+  volatile uint16_t i = count; // Output loop counter
   volatile uint8_t
     j,              // 8-bit inner loop counter
-   *ptr = pixels,   // Pointer to next byte
+   *ptr = data,     // Pointer to next byte
+   *table = lut,    // Output brightness lookup table or NULL
     g,              // Current green byte value
     r,              // Current red byte value
     b;              // Current blue byte value
@@ -104,6 +179,7 @@ void Adafruit_NeoPixel::show(void) {
       g = *ptr++;   // Next green byte value
       r = *ptr++;   // Next red byte value
       b = *ptr++;   // Next blue byte value
+      if(table) { r = table[r]; g = table[g]; b = table[b]; } // Lossless brightness
       c = ((uint32_t)g << 16) | ((uint32_t)r <<  8) | b; // Pack the next 3 bytes to keep timing tight
       j = 0;        // reset the 24-bit counter
       do {
@@ -164,6 +240,7 @@ void Adafruit_NeoPixel::show(void) {
       r = *ptr++;   // Next red byte value
       g = *ptr++;   // Next green byte value
       b = *ptr++;   // Next blue byte value
+      if(table) { r = table[r]; g = table[g]; b = table[b]; } // Lossless brightness
       c = ((uint32_t)r << 16) | ((uint32_t)g <<  8) | b; // Pack the next 3 bytes to keep timing tight
       j = 0;        // reset the 24-bit counter
       do {
@@ -258,6 +335,7 @@ void Adafruit_NeoPixel::show(void) {
       r = *ptr++;   // Next green byte value
       g = *ptr++;   // Next red byte value
       b = *ptr++;   // Next blue byte value
+      if(table) { r = table[r]; g = table[g]; b = table[b]; } // Lossless brightness
       c = ((uint32_t)r << 16) | ((uint32_t)g <<  8) | b; // Pack the next 3 bytes to keep timing tight
       j = 0;        // reset the 24-bit counter
       do {
@@ -340,6 +418,7 @@ void Adafruit_NeoPixel::show(void) {
       r = *ptr++;   // Next red byte value
       b = *ptr++;   // Next blue byte value
       g = *ptr++;   // Next green byte value
+      if(table) { r = table[r]; g = table[g]; b = table[b]; } // Lossless brightness
       c = ((uint32_t)r << 16) | ((uint32_t)b <<  8) | g; // Pack the next 3 bytes to keep timing tight
       j = 0;        // reset the 24-bit counter
       PIN_MAP[pin].gpio_peripheral->BRR = PIN_MAP[pin].gpio_pin; // LOW
@@ -392,8 +471,6 @@ void Adafruit_NeoPixel::show(void) {
     } // end while(i) ... no more pixels
   }
 
-  __enable_irq();
-  endTime = micros(); // Save EOD time for latch on next call
 }
 
 // Set the output pin number
@@ -408,7 +485,7 @@ void Adafruit_NeoPixel::setPin(uint8_t p) {
 void Adafruit_NeoPixel::setPixelColor(
  uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
   if(n < numLEDs) {
-    if(brightness) { // See notes in setBrightness()
+    if(brightness && !lut) { // See notes in setBrightness()
       r = (r * brightness) >> 8;
       g = (g * brightness) >> 8;
       b = (b * brightness) >> 8;
@@ -444,7 +521,7 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
       r = (uint8_t)(c >> 16),
       g = (uint8_t)(c >>  8),
       b = (uint8_t)c;
-    if(brightness) { // See notes in setBrightness()
+    if(brightness && !lut) { // See notes in setBrightness()
       r = (r * brightness) >> 8;
       g = (g * brightness) >> 8;
       b = (b * brightness) >> 8;
@@ -500,6 +577,16 @@ uint16_t Adafruit_NeoPixel::numPixels(void) const {
   return numLEDs;
 }
 
+// Limit the time that show() disables interrupts, in microseconds.  The
+// strip is sent in chunks of whole pixels that each fit within this
+// window, with interrupts enabled between chunks.  Interrupt handlers
+// that run between chunks must finish within the latch time (50us for
+// WS2812) or the frame restarts.  0 (the default) disables interrupts for
+// the entire strip.
+void Adafruit_NeoPixel::setMaxInterruptOff(uint16_t us) {
+  maxIrqOffTime = us;
+}
+
 // Adjust output brightness; 0=darkest (off), 255=brightest.  This does
 // NOT immediately affect what's currently displayed on the LEDs.  The
 // next call to show() will refresh the LEDs at this level.  However,
@@ -512,7 +599,13 @@ uint16_t Adafruit_NeoPixel::numPixels(void) const {
 // the limited number of steps (quantization) in the old data will be
 // quite visible in the re-scaled version.  For a non-destructive
 // change, you'll need to re-render the full strip data.  C'est la vie.
+// Alternatively, setLosslessBrightness() scales on output instead.
 void Adafruit_NeoPixel::setBrightness(uint8_t b) {
+  if(lut) { // Lossless mode: only the output lookup table changes
+    brightness = b + 1;
+    updateLut();
+    return;
+  }
   // Stored brightness value is different than what's passed.
   // This simplifies the actual scaling math later, allowing a fast
   // 8x8-bit multiply and taking the MSB.  'brightness' is a uint8_t,
@@ -536,3 +629,39 @@ void Adafruit_NeoPixel::setBrightness(uint8_t b) {
     brightness = newBrightness;
   }
 }
+
+// Enable or disable lossless brightness.  When enabled, the 'pixels'
+// buffer always holds the unscaled colors and show() maps each byte
+// through a 256-entry gamma + brightness lookup table as it is issued.
+// setBrightness() then only rebuilds the table, which costs the same for
+// any strip length, and repeated brightness changes never lose color
+// precision.  Pass useGamma=false for a brightness-only table.  Colors
+// already in the buffer are used as is, so enable this mode before
+// setting any pixels.
+void Adafruit_NeoPixel::setLosslessBrightness(bool enable, bool useGamma) {
+  if(!enable) {
+    if(lut) {
+      free(lut);
+      lut = NULL;
+    }
+    return;
+  }
+  if(!lut && !(lut = (uint8_t *)malloc(256))) return;
+  gamma = useGamma;
+  updateLut();
+}
+
+// Get the output lookup table for lossless brightness, or NULL if disabled.
+// Pass to NeoPixelSpiEncoder::encode() to apply the same mapping.
+const uint8_t *Adafruit_NeoPixel::getOutputLut(void) const {
+  return lut;
+}
+
+void Adafruit_NeoPixel::updateLut(void) {
+  for(uint16_t i=0; i<256; i++) {
+    uint8_t c = gamma ? gamma8[i] : i;
+    if(brightness) c = (c * brightness) >> 8; // Same scaling as setPixelColor()
+    if((type == TM1829) && (c == 255)) c = 254; // See setPixelColor()
+    lut[i] = c;
+  }
+}
@@ -47,6 +47,9 @@
 #define WS2811   0x00 // 400 KHz datastream (NeoPixel)
 #define TM1803   0x03 // 400 KHz datastream (Radio Shack Tri-Color Strip)
 #define TM1829   0x04 // 800 KHz datastream ()
+
+// Maximum number of times show() restarts a chunked frame that latched early
+#define SHOW_MAX_RESTARTS 2
   
 class Adafruit_NeoPixel {
 
@@ -62,9 +65,13 @@ class Adafruit_NeoPixel {
     setPin(uint8_t p),
     setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b),
     setPixelColor(uint16_t n, uint32_t c),
-    setBrightness(uint8_t);
+    setBrightness(uint8_t),
+    setMaxInterruptOff(uint16_t us),
+    setLosslessBrightness(bool enable, bool useGamma=true);
   uint8_t
    *getPixels() const;
+  const uint8_t
+   *getOutputLut() const;
   uint16_t
     numPixels(void) const;
   static uint32_t
@@ -74,6 +81,13 @@ class Adafruit_NeoPixel {
 
  private:
 
+  void
+    showBytes(uint8_t *data, uint16_t count) __attribute__((optimize("Ofast")));
+  uint16_t
+    pixelTime(void) const;
+  void
+    updateLut(void);
+
   const uint16_t
     numLEDs,       // Number of RGB LEDs in strip
     numBytes;      // Size of 'pixels' buffer below
@@ -82,7 +96,12 @@ class Adafruit_NeoPixel {
   uint8_t
     pin,           // Output pin number
     brightness,
-   *pixels;        // Holds LED color values (3 bytes each)
+   *pixels,        // Holds LED color values (3 bytes each)
+   *lut;           // Lossless brightness output table or NULL
+  bool
+    gamma;         // Apply gamma correction in lut
+  uint16_t
+    maxIrqOffTime; // Max interrupt disable time in us, 0 = entire strip
   uint32_t
     endTime;       // Latch timing reference
 };
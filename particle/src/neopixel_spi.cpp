@@ -0,0 +1,75 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "neopixel_spi.h"
+#include <string.h>
+
+// The SPI "waveforms" for a zero or one data bit.
+static const uint8_t ZERO_8BIT = 0xC0;
+static const uint8_t ONE_8BIT = 0xF8;
+static const uint8_t ZERO_4BIT = 0x8;
+static const uint8_t ONE_4BIT = 0xC;
+
+// The precomputed waveforms for each color byte value, filled once.
+static uint8_t bits8_[256][8];
+static uint8_t bits4_[256][4];
+static bool initialized_ = false;
+
+NeoPixelSpiEncoder::NeoPixelSpiEncoder(Mode mode) : mode_(mode) {
+    initialize();
+}
+
+void NeoPixelSpiEncoder::initialize() {
+    if (initialized_) {
+        return;
+    }
+    for (int i = 0; i < 256; ++i) {
+        for (int k = 0; k < 8; ++k) {
+            bits8_[i][k] = (i & (0x80 >> k)) ? ONE_8BIT : ZERO_8BIT;
+        }
+        for (int k = 0; k < 4; ++k) {
+            uint8_t hi = (i & (0x80 >> (2 * k))) ? ONE_4BIT : ZERO_4BIT;
+            uint8_t lo = (i & (0x40 >> (2 * k))) ? ONE_4BIT : ZERO_4BIT;
+            bits4_[i][k] = (hi << 4) | lo;
+        }
+    }
+    initialized_ = true;
+}
+
+int NeoPixelSpiEncoder::bytesPerByte() const {
+    return (int) mode_;
+}
+
+int NeoPixelSpiEncoder::encodedSize(int length) const {
+    return length * bytesPerByte();
+}
+
+int NeoPixelSpiEncoder::encode(const uint8_t * pixels, int length,
+                               uint8_t * out, const uint8_t * lut) const {
+    if (mode_ == MODE_4BIT) {
+        for (int i = 0; i < length; ++i) {
+            uint8_t c = lut ? lut[pixels[i]] : pixels[i];
+            memcpy(out + i * 4, bits4_[c], 4);
+        }
+    } else {
+        for (int i = 0; i < length; ++i) {
+            uint8_t c = lut ? lut[pixels[i]] : pixels[i];
+            memcpy(out + i * 8, bits8_[c], 8);
+        }
+    }
+    return encodedSize(length);
+}
+
+int NeoPixelSpiEncoder::latchSize(uint32_t spi_hz, uint32_t latch_us) {
+    // bits = spi_hz * latch_us / 1e6, rounded up to whole bytes
+    uint32_t bits = (uint32_t) (((uint64_t) spi_hz * latch_us + 999999) / 1000000);
+    return (int) ((bits + 7) / 8);
+}
+
+int NeoPixelSpiEncoder::latch(uint8_t * out, uint32_t spi_hz,
+                              uint32_t latch_us) const {
+    int sz = latchSize(spi_hz, latch_us);
+    memset(out, 0, sz);
+    return sz;
+}
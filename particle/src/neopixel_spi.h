@@ -0,0 +1,101 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#ifndef NEOPIXEL_SPI_H
+#define NEOPIXEL_SPI_H
+
+#include <stdint.h>
+
+/** Encode NeoPixel color bytes into an SPI waveform.
+ *
+ * The NeoPixel one-wire protocol is emulated by sending each data bit as
+ * a fixed pattern of SPI bits on MOSI.  Since the SPI peripheral (usually
+ * with DMA) produces the timing, interrupts remain enabled while the
+ * strip updates, unlike Adafruit_NeoPixel::show().
+ *
+ * Like the Electric Imp NeoPixels class, each color byte is encoded by
+ * copying its precomputed waveform from a 256-entry table.  Two modes
+ * are supported:
+ *   - MODE_8BIT: 8 SPI bits per data bit with ZERO=0xC0 and ONE=0xF8.
+ *     Run SPI at 6.4 to 8 MHz.  Each color byte becomes 8 SPI bytes.
+ *   - MODE_4BIT: 4 SPI bits per data bit with ZERO=0x8 and ONE=0xC.
+ *     Run SPI at 3.2 MHz.  Each color byte becomes 4 SPI bytes.
+ *
+ * The color bytes must already be in wire order, such as the buffer
+ * returned by Adafruit_NeoPixel::getPixels().  Configure SPI for
+ * MSB first with MOSI idle low.
+ *
+ * Example:
+ * @code
+ * NeoPixelSpiEncoder encoder(NeoPixelSpiEncoder::MODE_4BIT);
+ * int sz = encoder.encode(strip.getPixels(), strip.numPixels() * 3, tx);
+ * sz += encoder.latch(tx + sz, 3200000, 50);
+ * SPI.transfer(tx, NULL, sz, on_done);
+ * @endcode
+ */
+class NeoPixelSpiEncoder {
+public:
+    enum Mode {
+        MODE_8BIT = 8,  // 8 SPI bits per data bit
+        MODE_4BIT = 4   // 4 SPI bits per data bit
+    };
+
+    /** Construct a new instance.
+     *
+     * The first instance fills the shared waveform tables.
+     *
+     * @param mode The encoding mode.
+     */
+    NeoPixelSpiEncoder(Mode mode = MODE_8BIT);
+
+    /** Get the number of SPI bytes produced for each color byte.
+     *
+     * @return 8 for MODE_8BIT or 4 for MODE_4BIT.
+     */
+    int bytesPerByte() const;
+
+    /** Get the encoded size.
+     *
+     * @param length The number of color bytes.
+     * @return The number of SPI bytes, excluding the latch.
+     */
+    int encodedSize(int length) const;
+
+    /** Encode color bytes.
+     *
+     * @param pixels The color bytes in wire order.
+     * @param length The number of color bytes.
+     * @param out The output buffer which must hold encodedSize(length) bytes.
+     * @param lut The optional 256-entry table applied to each color byte
+     *      before encoding, such as Adafruit_NeoPixel::getOutputLut().
+     * @return The number of SPI bytes written to out.
+     */
+    int encode(const uint8_t * pixels, int length, uint8_t * out,
+               const uint8_t * lut = 0) const;
+
+    /** Write the latch (reset) pulse.
+     *
+     * @param out The output buffer which receives the zero bytes.
+     * @param spi_hz The SPI clock frequency in Hz.
+     * @param latch_us The latch time in microseconds, such as 50 for the
+     *      WS2812.
+     * @return The number of SPI bytes written to out.
+     */
+    int latch(uint8_t * out, uint32_t spi_hz, uint32_t latch_us) const;
+
+    /** Get the latch length.
+     *
+     * @param spi_hz The SPI clock frequency in Hz.
+     * @param latch_us The latch time in microseconds.
+     * @return The number of zero bytes needed for the latch.
+     */
+    static int latchSize(uint32_t spi_hz, uint32_t latch_us);
+
+private:
+    static void initialize();
+
+    Mode mode_;
+};
+
+#endif // NEOPIXEL_SPI_H
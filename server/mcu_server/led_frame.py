@@ -0,0 +1,177 @@
+# Copyright 2015 Jetperch LLC
+# This file is licensed under the MIT License
+# http://opensource.org/licenses/MIT
+
+"""Encode binary LED frames for the devices.
+
+This module produces the frame format defined in common/led_frame.h.
+Send the result as a WebSocket binary message.
+"""
+
+import struct
+
+
+MAGIC = 0x4C
+HEADER = struct.Struct('>BBBBHHH')
+ID_ALL = 0xFF
+
+RGB888 = 0x0
+RGB565 = 0x1
+
+RAW = 0x0
+RLE = 0x1
+DELTA = 0x2
+
+OP_SKIP = 0x00
+OP_XOR = 0x40
+OP_REPEAT = 0x80
+OP_ROTATE = 0xC0
+
+RLE_MAX = 128
+DELTA_MAX = 64
+DELTA_SHIFT = 4
+
+
+def _pack(pixels, fmt):
+    """Convert (r, g, b) tuples to the wire bytes of each pixel."""
+    if fmt == RGB565:
+        return [struct.pack('>H', ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3))
+                for r, g, b in pixels]
+    return [bytes((r, g, b)) for r, g, b in pixels]
+
+
+def _values(pixels, fmt):
+    """Convert (r, g, b) tuples to the integer wire value of each pixel."""
+    return [int.from_bytes(v, 'big') for v in _pack(pixels, fmt)]
+
+
+def _rle(values):
+    """Encode the packed pixels as PackBits-style runs and literals."""
+    out = bytearray()
+    i = 0
+    n = len(values)
+    while i < n:
+        run = 1
+        while i + run < n and run < RLE_MAX and values[i + run] == values[i]:
+            run += 1
+        if run > 1:
+            out.append(0x80 | (run - 1))
+            out += values[i]
+            i += run
+            continue
+        start = i
+        while i < n and i - start < RLE_MAX:
+            if i > start and i + 1 < n and values[i + 1] == values[i]:
+                break  # a run starts at i
+            i += 1
+        out.append(i - start - 1)
+        for value in values[start:i]:
+            out += value
+    return bytes(out)
+
+
+def encode(pixels, sequence, device=ID_ALL, strip=ID_ALL, start=0,
+           fmt=RGB888, encoding=RLE):
+    """Encode a frame.
+
+    :param pixels: The list of (r, g, b) tuples with values from 0 to 255.
+    :param sequence: The frame sequence number from 0 to 65535.
+    :param device: The destination device ID or ID_ALL.
+    :param strip: The destination strip ID or ID_ALL.
+    :param start: The first pixel number.
+    :param fmt: The pixel format, RGB888 or RGB565.
+    :param encoding: RAW or RLE.  RLE frames which would be larger than
+        the raw pixels are sent as RAW instead.
+    :return: The frame bytes.
+    """
+    values = _pack(pixels, fmt)
+    body = b''.join(values)
+    if encoding == RLE and values:
+        rle = _rle(values)
+        if len(rle) < len(body):
+            body = rle
+        else:
+            encoding = RAW
+    else:
+        encoding = RAW
+    header = HEADER.pack(MAGIC, (fmt << 4) | encoding, device, strip,
+                         sequence & 0xffff, start, len(pixels))
+    return header + body
+
+
+def _best_shift(values, previous, max_shift):
+    """Find the rotation that leaves the most pixels unchanged."""
+    n = len(values)
+    max_shift = min(max_shift, n - 1)
+    best, best_score = 0, -1
+    # Try 0, 1, -1, 2, -2, ... so that ties favor the smallest shift
+    for k in range(2 * max_shift + 1):
+        shift = (k + 1) // 2 if k & 1 else -(k // 2)
+        score = sum(1 for i in range(n) if values[i] == previous[(i - shift) % n])
+        if score > best_score:
+            best, best_score = shift, score
+    return best
+
+
+def _delta(values, previous, shift, size):
+    """Encode the XOR patches against the rotated previous frame."""
+    n = len(values)
+    x = [values[i] ^ previous[(i - shift) % n] for i in range(n)]
+    out = bytearray()
+    if shift:
+        out += struct.pack('>Bh', OP_ROTATE, shift)
+    i = 0
+    while i < n:
+        run = 1
+        while i + run < n and run < DELTA_MAX and x[i + run] == x[i]:
+            run += 1
+        if not x[i]:
+            if i + run >= n:
+                break  # trailing pixels are unchanged
+            out.append(OP_SKIP | (run - 1))
+            i += run
+        elif run > 1:
+            out.append(OP_REPEAT | (run - 1))
+            out += x[i].to_bytes(size, 'big')
+            i += run
+        else:
+            start = i
+            while i < n and i - start < DELTA_MAX:
+                if i > start and (not x[i] or (i + 1 < n and x[i + 1] == x[i])):
+                    break
+                i += 1
+            out.append(OP_XOR | (i - start - 1))
+            for value in x[start:i]:
+                out += value.to_bytes(size, 'big')
+    return bytes(out)
+
+
+def encode_delta(pixels, previous, sequence, device=ID_ALL, strip=ID_ALL,
+                 start=0, fmt=RGB888, max_shift=DELTA_SHIFT):
+    """Encode a frame as a delta against the previous frame.
+
+    The device must have decoded previous with sequence - 1.  If the
+    delta is not smaller than the raw pixels, or previous is None, the
+    frame is encoded as a RLE keyframe instead.
+
+    :param pixels: The list of (r, g, b) tuples with values from 0 to 255.
+    :param previous: The pixels of the previous frame or None.
+    :param sequence: The frame sequence number from 0 to 65535.
+    :param device: The destination device ID or ID_ALL.
+    :param strip: The destination strip ID or ID_ALL.
+    :param start: The first pixel number.
+    :param fmt: The pixel format, RGB888 or RGB565.
+    :param max_shift: The maximum rotation to consider in pixels.
+    :return: The frame bytes.
+    """
+    size = 2 if fmt == RGB565 else 3
+    if previous is not None and pixels:
+        values = _values(pixels, fmt)
+        previous = _values(previous, fmt)
+        shift = _best_shift(values, previous, max_shift)
+        body = _delta(values, previous, shift, size)
+        if len(body) < len(pixels) * size:
+            header = HEADER.pack(MAGIC, (fmt << 4) | DELTA, device, strip,
+                                 sequence & 0xffff, start, len(pixels))
+            return header + body
+    return encode(pixels, sequence, device, strip, start, fmt, RLE)
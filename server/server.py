@@ -14,13 +14,17 @@ from ws4py.server.cherrypyserver import WebSocketPlugin, WebSocketTool
 from ws4py.websocket import WebSocket
 import yaml
 import os
+import colorsys
 from jinja2 import Environment, PackageLoader
 from collections import OrderedDict
+from mcu_server import led_frame
 
 
 MYDIR = os.path.dirname(os.path.abspath(__file__))
 AUTH_FILE = os.path.join(MYDIR, 'auth.yaml')
 STATIC_DIR = os.path.join(MYDIR, 'mcu_server', 'www', 'static')
+MBED_LED_DEVICE = 1   # LED_DEVICE_ID in frdm/frdm_fade/main.cpp
+MBED_LED_COUNT = 60
 
 
 def load_auth():
@@ -49,10 +53,10 @@ class Publisher(WebSocket):
         self.SUBSCRIBERS.remove(self)
     
     @staticmethod
-    def publish(msg):
-        print('publish(%s)' % (msg))
+    def publish(msg, binary=False):
+        print('publish(%s)' % ('[binary_data]' if binary else msg))
         for subscriber in Publisher.SUBSCRIBERS:
-            subscriber.send(msg)
+            subscriber.send(msg, binary)
 
 
 def electricimp(mode='OFF'):
@@ -80,6 +84,15 @@ def particle(mode='OFF'):
     requests.post(url, data=args)
 
     
+def rainbow(count, brightness=0.1):
+    """Get one hue cycle across count pixels as (r, g, b) tuples."""
+    pixels = []
+    for i in range(count):
+        r, g, b = colorsys.hsv_to_rgb(i / count, 1.0, brightness)
+        pixels.append((int(r * 255), int(g * 255), int(b * 255)))
+    return pixels
+
+
 class McuProtoServer(object):
     def __init__(self):
         # Map device identifier to a dict of configuration properties
@@ -89,6 +102,7 @@ class McuProtoServer(object):
         #   permission: The current public permission: true is enabled.
         #   OFF: The callable to turn off the device.
         #   ON: The callable to turn on the device.
+        #   FRAME: The optional callable to send the device an LED frame.
         self.devices = OrderedDict([
             ('ElectricImp', {
                 'name': 'Electric Imp',
@@ -120,9 +134,12 @@ class McuProtoServer(object):
                 'ide_url': 'http://developer.mbed.org/compiler/',
                 'permission': False,
                 'OFF': lambda: self.publish('mbed_OFF'),
-                'ON': lambda: self.publish('mbed_ON')
+                'ON': lambda: self.publish('mbed_ON'),
+                'FRAME': lambda: self.publish_frame(rainbow(MBED_LED_COUNT),
+                                                    MBED_LED_DEVICE)
             }),
         ])
+        self.frame_sequence = 0
         self.env = Environment(loader=PackageLoader('mcu_server', 'www'),
                                trim_blocks=True,
                                line_statement_prefix='@')
@@ -155,6 +172,13 @@ class McuProtoServer(object):
         Publisher.publish(msg)
         return "Done!"
 
+    def publish_frame(self, pixels, device):
+        """Send pixels to a device as a binary LED frame."""
+        frame = led_frame.encode(pixels, self.frame_sequence, device=device, strip=0)
+        self.frame_sequence = (self.frame_sequence + 1) & 0xffff
+        Publisher.publish(frame, binary=True)
+        return "Done!"
+
     @cherrypy.expose
     def auth(self, device=None):
         if device is None:
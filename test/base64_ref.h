@@ -0,0 +1,76 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** The character at a time Base64 codec previously bundled with the
+ * WebSocket clients, kept as the reference for common/Base64.cpp.
+ * Invalid characters decode as 0xFF, as they did then.
+ */
+
+#ifndef BASE64_REF_H
+#define BASE64_REF_H
+
+static const char base64_ref_alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static inline unsigned char base64_ref_lookup(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 71;
+    if (c >= '0' && c <= '9') return c + 4;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+static inline int base64_ref_encode(char * output, const char * input, int inputLen) {
+    int i = 0;
+    int encLen = 0;
+    unsigned char a3[3];
+    while (inputLen--) {
+        a3[i++] = *(input++);
+        if (i == 3 || !inputLen) {
+            int n = i;
+            for (; i < 3; i++) {
+                a3[i] = 0;
+            }
+            unsigned char a4[4] = {
+                (unsigned char) (a3[0] >> 2),
+                (unsigned char) (((a3[0] & 0x03) << 4) | (a3[1] >> 4)),
+                (unsigned char) (((a3[1] & 0x0f) << 2) | (a3[2] >> 6)),
+                (unsigned char) (a3[2] & 0x3f)};
+            for (int j = 0; j < 4; j++) {
+                output[encLen++] = (j <= n) ? base64_ref_alphabet[a4[j]] : '=';
+            }
+            i = 0;
+        }
+    }
+    output[encLen] = '\0';
+    return encLen;
+}
+
+static inline int base64_ref_decode(char * output, const char * input, int inputLen) {
+    int i = 0;
+    int decLen = 0;
+    unsigned char a4[4];
+    while (inputLen-- && (*input != '=')) {
+        a4[i++] = base64_ref_lookup(*(input++));
+        if (i == 4 || !inputLen || (*input == '=')) {
+            int n = i;
+            for (; i < 4; i++) {
+                a4[i] = base64_ref_lookup('\0');
+            }
+            unsigned char a3[3] = {
+                (unsigned char) ((a4[0] << 2) + ((a4[1] & 0x30) >> 4)),
+                (unsigned char) (((a4[1] & 0xf) << 4) + ((a4[2] & 0x3c) >> 2)),
+                (unsigned char) (((a4[2] & 0x3) << 6) + a4[3])};
+            for (int j = 0; j < n - 1; j++) {
+                output[decLen++] = a3[j];
+            }
+            i = 0;
+        }
+    }
+    output[decLen] = '\0';
+    return decLen;
+}
+
+#endif /* BASE64_REF_H */
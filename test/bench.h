@@ -0,0 +1,40 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Minimal timing for the host benchmarks.
+ *
+ * Host timings are noisy, so bench_seconds() reports the fastest of
+ * several runs.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <stdio.h>
+
+/** Keep a computed value from being optimized away. */
+static volatile unsigned bench_sink;
+
+/** Time the fastest of several runs.
+ *
+ * @param fn The function to time, called once per run.
+ * @param runs The number of runs.
+ * @return The fastest run in seconds.
+ */
+template <typename Fn>
+double bench_seconds(Fn fn, int runs = 5) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+        if (dt.count() < best) {
+            best = dt.count();
+        }
+    }
+    return best;
+}
+
+#endif /* BENCH_H */
@@ -0,0 +1,65 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Measure Base64 encode and decode throughput from 16 bytes to 1 MB
+ * against the character at a time codec it replaced.  Built once per
+ * SIMD level.  Rates are in MB/s of binary data.
+ */
+
+#include "Base64.h"
+#include "base64_ref.h"
+#include "simd.h"
+#include "bench.h"
+#include <vector>
+
+int main() {
+    if (!simd_supported()) {
+        printf("Base64 %s: not supported on this host, skipped\n", SIMD_NAME);
+        return 0;
+    }
+    static const int sizes[] = {16, 60, 256, 1024, 65536, 1 << 20};
+    const int total = 32 << 20;  // bytes per run
+    std::vector<char> binary((1 << 20) + 1);
+    for (size_t i = 0; i < binary.size(); ++i) {
+        binary[i] = (char) (i * 37);
+    }
+    std::vector<char> text(2 << 20);
+    std::vector<char> out((1 << 20) + 16);
+    // Offset by one byte so that the input is not aligned
+    char * b = &binary[1];
+    char * t = &text[0];
+    char * o = &out[0];
+
+    printf("Base64 %s, MB/s:\n", SIMD_NAME);
+    printf("  %8s %10s %10s %10s %10s\n", "size", "old enc", "encode", "old dec", "decode");
+    for (unsigned k = 0; k < sizeof(sizes) / sizeof(sizes[0]); ++k) {
+        int n = sizes[k];
+        int repeat = total / n;
+        int m = base64_encode(t, b, n);
+        double te_ref = bench_seconds([&]() {
+            for (int i = 0; i < repeat; ++i) {
+                bench_sink += base64_ref_encode(t, b, n);
+            }
+        });
+        double te = bench_seconds([&]() {
+            for (int i = 0; i < repeat; ++i) {
+                bench_sink += base64_encode(t, b, n);
+            }
+        });
+        double td_ref = bench_seconds([&]() {
+            for (int i = 0; i < repeat; ++i) {
+                bench_sink += base64_ref_decode(o, t, m);
+            }
+        });
+        double td = bench_seconds([&]() {
+            for (int i = 0; i < repeat; ++i) {
+                bench_sink += base64_decode(o, t, m);
+            }
+        });
+        double mb = (double) n * repeat / 1e6;
+        printf("  %8d %10.0f %10.0f %10.0f %10.0f\n", n, mb / te_ref, mb / te,
+               mb / td_ref, mb / td);
+    }
+    return 0;
+}
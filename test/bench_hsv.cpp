@@ -0,0 +1,60 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Compare the float and fixed-point HSV to RGB conversions. */
+
+#include "hsv.h"
+#include "hsv_float.h"
+#include "bench.h"
+
+const int PIXELS = 60;
+const int FRAMES = 20000;
+
+int main() {
+    static uint8_t buf[PIXELS * 4];
+
+    double floatTime = bench_seconds([&]() {
+        float hue = 0.0f;
+        for (int frame = 0; frame < FRAMES; ++frame) {
+            float h = hue;
+            for (int i = 0; i < PIXELS; ++i) {
+                hsv_to_rgb_float(h, 1.0f, 1.0f, buf + i * 3);
+                h += 1.0f / PIXELS;
+            }
+            hue += 0.001f;
+            hue = hue - floor(hue);
+            bench_sink += buf[frame % sizeof(buf)];
+        }
+    });
+
+    double fixedTime = bench_seconds([&]() {
+        uint16_t hue = 0;
+        for (int frame = 0; frame < FRAMES; ++frame) {
+            uint16_t h = hue;
+            for (int i = 0; i < PIXELS; ++i) {
+                hsv_to_rgb(h, 255, 255, buf + i * 3);
+                h += 65536 / PIXELS;
+            }
+            hue += 66;
+            bench_sink += buf[frame % sizeof(buf)];
+        }
+    });
+
+    double stripTime = bench_seconds([&]() {
+        uint16_t hue = 0;
+        for (int frame = 0; frame < FRAMES; ++frame) {
+            hsv_to_rgb_strip(hue, 65536 / PIXELS, 255, 255, buf, PIXELS,
+                             &PIXEL_LAYOUT_RGB);
+            hue += 66;
+            bench_sink += buf[frame % sizeof(buf)];
+        }
+    });
+
+    double pixels = (double) PIXELS * FRAMES;
+    printf("hsv %d-pixel strip:\n", PIXELS);
+    printf("  float       %8.2f Mpixels/s\n", pixels / floatTime / 1e6);
+    printf("  fixed       %8.2f Mpixels/s\n", pixels / fixedTime / 1e6);
+    printf("  fixed strip %8.2f Mpixels/s\n", pixels / stripTime / 1e6);
+    return 0;
+}
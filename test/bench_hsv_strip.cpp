@@ -0,0 +1,46 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Measure the batch HSV to RGB strip conversion at 1k, 100k and 10M
+ * pixels.  Built once per SIMD level.
+ */
+
+#include "hsv.h"
+#include "simd.h"
+#include "bench.h"
+#include <vector>
+
+int main() {
+    if (!simd_supported()) {
+        printf("hsv strip %s: not supported on this host, skipped\n",
+               SIMD_NAME);
+        return 0;
+    }
+    static const int sizes[] = {1000, 100000, 10000000};
+    static const struct {
+        const char * name;
+        const pixel_layout_s * layout;
+    } layouts[] = {
+        {"APA102", &PIXEL_LAYOUT_APA102},
+        {"GRB", &PIXEL_LAYOUT_GRB},
+    };
+    printf("hsv strip %s:\n", SIMD_NAME);
+    for (unsigned k = 0; k < sizeof(layouts) / sizeof(layouts[0]); ++k) {
+        for (unsigned n = 0; n < sizeof(sizes) / sizeof(sizes[0]); ++n) {
+            int count = sizes[n];
+            std::vector<uint8_t> buf(count * layouts[k].layout->stride);
+            int repeat = 10000000 / count;
+            double t = bench_seconds([&]() {
+                for (int i = 0; i < repeat; ++i) {
+                    hsv_to_rgb_strip((uint16_t) i, 7, 255, 200, &buf[0], count,
+                                     layouts[k].layout);
+                }
+                bench_sink += buf[count / 2];
+            });
+            printf("  %-6s %8d pixels %8.1f Mpixels/s\n", layouts[k].name,
+                   count, (double) count * repeat / t / 1e6);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Measure the LED frame delta encoding on a few animations: the frame
+ * size against RAW and RLE, and the decode time.
+ *
+ * Each animation is 100 frames of 60 and 1000 RGB888 pixels.  The first
+ * frame is a keyframe.  The decode time covers the whole sequence and is
+ * reported per pixel.
+ */
+
+#include "led_frame.h"
+#include "bench.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+const int FRAMES = 100;
+
+typedef void (*Animation)(uint8_t * rgb, int count, int frame);
+
+/** A rainbow scrolling by one pixel per frame. */
+static void scroll(uint8_t * rgb, int count, int frame) {
+    uint16_t step = (uint16_t) (65536 / count);
+    hsv_to_rgb_strip((uint16_t) (-frame * step), step, 255, 64, rgb, count, &PIXEL_LAYOUT_RGB);
+}
+
+/** A rainbow rotating its hue in place, which changes every pixel. */
+static void hue(uint8_t * rgb, int count, int frame) {
+    hsv_to_rgb_strip((uint16_t) (frame * 300), (uint16_t) (65536 / count), 255, 64, rgb, count,
+                     &PIXEL_LAYOUT_RGB);
+}
+
+/** A single dot moving along a dark strip. */
+static void dot(uint8_t * rgb, int count, int frame) {
+    memset(rgb, 0, 3 * count);
+    rgb[3 * (frame % count) + 2] = 255;
+}
+
+/** A few random pixels change per frame. */
+static void twinkle(uint8_t * rgb, int count, int frame) {
+    if (frame == 0) {
+        memset(rgb, 0, 3 * count);
+    }
+    for (int i = 0; i < 3; ++i) {
+        int k = rand() % count;
+        rgb[3 * k + 0] = (uint8_t) rand();
+        rgb[3 * k + 1] = (uint8_t) rand();
+        rgb[3 * k + 2] = (uint8_t) rand();
+    }
+}
+
+static void noise(uint8_t * rgb, int count, int) {
+    for (int i = 0; i < 3 * count; ++i) {
+        rgb[i] = (uint8_t) rand();
+    }
+}
+
+struct Encoded {
+    std::vector<std::vector<uint8_t> > frames;
+    long bytes;
+};
+
+/** Encode an animation with encoding, or as deltas with maxShift. */
+static Encoded encode(Animation animation, int count, uint8_t encoding, int maxShift) {
+    Encoded e;
+    e.bytes = 0;
+    LedFrameEncoder encoder(1, 0);
+    std::vector<uint8_t> rgb(3 * count);
+    std::vector<uint8_t> previous(3 * count);
+    std::vector<uint8_t> out(encoder.maxSize(count));
+    srand(1);
+    for (int f = 0; f < FRAMES; ++f) {
+        animation(&rgb[0], count, f);
+        int n;
+        if (encoding == LED_FRAME_DELTA) {
+            n = encoder.encodeDelta(&rgb[0], f ? &previous[0] : NULL, count,
+                                    &PIXEL_LAYOUT_RGB, &out[0], (int) out.size(), 0, maxShift);
+        } else {
+            n = encoder.encode(&rgb[0], count, &PIXEL_LAYOUT_RGB, &out[0], (int) out.size(),
+                               encoding);
+        }
+        e.frames.push_back(std::vector<uint8_t>(out.begin(), out.begin() + n));
+        e.bytes += n;
+        previous = rgb;
+    }
+    return e;
+}
+
+/** Decode the frames into an APA102 strip buffer, in ns per pixel. */
+static double decodeTime(const Encoded & e, int count) {
+    std::vector<uint8_t> strip(count * PIXEL_LAYOUT_APA102.stride);
+    LedFrameDecoder decoder(1, 0);
+    int repeat = 2000000 / (count * FRAMES) + 1;
+    int errors = 0;
+    double t = bench_seconds([&]() {
+        for (int i = 0; i < repeat; ++i) {
+            for (int f = 0; f < FRAMES; ++f) {
+                errors += decoder.decode(&e.frames[f][0], (uint32_t) e.frames[f].size(),
+                                         &strip[0], count, &PIXEL_LAYOUT_APA102) != count;
+            }
+        }
+        bench_sink += strip[count / 2];
+    });
+    if (errors) {
+        printf("decode failed\n");
+    }
+    return t * 1e9 / ((double) count * FRAMES * repeat);
+}
+
+int main() {
+    static const struct {
+        const char * name;
+        Animation animation;
+    } animations[] = {
+        {"scroll", scroll}, {"hue", hue}, {"dot", dot}, {"twinkle", twinkle}, {"noise", noise}};
+    static const int counts[] = {60, 1000};
+
+    printf("LED frame deltas, %d frames, bytes per frame and decode ns/pixel:\n", FRAMES);
+    printf("  %-8s %5s %7s %7s %7s %7s %6s %8s %8s %8s\n", "", "count", "RAW", "RLE",
+           "DELTA 0", "DELTA 4", "ratio", "RAW ns", "RLE ns", "DELTA ns");
+    for (unsigned a = 0; a < sizeof(animations) / sizeof(animations[0]); ++a) {
+        for (unsigned n = 0; n < sizeof(counts) / sizeof(counts[0]); ++n) {
+            int count = counts[n];
+            Encoded raw = encode(animations[a].animation, count, LED_FRAME_RAW, 0);
+            Encoded rle = encode(animations[a].animation, count, LED_FRAME_RLE, 0);
+            Encoded delta0 = encode(animations[a].animation, count, LED_FRAME_DELTA, 0);
+            Encoded delta = encode(animations[a].animation, count, LED_FRAME_DELTA,
+                                   LED_FRAME_DELTA_SHIFT);
+            printf("  %-8s %5d %7ld %7ld %7ld %7ld %5.1fx %8.2f %8.2f %8.2f\n",
+                   animations[a].name, count, raw.bytes / FRAMES, rle.bytes / FRAMES,
+                   delta0.bytes / FRAMES, delta.bytes / FRAMES,
+                   (double) raw.bytes / delta.bytes, decodeTime(raw, count),
+                   decodeTime(rle, count), decodeTime(delta, count));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Measure LED frame decoding straight into the strip buffer, for each
+ * pixel format and encoding, into the APA102 and NeoPixel layouts.
+ * Frames hold 60 pixels, the FRDM strip, and 1000 pixels.
+ */
+
+#include "led_frame.h"
+#include "bench.h"
+#include <stdlib.h>
+#include <vector>
+
+struct Pattern {
+    const char * name;
+    void (*fill)(uint8_t * rgb, int count);
+};
+
+static void solid(uint8_t * rgb, int count) {
+    for (int i = 0; i < count; ++i) {
+        rgb[3 * i + 0] = 20;
+        rgb[3 * i + 1] = 0;
+        rgb[3 * i + 2] = 40;
+    }
+}
+
+static void rainbow(uint8_t * rgb, int count) {
+    hsv_to_rgb_strip(0, (uint16_t) (65536 / count), 255, 64, rgb, count, &PIXEL_LAYOUT_RGB);
+}
+
+/** A few lit pixels on a dark strip. */
+static void sparse(uint8_t * rgb, int count) {
+    for (int i = 0; i < 3 * count; ++i) {
+        rgb[i] = 0;
+    }
+    for (int i = 0; i < count; i += 10) {
+        rgb[3 * i + 1] = 255;
+    }
+}
+
+static void noise(uint8_t * rgb, int count) {
+    for (int i = 0; i < 3 * count; ++i) {
+        rgb[i] = (uint8_t) rand();
+    }
+}
+
+int main() {
+    static const Pattern patterns[] = {
+        {"solid", solid}, {"sparse", sparse}, {"rainbow", rainbow}, {"noise", noise}};
+    static const struct {
+        const char * name;
+        uint8_t format;
+        uint8_t encoding;
+    } codings[] = {
+        {"RGB888 RAW", LED_FRAME_RGB888, LED_FRAME_RAW},
+        {"RGB888 RLE", LED_FRAME_RGB888, LED_FRAME_RLE},
+        {"RGB565 RAW", LED_FRAME_RGB565, LED_FRAME_RAW},
+        {"RGB565 RLE", LED_FRAME_RGB565, LED_FRAME_RLE},
+    };
+    static const struct {
+        const char * name;
+        const pixel_layout_s * layout;
+    } layouts[] = {
+        {"APA102", &PIXEL_LAYOUT_APA102},
+        {"GRB", &PIXEL_LAYOUT_GRB},
+    };
+    static const int counts[] = {60, 1000};
+    const int total = 20000000;  // pixels per run
+
+    printf("LED frame decode to strip, ns/pixel:\n");
+    printf("  %-7s %5s %-11s %6s", "pattern", "count", "encoding", "bytes");
+    for (unsigned l = 0; l < sizeof(layouts) / sizeof(layouts[0]); ++l) {
+        printf(" %7s", layouts[l].name);
+    }
+    printf("\n");
+    for (unsigned p = 0; p < sizeof(patterns) / sizeof(patterns[0]); ++p) {
+        for (unsigned n = 0; n < sizeof(counts) / sizeof(counts[0]); ++n) {
+            int count = counts[n];
+            std::vector<uint8_t> rgb(3 * count);
+            srand(1);
+            patterns[p].fill(&rgb[0], count);
+            for (unsigned c = 0; c < sizeof(codings) / sizeof(codings[0]); ++c) {
+                LedFrameEncoder encoder(1, 0, codings[c].format);
+                std::vector<uint8_t> frame(encoder.maxSize(count));
+                int length = encoder.encode(&rgb[0], count, &PIXEL_LAYOUT_RGB, &frame[0],
+                                            (int) frame.size(), codings[c].encoding);
+                printf("  %-7s %5d %-11s %6d", patterns[p].name, count, codings[c].name,
+                       length);
+                for (unsigned l = 0; l < sizeof(layouts) / sizeof(layouts[0]); ++l) {
+                    const pixel_layout_s * layout = layouts[l].layout;
+                    std::vector<uint8_t> strip(count * layout->stride);
+                    LedFrameDecoder decoder(1, 0);
+                    int repeat = total / count;
+                    double t = bench_seconds([&]() {
+                        for (int i = 0; i < repeat; ++i) {
+                            bench_sink += decoder.decode(&frame[0], length, &strip[0],
+                                                         count, layout);
+                        }
+                    });
+                    printf(" %7.2f", t * 1e9 / ((double) count * repeat));
+                }
+                printf("\n");
+            }
+        }
+    }
+    return 0;
+}
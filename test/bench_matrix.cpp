@@ -0,0 +1,55 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Measure a MOD-LED8x8RGB frame with the original drawing code and with
+ * the MatrixFramebuffer version: draw a line, a rectangle, a character
+ * and a pixel, scroll left and pack to the wire format.
+ *
+ * The original drawPixel() only maps up to 2 panel rows, so it is only
+ * timed for those tilings.
+ */
+
+#include "matrix_api.h"
+#include "bench.h"
+#include <stdio.h>
+
+const int FRAMES = 20000;
+const int WIDTH = bigX * 8;
+const int HEIGHT = bigY * 8;
+
+static double frameMicroseconds(MatrixTestLib * m) {
+    double t = bench_seconds([m]() {
+        for (int f = 0; f < FRAMES; ++f) {
+            int x = f % WIDTH;
+            m->setColor((uint8_t) (1 + f % 7));
+            m->drawLine(1, 1 + f % HEIGHT, WIDTH, HEIGHT - f % HEIGHT);
+            m->drawRectangle(x + 1, 2, x + 6, HEIGHT - 1);
+            m->drawChar((unsigned char) ('A' + f % 26), WIDTH - 5, 1);
+            m->drawPixel(x + 1, HEIGHT);
+            m->lScroll();
+            m->pack();
+        }
+        bench_sink += m->video()[0];
+    });
+    return t * 1e6 / FRAMES;
+}
+
+int main() {
+    MatrixTestLib * old = matrix_old();
+    MatrixTestLib * lib = matrix_new();
+    char tiling[16];
+    snprintf(tiling, sizeof(tiling), "%dx%d", bigX, bigY);
+    double n = frameMicroseconds(lib);
+    if (bigY <= 2) {
+        double o = frameMicroseconds(old);
+        printf("matrix %-5s %5d pixels: old %7.2f us/frame, new %7.2f us/frame, %.2fx\n",
+               tiling, WIDTH * HEIGHT, o, n, o / n);
+    } else {
+        printf("matrix %-5s %5d pixels: old       - us/frame, new %7.2f us/frame\n",
+               tiling, WIDTH * HEIGHT, n);
+    }
+    delete old;
+    delete lib;
+    return 0;
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Measure SHA-1 throughput from 16 bytes to 1 MB, through update() and
+ * through the byte at a time write() used by the Print interface.
+ */
+
+#include "sha1.h"
+#include "bench.h"
+#include <vector>
+
+int main() {
+    static const uint32_t sizes[] = {16, 60, 64, 256, 1024, 65536, 1 << 20};
+    const uint32_t total = 32 << 20;  // bytes per run
+    std::vector<uint8_t> data((1 << 20) + 1);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = (uint8_t) (i * 37);
+    }
+    // Offset by one byte so that the input is not aligned
+    const uint8_t * d = &data[1];
+    Sha1Class s;
+
+    printf("sha1, MB/s:\n");
+    printf("  %8s %10s %10s\n", "size", "update", "write");
+    for (unsigned k = 0; k < sizeof(sizes) / sizeof(sizes[0]); ++k) {
+        uint32_t n = sizes[k];
+        uint32_t repeat = total / n;
+        double tu = bench_seconds([&]() {
+            for (uint32_t i = 0; i < repeat; ++i) {
+                s.init();
+                s.update(d, n);
+                bench_sink += s.result()[0];
+            }
+        });
+        double tw = bench_seconds([&]() {
+            for (uint32_t i = 0; i < repeat; ++i) {
+                s.init();
+                for (uint32_t j = 0; j < n; ++j) {
+                    s.write(d[j]);
+                }
+                bench_sink += s.result()[0];
+            }
+        });
+        double mb = (double) n * repeat / 1e6;
+        printf("  %8u %10.0f %10.0f\n", n, mb / tu, mb / tw);
+    }
+    return 0;
+}
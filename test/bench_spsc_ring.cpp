@@ -0,0 +1,129 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Measure the SpscRing transfer rate between two std::threads against a
+ * bounded queue guarded by a mutex and condition variables, which is how
+ * an RTOS Mail box passes messages.
+ *
+ * The records are 32 bytes, like a small LED command.  The producer
+ * pushes and the consumer pops one record at a time.  The ring threads
+ * spin briefly before they yield on a full or empty ring, or yield
+ * immediately when the host has a single core.  The slower cases send
+ * fewer records to keep the run short.
+ */
+
+#include "spsc_ring.h"
+#include "bench.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct Record {
+    uint32_t id;
+    uint32_t data[7];
+};
+
+static uint32_t records;  // records per run
+static int spins;
+
+/** Wait for the other thread after a failed poll. */
+static void backoff(int & n) {
+    if (++n > spins) {
+        std::this_thread::yield();
+        n = 0;
+    }
+}
+
+template <uint32_t N>
+static void ring() {
+    static SpscRing<Record, N> ring;
+    std::thread producer([]() {
+        Record r = Record();
+        int n = 0;
+        for (uint32_t id = 0; id < records; ) {
+            r.id = id;
+            if (ring.push(r)) {
+                ++id;
+            } else {
+                backoff(n);
+            }
+        }
+    });
+    uint32_t sum = 0;
+    Record r;
+    int n = 0;
+    for (uint32_t i = 0; i < records; ) {
+        if (ring.pop(&r)) {
+            sum += r.id;
+            ++i;
+        } else {
+            backoff(n);
+        }
+    }
+    producer.join();
+    bench_sink = sum;
+}
+
+/** A Mail<Record, N> stand-in. */
+template <uint32_t N>
+class LockedQueue {
+public:
+    void put(const Record & r) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this]() { return items_.size() < N; });
+        items_.push_back(r);
+        notEmpty_.notify_one();
+    }
+
+    Record get() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this]() { return !items_.empty(); });
+        Record r = items_.front();
+        items_.pop_front();
+        notFull_.notify_one();
+        return r;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+    std::deque<Record> items_;
+};
+
+template <uint32_t N>
+static void locked() {
+    LockedQueue<N> queue;
+    std::thread producer([&queue]() {
+        Record r = Record();
+        for (uint32_t id = 0; id < records; ++id) {
+            r.id = id;
+            queue.put(r);
+        }
+    });
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < records; ++i) {
+        sum += queue.get().id;
+    }
+    producer.join();
+    bench_sink = sum;
+}
+
+static void report(const char * name, void (*fn)(), uint32_t count) {
+    records = count;
+    double t = bench_seconds(fn, 3);
+    printf("  %-22s %7.2f M records/s\n", name, records / t / 1e6);
+}
+
+int main() {
+    unsigned cores = std::thread::hardware_concurrency();
+    spins = (cores > 1) ? 1000 : 0;
+    printf("SPSC transfer, records of %u bytes, %u cores:\n", (unsigned) sizeof(Record), cores);
+    report("SpscRing<Record, 8>", ring<8>, 4000000);
+    report("SpscRing<Record, 256>", ring<256>, 20000000);
+    report("locked queue of 8", locked<8>, 1000000);
+    report("locked queue of 256", locked<256>, 4000000);
+    return 0;
+}
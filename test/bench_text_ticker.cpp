@@ -0,0 +1,103 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Measure scrolling text in columns per second, without the SPI
+ * transfer.
+ *
+ * The original scrollCharLeft() draws each glyph column at the end of the
+ * chain and scrolls the whole display once per column.  TextTicker draws
+ * the visible window of the pre-rendered text with draw() at each step.
+ * Both pack the frame to the wire format at each step, as Transfer()
+ * does.  The ticker is timed for the whole strip, with fixed and with
+ * proportional spacing, and for a window over the top panel row, as on a
+ * wall with a ticker line.  The whole strip is also timed with step(),
+ * which scrolls the framebuffer and draws the incoming column, as
+ * scrollString() does.  The original drawPixel() only maps up to 2
+ * panel rows, so it is only timed for those tilings.
+ */
+
+#include "matrix_api.h"
+#include "matrix_fb.h"
+#include "text_ticker.h"
+#include "font.h"
+#include "bench.h"
+#include <stdio.h>
+#include <string.h>
+
+const char TEXT[] = "The quick brown fox jumps over the lazy dog 0123456789";
+const int CHARS = sizeof(TEXT) - 1;
+const int WIDTH = bigX * 8;
+const int HEIGHT = bigY * 8;
+
+/** Scroll TEXT as the original scrollCharLeft() does. */
+static double oldColumns(MatrixTestLib * m) {
+    int columns = 0;
+    double t = bench_seconds([m, &columns]() {
+        columns = 0;
+        for (int c = 0; c < CHARS; ++c) {
+            m->setColor((uint8_t) (1 + c % 7));
+            for (int k = 0; k < 6; ++k) {
+                unsigned char b = (k < 5) ? FontLookup[TEXT[c] - 32][k] : 0;
+                for (int i = 0; i < 8; ++i) {
+                    if (b & (1 << i)) {
+                        m->drawPixel(WIDTH, i + 1 + HEIGHT - 8);
+                    }
+                }
+                m->pack();
+                m->lScroll();
+                ++columns;
+            }
+        }
+    });
+    return columns / t;
+}
+
+/** Scroll TEXT with TextTicker over width strip columns, with draw() at
+ * each position or with step() after the first.
+ */
+static double tickerColumns(bool proportional, int width, bool step = false) {
+    static MatrixFramebuffer<bigX, bigY> fb;
+    static TextTicker ticker(FontLookup, proportional);
+    static uint8_t wire[bigX * bigY * 24];
+    ticker = TextTicker(FontLookup, proportional);
+    for (int c = 0; c < CHARS; ++c) {
+        ticker.append(TEXT[c], (uint8_t) (1 + c % 7));
+    }
+    int columns = 0;
+    double t = bench_seconds([&columns, width, step]() {
+        columns = 0;
+        ticker.draw(fb, -width, 0, width);
+        for (int p = 1 - width; p <= ticker.length(); ++p) {
+            if (step) {
+                ticker.step(fb, p, false);
+            } else {
+                ticker.draw(fb, p, 0, width);
+            }
+            fb.pack(wire);
+            ++columns;
+        }
+        bench_sink += wire[0];
+    });
+    return columns / t;
+}
+
+int main() {
+    MatrixTestLib * old = matrix_old();
+    char tiling[16];
+    snprintf(tiling, sizeof(tiling), "%dx%d", bigX, bigY);
+    const int stride = MatrixFramebuffer<bigX, bigY>::STRIDE;
+    double fixed = tickerColumns(false, stride);
+    double proportional = tickerColumns(true, stride);
+    double step = tickerColumns(false, stride, true);
+    double row = tickerColumns(false, WIDTH);
+    char o[16] = "     -";
+    if (bigY <= 2) {
+        snprintf(o, sizeof(o), "%6.2f", oldColumns(old) * 1e-6);
+    }
+    printf("text %-5s M columns/s: old %s, ticker %6.2f, proportional %6.2f, step %6.2f, "
+           "top row %6.2f\n", tiling, o, fixed * 1e-6, proportional * 1e-6, step * 1e-6,
+           row * 1e-6);
+    delete old;
+    return 0;
+}
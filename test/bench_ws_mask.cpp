@@ -0,0 +1,62 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Measure WebSocket masking throughput from 16 bytes to 1 MB, in place
+ * and while copying, against the byte-at-a-time loop it replaced.  Built
+ * once per SIMD level.
+ */
+
+#include "ws_mask.h"
+#include "simd.h"
+#include "bench.h"
+#include <vector>
+
+static void mask_bytes(uint8_t * data, uint32_t length, const uint8_t * mask) {
+    for (uint32_t i = 0; i < length; ++i) {
+        data[i] ^= mask[i % 4];
+    }
+}
+
+int main() {
+    if (!simd_supported()) {
+        printf("ws_mask %s: not supported on this host, skipped\n", SIMD_NAME);
+        return 0;
+    }
+    static const uint32_t sizes[] = {16, 64, 256, 1024, 4096, 65536, 1 << 20};
+    static const uint8_t mask[4] = {0x37, 0xfa, 0x21, 0x3d};
+    const uint32_t total = 64 << 20;  // bytes per run
+    std::vector<uint8_t> src((1 << 20) + 1, 0x55);
+    std::vector<uint8_t> dst((1 << 20) + 1);
+
+    printf("ws_mask %s, MB/s:\n", SIMD_NAME);
+    printf("  %8s %10s %10s %10s\n", "size", "byte loop", "in place", "copy");
+    for (unsigned k = 0; k < sizeof(sizes) / sizeof(sizes[0]); ++k) {
+        uint32_t n = sizes[k];
+        uint32_t repeat = total / n;
+        // Offset by one byte so that the buffers are not aligned
+        uint8_t * s = &src[1];
+        uint8_t * d = &dst[1];
+        double tb = bench_seconds([&]() {
+            for (uint32_t i = 0; i < repeat; ++i) {
+                mask_bytes(s, n, mask);
+            }
+            bench_sink += s[n / 2];
+        });
+        double ti = bench_seconds([&]() {
+            for (uint32_t i = 0; i < repeat; ++i) {
+                ws_mask(s, n, mask, (uint8_t) i);
+            }
+            bench_sink += s[n / 2];
+        });
+        double tc = bench_seconds([&]() {
+            for (uint32_t i = 0; i < repeat; ++i) {
+                ws_mask_copy(d, s, n, mask, (uint8_t) i);
+            }
+            bench_sink += d[n / 2];
+        });
+        double mb = (double) n * repeat / 1e6;
+        printf("  %8u %10.0f %10.0f %10.0f\n", n, mb / tb, mb / ti, mb / tc);
+    }
+    return 0;
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** The floating point HSV to RGB conversion previously used by
+ * APA102::setHSV() and hsv2rgb() in the Particle sketch, kept as the
+ * reference for the integer kernel in hsv.h.
+ */
+
+#ifndef HSV_FLOAT_H
+#define HSV_FLOAT_H
+
+#include <math.h>
+#include <stdint.h>
+
+static inline void hsv_to_rgb_float(float h, float s, float v, uint8_t * rgb) {
+    if (s == 0.0f) {
+        int a = int(floor(255 * v + 0.5f));
+        rgb[0] = rgb[1] = rgb[2] = (uint8_t) a;
+        return;
+    }
+    h = h - floor(h);
+    h = h * 6.0f;
+    int i = int(floor(h));
+    float f = h - i; // fractional part of h
+    float xf = v * (1.0f - s);
+    float yf = v * (1.0f - s * f);
+    float zf = v * (1.0f - s * (1.0f - f));
+    uint8_t x = uint8_t(floor(255 * xf + 0.5f));
+    uint8_t y = uint8_t(floor(255 * yf + 0.5f));
+    uint8_t z = uint8_t(floor(255 * zf + 0.5f));
+    uint8_t w = uint8_t(floor(255 * v + 0.5f));
+    switch (i) {
+        case 0:  rgb[0] = w; rgb[1] = z; rgb[2] = x; break;
+        case 1:  rgb[0] = y; rgb[1] = w; rgb[2] = x; break;
+        case 2:  rgb[0] = x; rgb[1] = w; rgb[2] = z; break;
+        case 3:  rgb[0] = x; rgb[1] = y; rgb[2] = w; break;
+        case 4:  rgb[0] = z; rgb[1] = x; rgb[2] = w; break;
+        case 5:  rgb[0] = w; rgb[1] = x; rgb[2] = y; break;
+        default: rgb[0] = 0; rgb[1] = 0; rgb[2] = 0; break;
+    }
+}
+
+#endif /* HSV_FLOAT_H */
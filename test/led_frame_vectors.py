@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+# Copyright 2015 Jetperch LLC
+# This file is licensed under the MIT License
+# http://opensource.org/licenses/MIT
+
+"""Write the frames that server/mcu_server/led_frame.py produces for a
+set of fixed pixel vectors, as keyframes and as deltas against a
+previous frame, as a C header.
+
+test_led_frame encodes the same pixels with LedFrameEncoder and checks
+that the bytes match.
+
+Usage: led_frame_vectors.py > led_frame_vectors.h
+"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..', 'server'))
+from mcu_server import led_frame  # noqa: E402
+
+
+def noise(n, seed):
+    """Deterministic pseudo-random pixels."""
+    x = seed
+    out = []
+    for _ in range(n):
+        p = []
+        for _ in range(3):
+            x = (x * 1103515245 + 12345) & 0x7fffffff
+            p.append((x >> 16) & 0xff)
+        out.append(tuple(p))
+    return out
+
+
+def runs(lengths):
+    """Runs of the given lengths, each a new color."""
+    out = []
+    for k, n in enumerate(lengths):
+        out += [((k * 40) & 0xff, (k * 70 + 5) & 0xff, (255 - k * 30) & 0xff)] * n
+    return out
+
+
+def ramp(n):
+    return [(i & 0xff, (2 * i) & 0xff, (255 - i) & 0xff) for i in range(n)]
+
+
+def near(n):
+    """Colors which differ only in the bits that RGB565 drops."""
+    return [(0x80 | (i & 7), 0x40 | (i & 3), 0x20 | (i & 7)) for i in range(n)]
+
+
+# name, pixels, format, encoding, device, strip, sequence, start
+VECTORS = [
+    ('empty', [], led_frame.RGB888, led_frame.RLE, 1, 0, 0, 0),
+    ('single', [(1, 2, 3)], led_frame.RGB888, led_frame.RLE, 1, 0, 1, 0),
+    ('single_565', [(255, 128, 7)], led_frame.RGB565, led_frame.RAW, 1, 0, 2, 0),
+    ('runs', runs([1, 2, 3, 130, 1, 129, 5, 1, 1]), led_frame.RGB888, led_frame.RLE,
+     3, 2, 258, 7),
+    ('runs_565', runs([4, 1, 200, 2]), led_frame.RGB565, led_frame.RLE,
+     led_frame.ID_ALL, led_frame.ID_ALL, 3, 0),
+    ('near_565', near(90), led_frame.RGB565, led_frame.RLE, 1, 0, 4, 0),
+    ('solid', [(9, 8, 7)] * 300, led_frame.RGB888, led_frame.RLE, 1, 0, 5, 0),
+    ('ramp', ramp(300), led_frame.RGB888, led_frame.RLE, 1, 0, 6, 0),
+    ('noise', noise(200, 1), led_frame.RGB888, led_frame.RLE, 1, 0, 7, 0),
+    ('noise_raw', noise(60, 2), led_frame.RGB888, led_frame.RAW, 1, 0, 8, 0),
+    ('noise_565', noise(60, 3), led_frame.RGB565, led_frame.RLE, 1, 0, 9, 1000),
+]
+
+
+def c_bytes(data):
+    data = bytes(data)
+    if not data:
+        return '{0}'
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append('    ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+    return '{\n' + '\n'.join(lines) + '\n}'
+
+
+def rotate(pixels, shift):
+    n = len(pixels)
+    return [pixels[(i - shift) % n] for i in range(n)]
+
+
+def patch(pixels, changes):
+    """Replace pixels, changes is a list of (index, (r, g, b))."""
+    out = list(pixels)
+    for i, p in changes:
+        out[i] = p
+    return out
+
+
+_BASE = noise(200, 4)
+_RUNS = runs([150, 3, 70, 1, 200])
+
+# name, pixels, previous, format, device, strip, sequence, start, max_shift
+DELTA_VECTORS = [
+    ('delta_same', _BASE, _BASE, led_frame.RGB888, 1, 0, 10, 0, 4),
+    ('delta_sparse', patch(_BASE, [(0, (1, 2, 3)), (70, (4, 5, 6)), (199, (7, 8, 9))]), _BASE,
+     led_frame.RGB888, 1, 0, 11, 0, 4),
+    ('delta_rotate_pos', patch(rotate(_BASE, 3), [(5, (0, 0, 0))]), _BASE,
+     led_frame.RGB888, 1, 0, 12, 5, 4),
+    ('delta_rotate_neg', rotate(_BASE, -2), _BASE, led_frame.RGB565, 1, 0, 13, 0, 4),
+    ('delta_no_rotate', rotate(_BASE, 3), _BASE, led_frame.RGB888, 1, 0, 14, 0, 0),
+    ('delta_runs', runs([150, 3, 70, 1, 200]), patch(_RUNS, [(i, (9, 9, 9)) for i in range(300, 380)]
+                                                   + [(i, (i & 0xff, 1, 2)) for i in range(160, 224)]),
+     led_frame.RGB888, 1, 0, 15, 0, 4),
+    ('delta_runs_565', _RUNS, patch(_RUNS, [(i, (i & 0xff, 1, 2)) for i in range(0, 140)]),
+     led_frame.RGB565, 1, 0, 16, 0, 4),
+    ('delta_keyframe', noise(100, 5), noise(100, 6), led_frame.RGB888, 1, 0, 17, 0, 4),
+]
+
+
+def main():
+    print('// Generated by led_frame_vectors.py from server/mcu_server/led_frame.py')
+    print()
+    rows = []
+    for name, pixels, fmt, encoding, device, strip, sequence, start in VECTORS:
+        frame = led_frame.encode(pixels, sequence, device, strip, start, fmt, encoding)
+        rgb = bytes(c for p in pixels for c in p)
+        print('static const uint8_t %s_pixels[] = %s;' % (name, c_bytes(rgb)))
+        print('static const uint8_t %s_frame[] = %s;' % (name, c_bytes(frame)))
+        print()
+        rows.append('    {"%s", %d, %d, %d, %d, %d, %d, %d, %s_pixels, NULL, 0, %s_frame, %d},' % (
+            name, fmt, encoding, device, strip, sequence, start, len(pixels),
+            name, name, len(frame)))
+    for name, pixels, previous, fmt, device, strip, sequence, start, max_shift in DELTA_VECTORS:
+        frame = led_frame.encode_delta(pixels, previous, sequence, device, strip, start, fmt,
+                                       max_shift)
+        rgb = bytes(c for p in pixels for c in p)
+        prev = bytes(c for p in previous for c in p)
+        print('static const uint8_t %s_pixels[] = %s;' % (name, c_bytes(rgb)))
+        print('static const uint8_t %s_previous[] = %s;' % (name, c_bytes(prev)))
+        print('static const uint8_t %s_frame[] = %s;' % (name, c_bytes(frame)))
+        print()
+        rows.append('    {"%s", %d, %d, %d, %d, %d, %d, %d, %s_pixels, %s_previous, %d, '
+                    '%s_frame, %d},' % (
+                        name, fmt, led_frame.DELTA, device, strip, sequence, start,
+                        len(pixels), name, name, max_shift, name, len(frame)))
+    print('static const LedFrameVector LED_FRAME_VECTORS[] = {')
+    print('\n'.join(rows))
+    print('};')
+
+
+if __name__ == '__main__':
+    main()
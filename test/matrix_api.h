@@ -0,0 +1,79 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** A common interface to the original MOD-LED8x8RGB drawing code in
+ * lcd8x8rgb_old.h and to the MatrixFramebuffer version in
+ * cc3200_energia/Fade/lcd8x8rgb.h, so that the same operations run
+ * against both.
+ *
+ * Each version is compiled in its own source file, matrix_old.cpp or
+ * matrix_new.cpp, since the two define the same globals.  The panel
+ * counts bigX and bigY are set for the whole program, and each version
+ * has a single instance per program.  The original
+ * drawPixel() only maps bigY up to 2 correctly, and its
+ * scrollCharRight() never returns.
+ */
+
+#ifndef MATRIX_API_H
+#define MATRIX_API_H
+
+#include <stdint.h>
+#include <vector>
+
+class MatrixTestLib {
+public:
+    virtual ~MatrixTestLib() {}
+
+    virtual const char * name() const = 0;
+
+    /** The packed frame size in bytes. */
+    virtual int wireSize() const = 0;
+
+    virtual void setColor(uint8_t color) = 0;
+    virtual void vClear() = 0;
+    virtual void drawPixel(int x, int y) = 0;
+    virtual void drawLine(int x1, int y1, int x2, int y2) = 0;
+    virtual void drawRectangle(int x1, int y1, int x2, int y2) = 0;
+    virtual void drawSolidRectangle(int x1, int y1, int x2, int y2) = 0;
+    virtual void drawEllipse(int x, int y, int rx, int ry) = 0;
+    virtual void drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3) = 0;
+
+    /** Draw a character with its top left corner at x, y. */
+    virtual void drawChar(unsigned char c, int x, int y) = 0;
+
+    /** Scroll a string across the display with scrollString().
+     *
+     * The original never returns for right scrolling.
+     */
+    virtual void scrollString(const char * text, bool right) = 0;
+
+    virtual void lScroll() = 0;
+    virtual void rScroll() = 0;
+
+    /** Convert the frame to the wire format, as Transfer() does. */
+    virtual void pack() = 0;
+
+    /** Send the frame to the panels with Transfer(). */
+    virtual void transfer() = 0;
+
+    /** Let Transfer() resend only part of the chain, if supported. */
+    virtual void setPartialTransfer(bool enable) = 0;
+
+    /** Get the current frame in the wire format.
+     *
+     * This leaves the state used by Transfer() unchanged.
+     */
+    virtual std::vector<uint8_t> video() = 0;
+
+    /** The bytes held by the panels, see stubs/energia/SPI.h. */
+    virtual const std::vector<uint8_t> & chain() = 0;
+
+    /** The bytes sent to the panels since construction. */
+    virtual unsigned long spiBytes() = 0;
+};
+
+MatrixTestLib * matrix_old();
+MatrixTestLib * matrix_new();
+
+#endif /* MATRIX_API_H */
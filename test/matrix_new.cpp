@@ -0,0 +1,73 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "matrix_api.h"
+#include <Arduino.h>
+#include <SPI.h>
+#include "font.h"
+#include "matrix_fb.h"
+#include "text_ticker.h"
+
+namespace new_lcd {
+#include "lcd8x8rgb.h"
+}
+
+class NewMatrix : public MatrixTestLib {
+public:
+    NewMatrix() {
+        SPI.chain.assign(sizeof(new_lcd::videobuf), 0);
+        SPI.bytes = 0;
+        new_lcd::vClear();
+    }
+
+    const char * name() const { return "new"; }
+    int wireSize() const { return sizeof(new_lcd::videobuf); }
+
+    void setColor(uint8_t color) { new_lcd::color = color; }
+    void vClear() { new_lcd::vClear(); }
+    void drawPixel(int x, int y) { new_lcd::drawPixel(x, y); }
+    void drawLine(int x1, int y1, int x2, int y2) { new_lcd::drawLine(x1, y1, x2, y2); }
+    void drawRectangle(int x1, int y1, int x2, int y2) {
+        new_lcd::drawRectangle(x1, y1, x2, y2);
+    }
+    void drawSolidRectangle(int x1, int y1, int x2, int y2) {
+        new_lcd::drawSolidRectangle(x1, y1, x2, y2);
+    }
+    void drawEllipse(int x, int y, int rx, int ry) { new_lcd::drawEllipse(x, y, rx, ry); }
+    void drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3) {
+        new_lcd::drawTriangle(x1, y1, x2, y2, x3, y3);
+    }
+
+    void drawChar(unsigned char c, int x, int y) {
+        new_lcd::cX = x;
+        new_lcd::cY = y;
+        new_lcd::drawChar(c);
+    }
+
+    void scrollString(const char * text, bool right) {
+        new_lcd::scrollString((unsigned char *) text, right);
+    }
+
+    void lScroll() { new_lcd::lScroll(); }
+    void rScroll() { new_lcd::rScroll(); }
+    void pack() { new_lcd::framebuf.pack(new_lcd::videobuf); }
+    void transfer() { new_lcd::Transfer(); }
+    void setPartialTransfer(bool enable) { new_lcd::partialTransfer = enable; }
+
+    std::vector<uint8_t> video() {
+        // Pack a copy, since pack() clears the dirty flags that Transfer() uses
+        MatrixFramebuffer<bigX, bigY> fb = new_lcd::framebuf;
+        std::vector<uint8_t> wire(sizeof(new_lcd::videobuf));
+        fb.markDirty();
+        fb.pack(&wire[0]);
+        return wire;
+    }
+
+    const std::vector<uint8_t> & chain() { return SPI.chain; }
+    unsigned long spiBytes() { return SPI.bytes; }
+};
+
+MatrixTestLib * matrix_new() {
+    return new NewMatrix();
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "matrix_api.h"
+#include <Arduino.h>
+#include <SPI.h>
+#include "font.h"
+
+namespace old_lcd {
+#include "lcd8x8rgb_old.h"
+}
+
+class OldMatrix : public MatrixTestLib {
+public:
+    OldMatrix() {
+        SPI.chain.assign(sizeof(old_lcd::videobuf), 0);
+        SPI.bytes = 0;
+        old_lcd::vClear();
+    }
+
+    const char * name() const { return "old"; }
+    int wireSize() const { return sizeof(old_lcd::videobuf); }
+
+    void setColor(uint8_t color) { old_lcd::color = color; }
+    void vClear() { old_lcd::vClear(); }
+    void drawPixel(int x, int y) { old_lcd::drawPixel(x, y); }
+    void drawLine(int x1, int y1, int x2, int y2) { old_lcd::drawLine(x1, y1, x2, y2); }
+    void drawRectangle(int x1, int y1, int x2, int y2) {
+        old_lcd::drawRectangle(x1, y1, x2, y2);
+    }
+    void drawSolidRectangle(int x1, int y1, int x2, int y2) {
+        old_lcd::drawSolidRectangle(x1, y1, x2, y2);
+    }
+    void drawEllipse(int x, int y, int rx, int ry) { old_lcd::drawEllipse(x, y, rx, ry); }
+    void drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3) {
+        old_lcd::drawTriangle(x1, y1, x2, y2, x3, y3);
+    }
+
+    void drawChar(unsigned char c, int x, int y) {
+        old_lcd::cX = x;
+        old_lcd::cY = y;
+        old_lcd::drawChar(c);
+    }
+
+    void scrollString(const char * text, bool right) {
+        old_lcd::scrollString((unsigned char *) text, right);
+    }
+
+    void lScroll() { old_lcd::lScroll(); }
+    void rScroll() { old_lcd::rScroll(); }
+    void pack() {}  // the original draws straight into the wire format
+    void transfer() { old_lcd::Transfer(); }
+    void setPartialTransfer(bool enable) { (void) enable; }
+
+    std::vector<uint8_t> video() {
+        return std::vector<uint8_t>(old_lcd::videobuf,
+                                    old_lcd::videobuf + sizeof(old_lcd::videobuf));
+    }
+
+    const std::vector<uint8_t> & chain() { return SPI.chain; }
+    unsigned long spiBytes() { return SPI.bytes; }
+};
+
+MatrixTestLib * matrix_old() {
+    return new OldMatrix();
+}
@@ -0,0 +1,237 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Timing model of the NeoPixel data line for Adafruit_NeoPixel::show().
+ *
+ * The driver is compiled against stubs/application.h, which routes GPIO
+ * writes, asm delay blocks, micros() and the interrupt controls here.
+ * Each data bit is decoded from its delay block, since a one and a zero
+ * use different delays, and advances a simulated clock by the bit times
+ * measured on the Spark Core, as listed in the neopixel.cpp comments.
+ * Loading each pixel adds NEOPIXEL_LOAD_NS.
+ * micros() reads the simulated clock with the 1 us resolution of the
+ * hardware.  Every interrupt-off window is recorded, and an interrupt
+ * handler of configurable length runs each time interrupts are enabled.
+ *
+ * The strip side of the model splits the bit stream at every idle gap of
+ * at least the latch time: each piece is one frame as the strip latched
+ * it.
+ *
+ * Include this header in exactly one source file of a test program.
+ */
+
+#ifndef NEOPIXEL_SIM_H
+#define NEOPIXEL_SIM_H
+
+#include "neopixel.h"
+#include <vector>
+
+/** The bit timing of a pixel type in nanoseconds.
+ *
+ * Each bit has two phases: high then low, or low then high for the
+ * inverted TM1829.
+ */
+struct NeoPixelTiming {
+    const char * name;
+    uint8_t type;
+    double spec[2][2];      // [bit][phase] from the datasheet
+    double measured[2][2];  // [bit][phase] measured on the Spark Core
+    uint32_t latchUs;       // the reset time
+};
+
+static const NeoPixelTiming NEOPIXEL_TIMING[] = {
+    {"WS2812", WS2812B, {{350, 800}, {700, 600}}, {{306, 932}, {792, 472}}, 50},
+    {"WS2811", WS2811, {{500, 2000}, {1200, 1300}}, {{500, 2000}, {1250, 1250}}, 50},
+    {"TM1803", TM1803, {{680, 1360}, {1360, 680}}, {{680, 1360}, {1360, 670}}, 24},
+    {"TM1829", TM1829, {{300, 800}, {800, 300}}, {{306, 805}, {792, 319}}, 500},
+};
+
+/** The datasheet tolerance of each phase in nanoseconds. */
+const double NEOPIXEL_TOLERANCE_NS = 150.0;
+
+/** The simulated cost of one micros() call in nanoseconds. */
+const double NEOPIXEL_MICROS_NS = 20.0;
+
+/** The assumed time to load each pixel in nanoseconds, about 36 cycles at
+ * 72 MHz.  The measured bit times do not include it.
+ */
+const double NEOPIXEL_LOAD_NS = 500.0;
+
+struct NeoPixelBit {
+    int value;
+    double start;
+    double end;
+};
+
+struct NeoPixelWindow {
+    double start;
+    double end;
+    int bits;
+};
+
+struct NeoPixelSim {
+    const NeoPixelTiming * timing;
+    double now;                 // the simulated time in ns
+    double isrNs;               // the interrupt handler time
+    int keyOne;                 // the delay block length of a one bit
+    int keyZero;                // the delay block length of a zero bit
+    bool calibrating;
+    std::vector<int> keys;      // the delay block of each bit, calibrating
+    std::vector<int> pending;   // events: -1 high, -2 low, else delay
+    std::vector<NeoPixelBit> bits;
+    std::vector<NeoPixelWindow> windows;
+    bool irqOff;
+    double irqOffStart;
+    size_t irqOffBits;
+
+    double bitTime(int value) const {
+        return timing->measured[value][0] + timing->measured[value][1];
+    }
+
+    /** The worst-case time to send one pixel in ns. */
+    double pixelTime() const {
+        double slow = (bitTime(1) > bitTime(0)) ? bitTime(1) : bitTime(0);
+        return 24 * slow + NEOPIXEL_LOAD_NS;
+    }
+
+    /** Decode the pending events into bits and advance the clock. */
+    void flush() {
+        bool inverted = (timing->type == TM1829);
+        for (size_t i = 1; i < pending.size(); ++i) {
+            int key;
+            if (!inverted && (pending[i - 1] == -1) && (pending[i] >= 0)) {
+                key = pending[i];      // the high time follows the rise
+            } else if (inverted && (pending[i - 1] >= 0) && (pending[i] == -1)) {
+                key = pending[i - 1];  // the low time precedes the rise
+            } else {
+                continue;
+            }
+            if (calibrating) {
+                keys.push_back(key);
+                continue;
+            }
+            if ((bits.size() % 24) == 0) {
+                now += NEOPIXEL_LOAD_NS;
+            }
+            NeoPixelBit bit;
+            bit.value = (key == keyOne) ? 1 : 0;
+            bit.start = now;
+            now += bitTime(bit.value);
+            bit.end = now;
+            bits.push_back(bit);
+        }
+        pending.clear();
+    }
+
+    /** Start a new run, keeping the clock and calibration. */
+    void reset(double isr = 0.0) {
+        isrNs = isr;
+        pending.clear();
+        bits.clear();
+        windows.clear();
+        irqOff = false;
+    }
+
+    /** Split the received bit stream into latched frames. */
+    std::vector<std::vector<uint8_t> > frames() const {
+        std::vector<std::vector<uint8_t> > rv;
+        std::vector<uint8_t> frame;
+        uint8_t value = 0;
+        int count = 0;
+        for (size_t i = 0; i < bits.size(); ++i) {
+            if (i && (bits[i].start - bits[i - 1].end >= timing->latchUs * 1000.0)) {
+                rv.push_back(frame);
+                frame.clear();
+                count = 0;
+            }
+            value = (uint8_t) ((value << 1) | bits[i].value);
+            if (++count == 8) {
+                frame.push_back(value);
+                count = 0;
+            }
+        }
+        if (!bits.empty()) {
+            rv.push_back(frame);
+        }
+        return rv;
+    }
+};
+
+static NeoPixelSim neopixel_sim;
+static GPIO_t neopixel_gpio_port;
+pinmap_t PIN_MAP[] = {{&neopixel_gpio_port, 1}, {&neopixel_gpio_port, 2},
+                      {&neopixel_gpio_port, 4}, {&neopixel_gpio_port, 8}};
+
+void neopixel_gpio(bool high) {
+    neopixel_sim.pending.push_back(high ? -1 : -2);
+}
+
+void neopixel_asm(const char * text) {
+    int n = 0;
+    for (const char * p = strstr(text, "nop"); p; p = strstr(p + 1, "nop")) {
+        ++n;
+    }
+    neopixel_sim.pending.push_back(n);
+}
+
+uint32_t micros() {
+    neopixel_sim.flush();
+    neopixel_sim.now += NEOPIXEL_MICROS_NS;
+    return (uint32_t) (neopixel_sim.now / 1000.0);
+}
+
+void __disable_irq() {
+    neopixel_sim.flush();
+    neopixel_sim.irqOff = true;
+    neopixel_sim.irqOffStart = neopixel_sim.now;
+    neopixel_sim.irqOffBits = neopixel_sim.bits.size();
+}
+
+void __enable_irq() {
+    neopixel_sim.flush();
+    if (neopixel_sim.irqOff) {
+        NeoPixelWindow w;
+        w.start = neopixel_sim.irqOffStart;
+        w.end = neopixel_sim.now;
+        w.bits = (int) (neopixel_sim.bits.size() - neopixel_sim.irqOffBits);
+        neopixel_sim.windows.push_back(w);
+        neopixel_sim.irqOff = false;
+    }
+    neopixel_sim.now += neopixel_sim.isrNs;
+}
+
+/** Select the pixel type and learn its one and zero delay blocks.
+ *
+ * @return True on success.
+ */
+static bool neopixel_sim_select(const NeoPixelTiming * timing) {
+    neopixel_sim.timing = timing;
+    neopixel_sim.calibrating = true;
+    neopixel_sim.keys.clear();
+    neopixel_sim.reset();
+    {
+        Adafruit_NeoPixel strip(1, 0, timing->type);
+        uint8_t * p = strip.getPixels();
+        p[0] = 0x80;
+        p[1] = 0;
+        p[2] = 0;
+        strip.show();
+    }
+    neopixel_sim.calibrating = false;
+    std::vector<int> & keys = neopixel_sim.keys;
+    if ((keys.size() != 24) || (keys[0] == keys[1])) {
+        return false;
+    }
+    for (size_t i = 2; i < keys.size(); ++i) {
+        if (keys[i] != keys[1]) {
+            return false;
+        }
+    }
+    neopixel_sim.keyOne = keys[0];
+    neopixel_sim.keyZero = keys[1];
+    neopixel_sim.reset();
+    return true;
+}
+
+#endif /* NEOPIXEL_SIM_H */
@@ -0,0 +1,38 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Discard stdout for the lifetime of an instance.
+ *
+ * The mbed Websocket prints every connection with printf, which would
+ * bury the test results.
+ */
+
+#ifndef QUIET_STDOUT_H
+#define QUIET_STDOUT_H
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+class QuietStdout {
+public:
+    QuietStdout() {
+        fflush(stdout);
+        saved_ = dup(1);
+        int fd = open("/dev/null", O_WRONLY);
+        dup2(fd, 1);
+        close(fd);
+    }
+
+    ~QuietStdout() {
+        fflush(stdout);
+        dup2(saved_, 1);
+        close(saved_);
+    }
+
+private:
+    int saved_;
+};
+
+#endif /* QUIET_STDOUT_H */
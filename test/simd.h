@@ -0,0 +1,40 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Name and check the SIMD level a host test was compiled for.
+ *
+ * The Makefile builds some tests and benchmarks once per SIMD level.  An
+ * AVX2 build skips itself on a host without AVX2.
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#if defined(SIMD_NAME)
+// set by the Makefile, such as for a build with SIMD disabled
+#elif defined(__AVX2__)
+#define SIMD_NAME "avx2"
+#elif defined(__SSSE3__)
+#define SIMD_NAME "ssse3"
+#elif defined(__SSE2__)
+#define SIMD_NAME "sse2"
+#else
+#define SIMD_NAME "scalar"
+#endif
+
+/** Check that the host supports the compiled SIMD level.
+ *
+ * @return True if the program can run.
+ */
+static inline bool simd_supported() {
+#if defined(__AVX2__)
+    return __builtin_cpu_supports("avx2");
+#elif defined(__SSSE3__)
+    return __builtin_cpu_supports("ssse3");
+#else
+    return true;
+#endif
+}
+
+#endif /* SIMD_H */
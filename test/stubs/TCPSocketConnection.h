@@ -0,0 +1,57 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Host stand-in for the mbed TCP socket, backed by mock_net(). */
+
+#ifndef TCPSOCKETCONNECTION_H
+#define TCPSOCKETCONNECTION_H
+
+#include "mock_net.h"
+
+class TCPSocketConnection {
+public:
+    void set_blocking(bool blocking, unsigned int timeout = 1500) {
+        (void) blocking; (void) timeout;
+    }
+
+    int connect(const char * host, const int port) {
+        (void) host; (void) port;
+        return mock_net().connect() ? 0 : -1;
+    }
+
+    bool is_connected() {
+        return mock_net().connected;
+    }
+
+    int send(char * data, int length) {
+        return mock_net().write((const uint8_t *) data, length);
+    }
+
+    int send_all(char * data, int length) {
+        return mock_net().write((const uint8_t *) data, length);
+    }
+
+    /** @return The bytes received, 0 if the server closed the connection
+     *      or -1 when no data is available.
+     */
+    int receive(char * data, int length) {
+        MockNet & net = mock_net();
+        if (!net.connected) {
+            return 0;
+        }
+        int n = net.read((uint8_t *) data, length);
+        if (n > 0) {
+            return n;
+        }
+        return net.connected ? -1 : 0;
+    }
+
+    int close(bool shutdown = true) {
+        (void) shutdown;
+        mock_net().close();
+        return 0;
+    }
+};
+
+#endif /* TCPSOCKETCONNECTION_H */
@@ -0,0 +1,60 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Host stand-in for the parts of the Particle firmware used by the
+ * NeoPixel driver.
+ *
+ * The GPIO set and reset registers, micros() and the interrupt controls
+ * call hooks which the test defines, so that a test can model the data
+ * line.  The Makefile compiles neopixel.cpp with each inline asm delay
+ * block replaced by NEOPIXEL_ASM(), which passes the instruction text to
+ * the neopixel_asm() hook.
+ */
+
+#ifndef APPLICATION_H
+#define APPLICATION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUT 0
+#define OUTPUT 1
+#define LOW 0
+#define HIGH 1
+
+static inline void pinMode(int pin, int mode) { (void) pin; (void) mode; }
+static inline void digitalWrite(int pin, int value) { (void) pin; (void) value; }
+
+// Hooks defined by the test
+void neopixel_gpio(bool high);
+void neopixel_asm(const char * text);
+uint32_t micros();
+void __disable_irq();
+void __enable_irq();
+
+#define NEOPIXEL_ASM(...) neopixel_asm(#__VA_ARGS__)
+
+struct GpioSet {
+    void operator=(uint32_t pin) { (void) pin; neopixel_gpio(true); }
+};
+
+struct GpioReset {
+    void operator=(uint32_t pin) { (void) pin; neopixel_gpio(false); }
+};
+
+struct GPIO_t {
+    GpioSet BSRR;
+    GpioReset BRR;
+};
+
+struct pinmap_t {
+    GPIO_t * gpio_peripheral;
+    uint32_t gpio_pin;
+};
+
+extern pinmap_t PIN_MAP[];
+
+#endif /* APPLICATION_H */
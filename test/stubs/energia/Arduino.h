@@ -0,0 +1,97 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Host stand-in for the parts of the Energia core used by the libraries
+ * and sketches.
+ *
+ * Serial discards its output and the pins do nothing.  millis(), delay()
+ * and delayMicroseconds() use the simulated clock in mock_net.h.
+ * host_delay_count() counts the delay() calls, which lets a test count
+ * the steps of sketch code that waits once per step, and delay() calls
+ * host_delay_hook(), if set, to inspect each step.
+ */
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mock_net.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) { (void) baud; }
+
+    template <typename T>
+    size_t print(const T & value) { (void) value; return 0; }
+
+    template <typename T>
+    size_t println(const T & value) { (void) value; return 0; }
+
+    size_t println() { return 0; }
+};
+
+static HardwareSerial Serial __attribute__((unused));
+
+static inline unsigned long millis() {
+    return (unsigned long) (host_clock_us() / 1000);
+}
+
+static inline unsigned long micros() {
+    return (unsigned long) host_clock_us();
+}
+
+inline unsigned long & host_delay_count() {
+    static unsigned long n = 0;
+    return n;
+}
+
+typedef void (*HostDelayHook)();
+
+inline HostDelayHook & host_delay_hook() {
+    static HostDelayHook hook = 0;
+    return hook;
+}
+
+static inline void delay(unsigned long ms) {
+    host_clock_us() += (uint64_t) ms * 1000;
+    ++host_delay_count();
+    if (host_delay_hook()) {
+        host_delay_hook()();
+    }
+}
+
+static inline void delayMicroseconds(unsigned int us) {
+    host_clock_us() += us;
+}
+
+static inline void pinMode(uint8_t pin, uint8_t mode) {
+    (void) pin;
+    (void) mode;
+}
+
+static inline void digitalWrite(uint8_t pin, uint8_t value) {
+    (void) pin;
+    (void) value;
+}
+
+static inline void randomSeed(unsigned long seed) {
+    srand((unsigned) seed);
+}
+
+static inline long random(long lo, long hi) {
+    return lo + (rand() % (hi - lo));
+}
+
+#endif /* ARDUINO_H */
@@ -0,0 +1,53 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Host stand-in for the Energia SPI library.
+ *
+ * The bus drives a chain of shift registers, such as daisy-chained
+ * MOD-LED8x8RGB panels.  Each byte sent enters at the end of chain and
+ * the byte at the start of chain drops out, so after chain.size() bytes
+ * chain holds them in the order sent.  Size chain to the number of bytes
+ * the devices hold before sending.
+ */
+
+#ifndef SPI_H
+#define SPI_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+#define SPI_CLOCK_DIV16 16
+
+class SPIClass {
+public:
+    SPIClass() : bytes(0) {}
+
+    void begin() {}
+    void setDataMode(uint8_t mode) { (void) mode; }
+    void setClockDivider(uint8_t divider) { (void) divider; }
+
+    uint8_t transfer(uint8_t data) {
+        ++bytes;
+        size_t n = chain.size();
+        if (!n) {
+            return 0;
+        }
+        uint8_t out = chain[0];
+        memmove(&chain[0], &chain[1], n - 1);
+        chain[n - 1] = data;
+        return out;
+    }
+
+    std::vector<uint8_t> chain;  // the bytes held by the devices
+    unsigned long bytes;         // the bytes sent
+};
+
+static SPIClass SPI __attribute__((unused));
+
+#endif /* SPI_H */
@@ -0,0 +1,13 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Host stand-in for the Energia WiFi library. */
+
+#ifndef WIFI_H
+#define WIFI_H
+
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+#endif /* WIFI_H */
@@ -0,0 +1,57 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Host stand-in for the Energia WiFi client, backed by mock_net(). */
+
+#ifndef WIFICLIENT_H
+#define WIFICLIENT_H
+
+#include "Arduino.h"
+
+class WiFiClient {
+public:
+    int connect(const char * host, uint16_t port) {
+        (void) host; (void) port;
+        return mock_net().connect() ? 1 : 0;
+    }
+
+    int sslConnect(const char * host, uint16_t port) {
+        return connect(host, port);
+    }
+
+    size_t write(uint8_t value) {
+        return write(&value, 1);
+    }
+
+    size_t write(const uint8_t * buf, size_t size) {
+        int n = mock_net().write(buf, (int) size);
+        return (n < 0) ? 0 : (size_t) n;
+    }
+
+    int available() {
+        return mock_net().available();
+    }
+
+    int read() {
+        uint8_t value;
+        return (mock_net().read(&value, 1) == 1) ? value : -1;
+    }
+
+    int read(uint8_t * buf, size_t size) {
+        return mock_net().read(buf, (int) size);
+    }
+
+    uint8_t connected() {
+        MockNet & net = mock_net();
+        return net.connected || !net.arrived.empty();
+    }
+
+    void stop() {
+        mock_net().close();
+    }
+
+    void flush() {}
+};
+
+#endif /* WIFICLIENT_H */
@@ -0,0 +1,170 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Host stand-in for the parts of mbed used by the device code.
+ *
+ * SPI records every write() and transfer() call.  An asynchronous
+ * transfer stays pending until the test calls complete(), which invokes
+ * the completion callback as the interrupt would.
+ *
+ * Timer, wait() and wait_ms() use the simulated clock in mock_net.h.
+ */
+
+#ifndef MBED_H
+#define MBED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "mock_net.h"
+
+#define DEVICE_SPI_ASYNCH 1
+#define SPI_EVENT_ERROR     (1 << 1)
+#define SPI_EVENT_COMPLETE  (1 << 2)
+
+typedef int PinName;
+
+class event_callback_t {
+public:
+    event_callback_t() : fn_(0) {}
+
+    template <typename T>
+    event_callback_t(T * obj, void (T::*method)(int)) : fn_(new Method<T>(obj, method)) {}
+
+    event_callback_t(const event_callback_t & other)
+            : fn_(other.fn_ ? other.fn_->clone() : 0) {}
+
+    event_callback_t & operator=(const event_callback_t & other) {
+        if (this != &other) {
+            delete fn_;
+            fn_ = other.fn_ ? other.fn_->clone() : 0;
+        }
+        return *this;
+    }
+
+    ~event_callback_t() {
+        delete fn_;
+    }
+
+    void call(int event) const {
+        if (fn_) {
+            fn_->call(event);
+        }
+    }
+
+private:
+    struct Fn {
+        virtual ~Fn() {}
+        virtual void call(int event) = 0;
+        virtual Fn * clone() const = 0;
+    };
+
+    template <typename T>
+    struct Method : public Fn {
+        Method(T * obj, void (T::*method)(int)) : obj_(obj), method_(method) {}
+        void call(int event) { (obj_->*method_)(event); }
+        Fn * clone() const { return new Method(obj_, method_); }
+        T * obj_;
+        void (T::*method_)(int);
+    };
+
+    Fn * fn_;
+};
+
+class SPI {
+public:
+    SPI(PinName mosi, PinName miso, PinName sclk)
+            : transferResult(0), transfers(0), tx(0), txLength(0) {
+        (void) mosi; (void) miso; (void) sclk;
+    }
+
+    void format(int bits, int mode = 0) { (void) bits; (void) mode; }
+    void frequency(int hz = 1000000) { (void) hz; }
+
+    int write(int value) {
+        written.push_back((uint8_t) value);
+        return 0;
+    }
+
+    template <typename Type>
+    int transfer(const Type * tx_buffer, int tx_length, Type * rx_buffer,
+                 int rx_length, const event_callback_t & callback,
+                 int event = SPI_EVENT_COMPLETE) {
+        (void) rx_buffer; (void) rx_length; (void) event;
+        ++transfers;
+        if (transferResult) {
+            return transferResult;
+        }
+        tx = (const uint8_t *) tx_buffer;
+        txLength = tx_length * (int) sizeof(Type);
+        callback_ = callback;
+        return 0;
+    }
+
+    /** Finish the pending transfer from "interrupt" context. */
+    void complete(int event = SPI_EVENT_COMPLETE) {
+        event_callback_t callback = callback_;
+        tx = 0;
+        txLength = 0;
+        callback.call(event);
+    }
+
+    int transferResult;             // returned by transfer(), nonzero to fail
+    int transfers;                  // number of transfer() calls
+    const uint8_t * tx;             // the pending transfer buffer or NULL
+    int txLength;                   // the pending transfer length in bytes
+    std::vector<uint8_t> written;   // every byte passed to write()
+
+private:
+    event_callback_t callback_;
+};
+
+class Timer {
+public:
+    Timer() : running_(false), start_(0), elapsed_(0) {}
+
+    void start() {
+        if (!running_) {
+            start_ = host_clock_us();
+            running_ = true;
+        }
+    }
+
+    void stop() {
+        elapsed_ = us();
+        running_ = false;
+    }
+
+    void reset() {
+        start_ = host_clock_us();
+        elapsed_ = 0;
+    }
+
+    int read_us() { return (int) us(); }
+    int read_ms() { return (int) (us() / 1000); }
+    float read() { return us() / 1000000.0f; }
+
+private:
+    uint64_t us() const {
+        return elapsed_ + (running_ ? host_clock_us() - start_ : 0);
+    }
+
+    bool running_;
+    uint64_t start_;
+    uint64_t elapsed_;
+};
+
+static inline void wait_us(int us) { host_clock_us() += us; }
+static inline void wait_ms(int ms) { host_clock_us() += (uint64_t) ms * 1000; }
+static inline void wait(float s) { host_clock_us() += (uint64_t) (s * 1000000.0f); }
+
+static inline void __disable_irq() {}
+static inline void __enable_irq() {}
+static inline void __DMB() {}
+
+#endif /* MBED_H */
@@ -0,0 +1,199 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** A scripted network connection shared by the host socket stand-ins.
+ *
+ * TCPSocketConnection (mbed) and WiFiClient (Energia) both talk to
+ * mock_net().  The test queues the bytes that the server sends as
+ * separate chunks, and each chunk arrives only when the client polls for
+ * data after the previous chunk was read.  This allows splitting a
+ * response at any byte boundary.  Every client write is recorded as one
+ * call, and a budget can limit the bytes accepted per call to model a
+ * slow socket.
+ *
+ * host_clock_us() is the simulated time used by Timer, wait_ms(),
+ * millis() and delay().
+ */
+
+#ifndef MOCK_NET_H
+#define MOCK_NET_H
+
+#include <stdint.h>
+#include <string.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "Base64.h"
+#include "sha1.h"
+
+/** The simulated time in microseconds. */
+inline uint64_t & host_clock_us() {
+    static uint64_t t = 0;
+    return t;
+}
+
+struct MockNet {
+    typedef void (*RequestHandler)(MockNet & net, const std::string & key);
+
+    std::deque<std::vector<uint8_t> > rx;   // chunks not yet arrived
+    std::vector<uint8_t> arrived;           // bytes the client can read
+    std::vector<std::vector<uint8_t> > writes;  // bytes accepted by each write
+    std::vector<uint8_t> sent;              // every byte accepted
+    int budget;                  // bytes accepted per write, or -1 for all
+    bool connected;
+    bool hangup;                 // close once every chunk is read
+    bool refuse;                 // fail the next connect() calls
+    int connects;                // the number of connect() calls
+    RequestHandler onRequest;    // called with the upgrade request key
+    bool requested;
+
+    MockNet() {
+        reset();
+    }
+
+    void reset() {
+        rx.clear();
+        arrived.clear();
+        writes.clear();
+        sent.clear();
+        budget = -1;
+        connected = false;
+        hangup = false;
+        refuse = false;
+        connects = 0;
+        onRequest = acceptRequest;
+        requested = false;
+    }
+
+    /** Queue bytes sent by the server as one chunk. */
+    void push(const std::vector<uint8_t> & bytes) {
+        if (!bytes.empty()) {
+            rx.push_back(bytes);
+        }
+    }
+
+    void push(const std::string & bytes) {
+        push(std::vector<uint8_t>(bytes.begin(), bytes.end()));
+    }
+
+    /** Queue bytes sent by the server as chunks of at most size bytes. */
+    void pushSplit(const std::vector<uint8_t> & bytes, size_t size) {
+        for (size_t i = 0; i < bytes.size(); i += size) {
+            size_t n = bytes.size() - i;
+            if (n > size) {
+                n = size;
+            }
+            push(std::vector<uint8_t>(bytes.begin() + i, bytes.begin() + i + n));
+        }
+    }
+
+    /** Let the next chunk arrive once the previous one is read. */
+    void poll() {
+        if (arrived.empty() && !rx.empty()) {
+            arrived = rx.front();
+            rx.pop_front();
+        }
+        if (arrived.empty() && hangup) {
+            connected = false;
+        }
+    }
+
+    int available() {
+        poll();
+        return (int) arrived.size();
+    }
+
+    int read(uint8_t * buf, int len) {
+        poll();
+        int n = (int) arrived.size();
+        if (n > len) {
+            n = len;
+        }
+        if (n > 0) {
+            memcpy(buf, &arrived[0], n);
+            arrived.erase(arrived.begin(), arrived.begin() + n);
+        }
+        return n;
+    }
+
+    int write(const uint8_t * buf, int len) {
+        if (!connected) {
+            return -1;
+        }
+        int n = ((budget >= 0) && (len > budget)) ? budget : len;
+        writes.push_back(std::vector<uint8_t>(buf, buf + n));
+        sent.insert(sent.end(), buf, buf + n);
+        checkRequest();
+        return n;
+    }
+
+    bool connect() {
+        ++connects;
+        if (refuse) {
+            return false;
+        }
+        connected = true;
+        hangup = false;
+        requested = false;
+        return true;
+    }
+
+    /** Close the connection, discarding data not yet read. */
+    void close() {
+        connected = false;
+        rx.clear();
+        arrived.clear();
+    }
+
+    /** Call onRequest once the complete upgrade request is sent. */
+    void checkRequest() {
+        if (requested || !onRequest) {
+            return;
+        }
+        std::string s(sent.begin(), sent.end());
+        size_t end = s.find("\r\n\r\n");
+        size_t k = s.find("Sec-WebSocket-Key: ");
+        if ((end == std::string::npos) || (k == std::string::npos)) {
+            return;
+        }
+        k += strlen("Sec-WebSocket-Key: ");
+        std::string key = s.substr(k, s.find("\r\n", k) - k);
+        sent.erase(sent.begin(), sent.begin() + end + 4);
+        requested = true;
+        onRequest(*this, key);
+    }
+
+    /** Compute the Sec-WebSocket-Accept value for a key. */
+    static std::string acceptValue(const std::string & key) {
+        std::string s = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+        Sha1Class sha1;
+        sha1.init();
+        sha1.update(s.data(), s.size());
+        char out[32];
+        int n = base64_encode(out, (char *) sha1.result(), HASH_LENGTH);
+        return std::string(out, n);
+    }
+
+    /** The upgrade response for a key. */
+    static std::string response(const std::string & key) {
+        return "HTTP/1.1 101 Switching Protocols\r\n"
+               "Upgrade: websocket\r\n"
+               "Connection: Upgrade\r\n"
+               "Sec-WebSocket-Accept: " + acceptValue(key) + "\r\n\r\n";
+    }
+
+    /** The default handler which accepts the upgrade in one chunk. */
+    static void acceptRequest(MockNet & net, const std::string & key) {
+        net.rx.push_front(std::vector<uint8_t>());
+        std::string r = response(key);
+        net.rx.front().assign(r.begin(), r.end());
+    }
+};
+
+inline MockNet & mock_net() {
+    static MockNet net;
+    return net;
+}
+
+#endif /* MOCK_NET_H */
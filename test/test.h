@@ -0,0 +1,46 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Minimal checks for the host tests.
+ *
+ * Each test is a standalone program.  A failed check prints its location
+ * and the test continues, so one run reports every failure.  main()
+ * returns TEST_RESULT(), which is nonzero if any check failed.
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+static int test_checks = 0;
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+    ++test_checks; \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        ++test_failures; \
+    } \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+    long long a_ = (long long) (a); \
+    long long b_ = (long long) (b); \
+    ++test_checks; \
+    if (a_ != b_) { \
+        printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", \
+               __FILE__, __LINE__, #a, #b, a_, b_); \
+        ++test_failures; \
+    } \
+} while (0)
+
+#define TEST_RESULT() test_result(__FILE__)
+
+static inline int test_result(const char * name) {
+    printf("%s: %d checks, %d failures\n", name, test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
+
+#endif /* TEST_H */
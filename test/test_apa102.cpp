@@ -0,0 +1,117 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Check the APA102 refresh paths against a recording SPI stub. */
+
+#include "APA102.h"
+#include "test.h"
+
+static int callbacks = 0;
+
+static void onRefresh() {
+    ++callbacks;
+}
+
+/** Check that buf holds the complete wire frame for a strip. */
+static void checkFrame(const uint8_t * buf, int length, int pixels,
+                       const uint8_t * rgb) {
+    int eof = pixels / 16;
+    if (eof < 4) {
+        eof = 4;
+    }
+    CHECK_EQ(length, 4 + pixels * 4 + eof);
+    for (int i = 0; i < 4; ++i) {
+        CHECK_EQ(buf[i], 0x00);
+    }
+    for (int i = 0; i < pixels; ++i) {
+        const uint8_t * p = buf + 4 + i * 4;
+        CHECK_EQ(p[0], 0xFF);
+        CHECK_EQ(p[1], rgb[i * 3 + 2]);
+        CHECK_EQ(p[2], rgb[i * 3 + 1]);
+        CHECK_EQ(p[3], rgb[i * 3 + 0]);
+    }
+    for (int i = 4 + pixels * 4; i < length; ++i) {
+        CHECK_EQ(buf[i], 0xFF);
+    }
+}
+
+static void render(APA102 & strip, uint8_t * rgb, int seed) {
+    for (int i = 0; i < strip.numPixels(); ++i) {
+        rgb[i * 3 + 0] = (uint8_t) (seed + i);
+        rgb[i * 3 + 1] = (uint8_t) (seed * 3 + i * 5);
+        rgb[i * 3 + 2] = (uint8_t) (seed * 7 + i * 11);
+        strip.setRGB(i, rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+    }
+}
+
+static void testRefresh() {
+    const int pixels = 60;
+    uint8_t rgb[pixels * 3];
+    SPI spi(0, 0, 0);
+    APA102 strip(pixels, &spi);
+    render(strip, rgb, 1);
+    strip.refresh();
+    // One blocking write() per byte
+    CHECK_EQ(spi.written.size(), 4 + pixels * 4 + 4);
+    CHECK_EQ(spi.transfers, 0);
+    checkFrame(&spi.written[0], (int) spi.written.size(), pixels, rgb);
+}
+
+static void testRefreshAsync() {
+    const int pixels = 60;
+    const int frames = 10;
+    uint8_t rgb[pixels * 3];
+    SPI spi(0, 0, 0);
+    APA102 strip(pixels, &spi);
+    callbacks = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        render(strip, rgb, frame);
+        CHECK(strip.refreshAsync(onRefresh));
+        CHECK(strip.isBusy());
+        CHECK_EQ(spi.transfers, frame + 1);
+        checkFrame(spi.tx, spi.txLength, pixels, rgb);
+
+        // A second refresh is refused until the transfer completes
+        CHECK(!strip.refreshAsync(onRefresh));
+        CHECK_EQ(spi.transfers, frame + 1);
+        spi.complete();
+        CHECK(!strip.isBusy());
+        CHECK_EQ(callbacks, frame + 1);
+    }
+    // One transfer() per frame and no per-byte writes
+    CHECK_EQ(spi.transfers, frames);
+    CHECK_EQ(spi.written.size(), 0);
+}
+
+static void testRefreshAsyncError() {
+    SPI spi(0, 0, 0);
+    APA102 strip(8, &spi);
+    spi.transferResult = -1;
+    CHECK(!strip.refreshAsync());
+    CHECK(!strip.isBusy());
+    spi.transferResult = 0;
+    CHECK(strip.refreshAsync());
+    spi.complete(SPI_EVENT_ERROR);
+    CHECK(!strip.isBusy());
+}
+
+static void testLargeStrip() {
+    const int pixels = 300;
+    uint8_t rgb[pixels * 3];
+    SPI spi(0, 0, 0);
+    APA102 strip(pixels, &spi);
+    render(strip, rgb, 3);
+    CHECK(strip.refreshAsync());
+    CHECK_EQ(spi.transfers, 1);
+    checkFrame(spi.tx, spi.txLength, pixels, rgb);
+    spi.complete();
+}
+
+int main() {
+    testRefresh();
+    testRefreshAsync();
+    testRefreshAsyncError();
+    testLargeStrip();
+    return TEST_RESULT();
+}
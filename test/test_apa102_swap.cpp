@@ -0,0 +1,164 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Render and swap APA102 frames while a simulated transmitter drains
+ * the front buffer.
+ *
+ * The transmitter copies a few bytes of the pending transfer at a time,
+ * interleaved with rendering the next frame pixel by pixel.  Every frame
+ * received must match one rendered frame exactly, which would fail if
+ * rendering reached the buffer being sent.
+ */
+
+#include "APA102.h"
+#include "test.h"
+#include <vector>
+
+const int PIXELS = 60;
+
+static uint8_t pixelValue(int frame, int pixel, int channel) {
+    return (uint8_t) (frame * 37 + pixel * 3 + channel);
+}
+
+static void renderPixel(APA102 & strip, int frame, int pixel) {
+    strip.setRGB(pixel, pixelValue(frame, pixel, 0),
+                 pixelValue(frame, pixel, 1), pixelValue(frame, pixel, 2));
+}
+
+/** Check a received wire frame against a rendered frame. */
+static bool frameMatches(const std::vector<uint8_t> & rx, int frame) {
+    for (int i = 0; i < PIXELS; ++i) {
+        const uint8_t * p = &rx[4 + i * 4];
+        if ((p[1] != pixelValue(frame, i, 2)) ||
+                (p[2] != pixelValue(frame, i, 1)) ||
+                (p[3] != pixelValue(frame, i, 0))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Transmitter {
+    Transmitter(SPI & spi) : spi_(spi), offset_(0) {}
+
+    /** Drain up to count bytes of the pending transfer.
+     *
+     * @return True when the frame is complete.
+     */
+    bool drain(int count) {
+        if (!spi_.tx) {
+            return false;
+        }
+        for (; count && (offset_ < spi_.txLength); --count) {
+            rx.push_back(spi_.tx[offset_++]);
+        }
+        if (offset_ < spi_.txLength) {
+            return false;
+        }
+        frames.push_back(rx);
+        rx.clear();
+        offset_ = 0;
+        spi_.complete();
+        return true;
+    }
+
+    std::vector<uint8_t> rx;
+    std::vector<std::vector<uint8_t> > frames;
+
+private:
+    SPI & spi_;
+    int offset_;
+};
+
+static void testDoubleBuffered(int bytesPerPixel) {
+    const int frames = 50;
+    SPI spi(0, 0, 0);
+    Transmitter tx(spi);
+    APA102 strip(PIXELS, &spi, true);
+    std::vector<int> sent;
+
+    for (int pixel = 0; pixel < PIXELS; ++pixel) {
+        renderPixel(strip, 0, pixel);
+    }
+    CHECK(strip.swap());
+    CHECK(strip.refreshAsync());
+    sent.push_back(0);
+
+    for (int frame = 1; frame < frames; ++frame) {
+        // Render into the back buffer while the front buffer drains
+        for (int pixel = 0; pixel < PIXELS; ++pixel) {
+            renderPixel(strip, frame, pixel);
+            tx.drain(bytesPerPixel);
+        }
+        // The front buffer may not be replaced mid transfer
+        while (strip.isBusy()) {
+            CHECK(!strip.swap());
+            tx.drain(bytesPerPixel);
+        }
+        CHECK(strip.swap());
+        CHECK(strip.refreshAsync());
+        sent.push_back(frame);
+    }
+    while (strip.isBusy()) {
+        tx.drain(bytesPerPixel);
+    }
+
+    CHECK_EQ(tx.frames.size(), sent.size());
+    for (size_t i = 0; i < tx.frames.size(); ++i) {
+        CHECK(frameMatches(tx.frames[i], sent[i]));
+    }
+}
+
+static void testSingleBufferedTears() {
+    // Without double buffering, rendering during the transfer reaches the
+    // bytes not yet sent, which is the tearing the back buffer prevents.
+    SPI spi(0, 0, 0);
+    Transmitter tx(spi);
+    APA102 strip(PIXELS, &spi, false);
+    for (int pixel = 0; pixel < PIXELS; ++pixel) {
+        renderPixel(strip, 0, pixel);
+    }
+    CHECK(strip.swap());
+    CHECK(strip.refreshAsync());
+    for (int pixel = 0; pixel < PIXELS; ++pixel) {
+        if (pixel < PIXELS / 2) {
+            renderPixel(strip, 1, pixel);
+        } else {
+            tx.drain(4);
+        }
+    }
+    while (strip.isBusy()) {
+        tx.drain(4);
+    }
+    CHECK_EQ(tx.frames.size(), 1);
+    CHECK(!frameMatches(tx.frames[0], 0));
+    CHECK(!frameMatches(tx.frames[0], 1));
+}
+
+static void testCopyFront() {
+    SPI spi(0, 0, 0);
+    APA102 strip(PIXELS, &spi, true);
+    for (int pixel = 0; pixel < PIXELS; ++pixel) {
+        renderPixel(strip, 5, pixel);
+    }
+    CHECK(strip.swap());
+    strip.copyFront();
+    renderPixel(strip, 6, 7);
+    CHECK(strip.swap());
+    strip.refresh();
+    std::vector<uint8_t> rx(spi.written);
+    for (int i = 0; i < PIXELS; ++i) {
+        int frame = (i == 7) ? 6 : 5;
+        CHECK_EQ(rx[4 + i * 4 + 3], pixelValue(frame, i, 0));
+    }
+}
+
+int main() {
+    testDoubleBuffered(1);
+    testDoubleBuffered(4);
+    testDoubleBuffered(64);
+    testSingleBufferedTears();
+    testCopyFront();
+    return TEST_RESULT();
+}
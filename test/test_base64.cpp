@@ -0,0 +1,125 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Fuzz the Base64 codec against the character at a time reference.
+ *
+ * Built once per SIMD level: scalar, SSSE3 and AVX2.  Random binary is
+ * encoded and decoded back, and random valid, padded and corrupted
+ * strings are decoded, all in one call and streamed in random pieces.
+ * Lengths cover the 16 and 28 byte SIMD thresholds and unaligned
+ * buffers.  Nothing may be written past the terminator.
+ */
+
+#include "Base64.h"
+#include "base64_ref.h"
+#include "simd.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+const int MAX_LENGTH = 300;
+const int GUARD = 64;
+const unsigned char FILL = 0x55;
+
+static char expect[2 * MAX_LENGTH];
+
+/** Check output against the expected result and the guard bytes. */
+static bool same(const char * output, int length, int expectLength) {
+    if ((length != expectLength) || memcmp(output, expect, length + 1)) {
+        return false;
+    }
+    for (int i = length + 1; i < length + 1 + GUARD; ++i) {
+        if ((unsigned char) output[i] != FILL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int encodeStream(char * output, const char * input, int length) {
+    base64_encoder_s enc;
+    base64_encode_init(&enc);
+    int n = 0;
+    for (int p = 0; p < length; ) {
+        int k = rand() % (length - p + 1);
+        n += base64_encode_update(&enc, output + n, input + p, k);
+        p += k;
+    }
+    return n + base64_encode_final(&enc, output + n);
+}
+
+static int decodeStream(char * output, const char * input, int length) {
+    base64_decoder_s dec;
+    base64_decode_init(&dec);
+    int n = 0;
+    for (int p = 0; p < length; ) {
+        int k = rand() % (length - p + 1);
+        n += base64_decode_update(&dec, output + n, input + p, k);
+        p += k;
+    }
+    return n + base64_decode_final(&dec, output + n);
+}
+
+static void randomText(char * text, int length, int mode) {
+    for (int i = 0; i < length; ++i) {
+        text[i] = base64_ref_alphabet[rand() % 64];
+        if ((mode == 2) && (rand() % 50 == 0)) {
+            text[i] = (char) rand();  // corrupt
+        }
+    }
+    if ((length > 2) && (rand() % 3 == 0)) {
+        text[length - 1] = '=';
+        if (rand() % 2) {
+            text[length - 2] = '=';
+        }
+    }
+}
+
+int main() {
+    if (!simd_supported()) {
+        printf("Base64 %s: not supported on this host, skipped\n", SIMD_NAME);
+        return 0;
+    }
+    static char input[MAX_LENGTH + 1];
+    static char output[2 * MAX_LENGTH + GUARD];
+    static char back[2 * MAX_LENGTH + GUARD];
+    int failures[5] = {0, 0, 0, 0, 0};
+    srand(1);
+    for (int t = 0; t < 50000; ++t) {
+        int length = rand() % MAX_LENGTH;
+        int mode = rand() % 3;  // binary, text or corrupted text
+        char * in = input + (t & 1);
+        if (mode == 0) {
+            for (int i = 0; i < length; ++i) {
+                in[i] = (char) rand();
+            }
+            int n = base64_ref_encode(expect, in, length);
+            memset(output, FILL, sizeof(output));
+            failures[0] += !same(output, base64_encode(output, in, length), n);
+            memset(output, FILL, sizeof(output));
+            failures[1] += !same(output, encodeStream(output, in, length), n);
+            CHECK_EQ(n, base64_enc_len(length));
+
+            // Round trip
+            memcpy(expect, in, length);
+            expect[length] = '\0';
+            memset(back, FILL, sizeof(back));
+            failures[2] += !same(back, base64_decode(back, output, n), length);
+        } else {
+            randomText(in, length, mode);
+            int n = base64_ref_decode(expect, in, length);
+            memset(output, FILL, sizeof(output));
+            failures[3] += !same(output, base64_decode(output, in, length), n);
+            memset(output, FILL, sizeof(output));
+            failures[4] += !same(output, decodeStream(output, in, length), n);
+        }
+    }
+    CHECK_EQ(failures[0], 0);  // encode
+    CHECK_EQ(failures[1], 0);  // streamed encode
+    CHECK_EQ(failures[2], 0);  // round trip
+    CHECK_EQ(failures[3], 0);  // decode
+    CHECK_EQ(failures[4], 0);  // streamed decode
+    printf("Base64 %s: ", SIMD_NAME);
+    return TEST_RESULT();
+}
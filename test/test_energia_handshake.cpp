@@ -0,0 +1,181 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Check the Energia WebSocket client handshake with canned server
+ * responses split into two reads at every byte boundary, and into one
+ * byte per read, and check that randomSeed() sets the
+ * Sec-WebSocket-Key sequence.
+ *
+ * The program builds the Energia library only from its own directory,
+ * which holds copies of the common files, as Energia does.
+ */
+
+#include "ws_client.h"
+#include "ws_frames.h"
+#include "ws_parser.h"
+#include "mock_net.h"
+#include "test.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+struct Response {
+    const char * name;
+    const char * text;   // {ACCEPT} is replaced with the accept value
+    bool ok;
+};
+
+static const Response RESPONSES[] = {
+    {"standard",
+     "HTTP/1.1 101 Switching Protocols\r\n"
+     "Upgrade: websocket\r\n"
+     "Connection: Upgrade\r\n"
+     "Sec-WebSocket-Accept: {ACCEPT}\r\n"
+     "\r\n", true},
+    {"extra headers",
+     "HTTP/1.1 101 Web Socket Protocol Handshake\r\n"
+     "Server: CherryPy/3.8.0\r\n"
+     "date: Mon, 20 Jul 2015 12:00:00 GMT\r\n"
+     "connection: keep-alive, Upgrade\r\n"
+     "sec-websocket-accept: {ACCEPT}\r\n"
+     "UPGRADE: WebSocket\r\n"
+     "Sec-WebSocket-Protocol: chat\r\n"
+     "X-Long: 0123456789012345678901234567890123456789012345678901234567890123456789"
+     "0123456789012345678901234567890123456789\r\n"
+     "\r\n", true},
+    {"bare newlines",
+     "HTTP/1.1 101 Switching Protocols\n"
+     "Upgrade: websocket\n"
+     "Connection: Upgrade\n"
+     "Sec-WebSocket-Accept: {ACCEPT}\n"
+     "\n", true},
+    {"status 200",
+     "HTTP/1.1 200 OK\r\n"
+     "Upgrade: websocket\r\n"
+     "Connection: Upgrade\r\n"
+     "Sec-WebSocket-Accept: {ACCEPT}\r\n"
+     "\r\n", false},
+    {"no upgrade",
+     "HTTP/1.1 101 Switching Protocols\r\n"
+     "Connection: Upgrade\r\n"
+     "Sec-WebSocket-Accept: {ACCEPT}\r\n"
+     "\r\n", false},
+    {"no connection",
+     "HTTP/1.1 101 Switching Protocols\r\n"
+     "Upgrade: websocket\r\n"
+     "Sec-WebSocket-Accept: {ACCEPT}\r\n"
+     "\r\n", false},
+    {"no accept",
+     "HTTP/1.1 101 Switching Protocols\r\n"
+     "Upgrade: websocket\r\n"
+     "Connection: Upgrade\r\n"
+     "\r\n", false},
+    {"wrong accept",
+     "HTTP/1.1 101 Switching Protocols\r\n"
+     "Upgrade: websocket\r\n"
+     "Connection: Upgrade\r\n"
+     "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+     "\r\n", false},
+    {"accept with suffix",
+     "HTTP/1.1 101 Switching Protocols\r\n"
+     "Upgrade: websocket\r\n"
+     "Connection: Upgrade\r\n"
+     "Sec-WebSocket-Accept: {ACCEPT}x\r\n"
+     "\r\n", false},
+    {"truncated",
+     "HTTP/1.1 101 Switching Protocols\r\n"
+     "Upgrade: websocket\r\n"
+     "Connection: Upgrade\r\n"
+     "Sec-WebSocket-Accept: {ACCEPT}\r\n", false},
+};
+
+static const Response * response;
+static Bytes trailer;       // frames sent with the response
+static size_t split;        // the first read size or 0 for one byte per read
+
+static void respond(MockNet & net, const std::string & key) {
+    std::string text = response->text;
+    size_t pos = text.find("{ACCEPT}");
+    if (pos != std::string::npos) {
+        text.replace(pos, 8, MockNet::acceptValue(key));
+    }
+    Bytes data = bytes(text) + trailer;
+    if (split == 0) {
+        net.pushSplit(data, 1);
+    } else {
+        net.push(Bytes(data.begin(), data.begin() + split));
+        net.push(Bytes(data.begin() + split, data.end()));
+    }
+    if (!response->ok) {
+        net.hangup = true;
+    }
+}
+
+/** Connect and return the messages received after the handshake. */
+static bool connect(std::vector<WsMessage> & messages) {
+    MockNet & net = mock_net();
+    net.reset();
+    net.onRequest = respond;
+    WsTestClient * client = ws_client_energia();
+    bool ok = client->connect();
+    if (ok) {
+        client->receive(messages);
+    }
+    delete client;
+    return ok;
+}
+
+/** Connect and return the Sec-WebSocket-Key sent. */
+static std::string sentKey() {
+    response = &RESPONSES[0];
+    trailer.clear();
+    split = 0;
+    std::vector<WsMessage> messages;
+    CHECK(connect(messages));
+    MockNet & net = mock_net();
+    std::string request(net.writes[0].begin(), net.writes[0].end());
+    size_t k = request.find("Sec-WebSocket-Key: ");
+    CHECK(k != std::string::npos);
+    return request.substr(k, request.find("\r\n", k) - k);
+}
+
+/** Devices seeded differently send different keys. */
+static void testSeed() {
+    randomSeed(0x2c3ae001);
+    std::string a = sentKey();
+    std::string b = sentKey();
+    CHECK(a != b);  // each connection has a new key
+    randomSeed(0x2c3ae001);
+    CHECK(sentKey() == a);
+    randomSeed(0x2c3ae002);
+    CHECK(sentKey() != a);
+}
+
+int main() {
+    trailer = ws_frame(WS_OPCODE_TEXT, "hi") + ws_frame(WS_OPCODE_BINARY, "there");
+    for (size_t k = 0; k < sizeof(RESPONSES) / sizeof(RESPONSES[0]); ++k) {
+        response = &RESPONSES[k];
+        // The accept value is 20 bytes longer than its placeholder
+        size_t length = strlen(response->text) + trailer.size() +
+                (strstr(response->text, "{ACCEPT}") ? 20 : 0);
+        int failures = 0;
+        for (split = 0; split < length; ++split) {
+            std::vector<WsMessage> messages;
+            bool ok = connect(messages);
+            if (ok != response->ok) {
+                ++failures;
+            } else if (ok) {
+                // The frames that arrived with the response are kept
+                failures += (messages.size() != 2) || (messages[0].data != "hi") ||
+                        (messages[1].data != "there");
+            }
+        }
+        CHECK_EQ(failures, 0);
+        if (failures) {
+            printf("response \"%s\" failed %d times\n", response->name, failures);
+        }
+    }
+    testSeed();
+    return TEST_RESULT();
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Check the integer HSV kernel against the previous float conversion. */
+
+#include "hsv.h"
+#include "hsv_float.h"
+#include "test.h"
+#include <stdlib.h>
+
+static void testAccuracy() {
+    int maxDiff = 0;
+    long count = 0;
+    for (int hi = 0; hi < 4096; ++hi) {
+        for (int si = 0; si <= 255; si += 5) {
+            for (int vi = 0; vi <= 255; vi += 3) {
+                float h = hi / 4096.0f;
+                float s = si / 255.0f;
+                float v = vi / 255.0f;
+                uint8_t expect[3];
+                uint8_t actual[3];
+                hsv_to_rgb_float(h, s, v, expect);
+                hsv_to_rgb(hsv_hue(h), hsv_unit(s), hsv_unit(v), actual);
+                for (int k = 0; k < 3; ++k) {
+                    int d = abs(expect[k] - actual[k]);
+                    if (d > maxDiff) {
+                        maxDiff = d;
+                    }
+                }
+                ++count;
+            }
+        }
+    }
+    printf("hsv_to_rgb: %ld colors, max difference %d LSB\n", count, maxDiff);
+    CHECK(maxDiff <= 1);
+}
+
+static void testExact() {
+    // Grays and the primary and secondary colors are exact
+    for (int v = 0; v < 256; ++v) {
+        uint8_t rgb[3];
+        hsv_to_rgb(12345, 0, (uint8_t) v, rgb);
+        CHECK_EQ(rgb[0], v);
+        CHECK_EQ(rgb[1], v);
+        CHECK_EQ(rgb[2], v);
+    }
+    static const uint8_t primary[6][3] = {
+        {255, 0, 0}, {255, 255, 0}, {0, 255, 0},
+        {0, 255, 255}, {0, 0, 255}, {255, 0, 255}};
+    for (int i = 0; i < 6; ++i) {
+        uint8_t rgb[3];
+        hsv_to_rgb(hsv_hue(i / 6.0f), 255, 255, rgb);
+        CHECK_EQ(rgb[0], primary[i][0]);
+        CHECK_EQ(rgb[1], primary[i][1]);
+        CHECK_EQ(rgb[2], primary[i][2]);
+    }
+}
+
+static void testUnits() {
+    CHECK_EQ(hsv_unit(-1.0f), 0);
+    CHECK_EQ(hsv_unit(0.0f), 0);
+    CHECK_EQ(hsv_unit(0.5f), 128);
+    CHECK_EQ(hsv_unit(1.0f), 255);
+    CHECK_EQ(hsv_unit(2.0f), 255);
+    CHECK_EQ(hsv_hue(0.0f), 0);
+    CHECK_EQ(hsv_hue(0.5f), 32768);
+    CHECK_EQ(hsv_hue(1.25f), 16384);
+}
+
+static void testStripLayouts() {
+    const pixel_layout_s * layouts[] = {
+        &PIXEL_LAYOUT_APA102, &PIXEL_LAYOUT_RGB, &PIXEL_LAYOUT_GRB,
+        &PIXEL_LAYOUT_RBG};
+    const int pixels = 100;
+    uint8_t buf[pixels * 4];
+    for (unsigned k = 0; k < sizeof(layouts) / sizeof(layouts[0]); ++k) {
+        const pixel_layout_s * layout = layouts[k];
+        for (int i = 0; i < (int) sizeof(buf); ++i) {
+            buf[i] = (uint8_t) i;
+        }
+        hsv_to_rgb_strip(1000, 655, 200, 180, buf, pixels, layout);
+        for (int i = 0; i < pixels; ++i) {
+            uint8_t rgb[3];
+            hsv_to_rgb((uint16_t) (1000 + i * 655), 200, 180, rgb);
+            const uint8_t * p = buf + i * layout->stride;
+            CHECK_EQ(p[layout->r], rgb[0]);
+            CHECK_EQ(p[layout->g], rgb[1]);
+            CHECK_EQ(p[layout->b], rgb[2]);
+            if (layout->stride == 4) {
+                // The APA102 brightness byte is untouched
+                CHECK_EQ(p[0], (uint8_t) (i * 4));
+            }
+        }
+    }
+}
+
+int main() {
+    testAccuracy();
+    testExact();
+    testUnits();
+    testStripLayouts();
+    return TEST_RESULT();
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Check that the vectorized strip conversion matches the scalar kernel.
+ *
+ * Built once per SIMD level.  hsv_to_rgb() is always the scalar kernel,
+ * so each strip pixel must equal it exactly, for every layout, for
+ * counts which end mid vector and for unaligned buffers.
+ */
+
+#include "hsv.h"
+#include "simd.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void checkStrip(uint16_t h, uint16_t h_step, uint8_t s, uint8_t v,
+                       int count, int offset, const pixel_layout_s * layout) {
+    static uint8_t buf[4 * 128 + 64];
+    static uint8_t guard[4 * 128 + 64];
+    for (int i = 0; i < (int) sizeof(buf); ++i) {
+        buf[i] = guard[i] = (uint8_t) (i * 13 + 7);
+    }
+    uint8_t * p = buf + offset;
+    hsv_to_rgb_strip(h, h_step, s, v, p, count, layout);
+    int mismatches = 0;
+    for (int i = 0; i < count; ++i) {
+        uint8_t rgb[3];
+        hsv_to_rgb((uint16_t) (h + i * h_step), s, v, rgb);
+        uint8_t * px = p + i * layout->stride;
+        if ((px[layout->r] != rgb[0]) || (px[layout->g] != rgb[1]) ||
+                (px[layout->b] != rgb[2])) {
+            ++mismatches;
+        }
+        px[layout->r] = guard[px - buf + layout->r];
+        px[layout->g] = guard[px - buf + layout->g];
+        px[layout->b] = guard[px - buf + layout->b];
+    }
+    CHECK_EQ(mismatches, 0);
+    // Every byte outside the pixel components is untouched
+    CHECK(0 == memcmp(buf, guard, sizeof(buf)));
+}
+
+int main() {
+    if (!simd_supported()) {
+        printf("test_hsv_simd %s: not supported on this host, skipped\n",
+               SIMD_NAME);
+        return 0;
+    }
+    const pixel_layout_s * layouts[] = {
+        &PIXEL_LAYOUT_APA102, &PIXEL_LAYOUT_RGB, &PIXEL_LAYOUT_GRB,
+        &PIXEL_LAYOUT_RBG};
+    srand(1);
+    for (unsigned k = 0; k < sizeof(layouts) / sizeof(layouts[0]); ++k) {
+        for (int count = 0; count <= 128; ++count) {
+            for (int offset = 0; offset < 4; ++offset) {
+                checkStrip((uint16_t) rand(), (uint16_t) rand(),
+                           (uint8_t) rand(), (uint8_t) rand(), count, offset,
+                           layouts[k]);
+            }
+        }
+        // The extremes of saturation and value
+        for (int s = 0; s < 256; s += 255) {
+            for (int v = 0; v < 256; v += 255) {
+                checkStrip(0, 65535 / 100, (uint8_t) s, (uint8_t) v, 100, 0,
+                           layouts[k]);
+            }
+        }
+        for (int i = 0; i < 2000; ++i) {
+            checkStrip((uint16_t) rand(), (uint16_t) rand(), (uint8_t) rand(),
+                       (uint8_t) rand(), 128, 0, layouts[k]);
+        }
+    }
+    printf("test_hsv_simd %s\n", SIMD_NAME);
+    return TEST_RESULT();
+}
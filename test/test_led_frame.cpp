@@ -0,0 +1,651 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Check the LED frame codec in common/led_frame.h.
+ *
+ * Frames round trip through LedFrameEncoder and LedFrameDecoder for each
+ * pixel format and encoding into the APA102, RGB and GRB strip layouts.
+ * Corrupted frames must fail with the matching error and leave the strip
+ * buffer byte-identical, and frames for other devices or strips are
+ * ignored.  Delta frames round trip with rotations and with SKIP, XOR
+ * and REPEAT runs past LED_FRAME_DELTA_MAX, and a missing or failed
+ * frame rejects deltas until the next keyframe.  The frames from the
+ * server's Python encoder for the vectors in led_frame_vectors.py must
+ * match the C encoder byte for byte.
+ */
+
+#include "led_frame.h"
+#include "test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+struct LedFrameVector {
+    const char * name;
+    uint8_t format;
+    uint8_t encoding;        // LED_FRAME_DELTA to encode with encodeDelta()
+    uint8_t device;
+    uint8_t strip;
+    uint16_t sequence;
+    uint16_t start;
+    int count;
+    const uint8_t * pixels;  // RGB
+    const uint8_t * previous;
+    int maxShift;
+    const uint8_t * frame;
+    int length;
+};
+
+#include "led_frame_vectors.h"
+
+static const pixel_layout_s * const LAYOUTS[] = {
+    &PIXEL_LAYOUT_APA102, &PIXEL_LAYOUT_RGB, &PIXEL_LAYOUT_GRB};
+static const char * const LAYOUT_NAMES[] = {"APA102", "RGB", "GRB"};
+
+static Bytes noise(int count) {
+    Bytes rgb(3 * count);
+    for (size_t i = 0; i < rgb.size(); ++i) {
+        rgb[i] = (uint8_t) rand();
+    }
+    return rgb;
+}
+
+/** Pixels with runs of 1 to 300, crossing the RLE packet limit. */
+static Bytes runs(int count) {
+    Bytes rgb(3 * count);
+    int i = 0;
+    while (i < count) {
+        int n = 1 + rand() % ((rand() & 1) ? 3 : 300);
+        uint8_t r = (uint8_t) rand();
+        uint8_t g = (uint8_t) rand();
+        uint8_t b = (uint8_t) rand();
+        for (; n && (i < count); --n, ++i) {
+            rgb[3 * i + 0] = r;
+            rgb[3 * i + 1] = g;
+            rgb[3 * i + 2] = b;
+        }
+    }
+    return rgb;
+}
+
+/** The RGB value that the decoder produces for a pixel in format. */
+static Bytes quantize(const Bytes & rgb, uint8_t format) {
+    if (format != LED_FRAME_RGB565) {
+        return rgb;
+    }
+    Bytes q(rgb.size());
+    for (size_t i = 0; i < rgb.size(); i += 3) {
+        uint8_t r = rgb[i] >> 3;
+        uint8_t g = rgb[i + 1] >> 2;
+        uint8_t b = rgb[i + 2] >> 3;
+        q[i] = (uint8_t) ((r << 3) | (r >> 2));
+        q[i + 1] = (uint8_t) ((g << 2) | (g >> 4));
+        q[i + 2] = (uint8_t) ((b << 3) | (b >> 2));
+    }
+    return q;
+}
+
+/** A strip buffer filled with a pattern, so that stray writes show. */
+static Bytes stripBuffer(int count, const pixel_layout_s * layout) {
+    Bytes strip(count * layout->stride);
+    for (size_t i = 0; i < strip.size(); ++i) {
+        strip[i] = (uint8_t) (0xa5 ^ (i * 29));
+    }
+    return strip;
+}
+
+static Bytes encode(LedFrameEncoder & encoder, const Bytes & rgb, uint8_t encoding,
+                    uint16_t start = 0) {
+    int count = (int) rgb.size() / 3;
+    Bytes out(encoder.maxSize(count));
+    int n = encoder.encode(rgb.data(), count, &PIXEL_LAYOUT_RGB, out.data(),
+                           (int) out.size(), encoding, start);
+    CHECK(n >= LED_FRAME_HEADER_SIZE);
+    out.resize(n < 0 ? 0 : n);
+    return out;
+}
+
+static int decode(LedFrameDecoder & decoder, const Bytes & frame, Bytes & strip,
+                  const pixel_layout_s * layout) {
+    return decoder.decode(frame.data(), (uint32_t) frame.size(), strip.data(),
+                          (int) strip.size() / layout->stride, layout);
+}
+
+/** Round trip RAW and RLE frames through each format and layout. */
+static void testRoundTrip() {
+    static const uint8_t formats[] = {LED_FRAME_RGB888, LED_FRAME_RGB565};
+    static const uint8_t encodings[] = {LED_FRAME_RAW, LED_FRAME_RLE};
+    static const int counts[] = {0, 1, 2, 60, 129, 1000};
+    int failures = 0;
+    for (int trial = 0; trial < 20; ++trial) {
+        for (unsigned f = 0; f < 2; ++f) {
+            for (unsigned e = 0; e < 2; ++e) {
+                for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+                    for (unsigned l = 0; l < 3; ++l) {
+                        const pixel_layout_s * layout = LAYOUTS[l];
+                        int count = counts[c];
+                        Bytes rgb = (trial & 1) ? runs(count) : noise(count);
+                        LedFrameEncoder encoder(1, 0, formats[f]);
+                        uint16_t start = (uint16_t) (trial % 3);
+                        Bytes frame = encode(encoder, rgb, encodings[e], start);
+                        LedFrameHeader h;
+                        CHECK(led_frame_parse_header(frame.data(), (uint32_t) frame.size(), &h));
+                        // RLE only falls back to RAW when it does not save space
+                        CHECK((h.encoding == encodings[e]) ||
+                              (h.encoding == LED_FRAME_RAW &&
+                               (int) frame.size() == LED_FRAME_HEADER_SIZE +
+                               count * led_frame_pixel_size(formats[f])));
+                        int total = start + count + 2;
+                        Bytes strip = stripBuffer(total, layout);
+                        Bytes expect = strip;
+                        LedFrameDecoder decoder(1, 0);
+                        CHECK_EQ(decode(decoder, frame, strip, layout), count);
+                        CHECK_EQ(decoder.error(), LedFrameDecoder::ERROR_NONE);
+                        // Only the red, green and blue bytes of the frame's pixels change
+                        Bytes q = quantize(rgb, formats[f]);
+                        for (int i = 0; i < count; ++i) {
+                            uint8_t * p = &expect[(start + i) * layout->stride];
+                            p[layout->r] = q[3 * i + 0];
+                            p[layout->g] = q[3 * i + 1];
+                            p[layout->b] = q[3 * i + 2];
+                        }
+                        if (strip != expect) {
+                            printf("round trip format %d encoding %d count %d %s failed\n",
+                                   formats[f], encodings[e], count, LAYOUT_NAMES[l]);
+                            ++failures;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    CHECK_EQ(failures, 0);
+}
+
+/** Decode a corrupted frame and check that it fails and changes nothing. */
+static void checkRejected(const Bytes & frame, LedFrameDecoder::Error error,
+                          const char * what) {
+    for (unsigned l = 0; l < 3; ++l) {
+        const pixel_layout_s * layout = LAYOUTS[l];
+        Bytes strip = stripBuffer(64, layout);
+        Bytes before = strip;
+        LedFrameDecoder decoder(1, 0);
+        int n = decode(decoder, frame, strip, layout);
+        CHECK_EQ(n, -1);
+        CHECK_EQ(decoder.error(), error);
+        if ((n != -1) || (decoder.error() != error) || (strip != before)) {
+            printf("%s: returned %d, error %d, %s strip %s\n", what, n, decoder.error(),
+                   LAYOUT_NAMES[l], (strip == before) ? "unchanged" : "changed");
+        }
+        CHECK(strip == before);
+    }
+}
+
+static void testRejected() {
+    for (int encoding = LED_FRAME_RAW; encoding <= LED_FRAME_RLE; ++encoding) {
+        for (int format = LED_FRAME_RGB888; format <= LED_FRAME_RGB565; ++format) {
+            LedFrameEncoder encoder(1, 0, (uint8_t) format);
+            Bytes frame = encode(encoder, runs(50), (uint8_t) encoding, 3);
+            CHECK_EQ(frame[1] & 0x0f, encoding);
+            char what[64];
+
+            for (size_t n = 0; n < LED_FRAME_HEADER_SIZE; ++n) {
+                snprintf(what, sizeof(what), "header truncated to %d", (int) n);
+                checkRejected(Bytes(frame.begin(), frame.begin() + n),
+                              LedFrameDecoder::ERROR_HEADER, what);
+            }
+            for (size_t n = LED_FRAME_HEADER_SIZE; n < frame.size(); ++n) {
+                snprintf(what, sizeof(what), "body truncated to %d", (int) n);
+                checkRejected(Bytes(frame.begin(), frame.begin() + n),
+                              LedFrameDecoder::ERROR_BODY, what);
+            }
+            Bytes longer = frame;
+            longer.push_back(0);
+            checkRejected(longer, LedFrameDecoder::ERROR_BODY, "extra body byte");
+
+            Bytes bad = frame;
+            bad[0] = 'M';
+            checkRejected(bad, LedFrameDecoder::ERROR_HEADER, "wrong magic");
+            for (int f = 2; f < 16; ++f) {
+                bad = frame;
+                bad[1] = (uint8_t) ((f << 4) | encoding);
+                checkRejected(bad, LedFrameDecoder::ERROR_FORMAT, "bad format");
+            }
+            for (int e = LED_FRAME_DELTA + 1; e < 16; ++e) {
+                bad = frame;
+                bad[1] = (uint8_t) ((format << 4) | e);
+                checkRejected(bad, LedFrameDecoder::ERROR_ENCODING, "bad encoding");
+            }
+            // The strip in checkRejected() has 64 pixels
+            bad = frame;
+            bad[6] = 0;
+            bad[7] = 64 - 50 + 1;
+            checkRejected(bad, LedFrameDecoder::ERROR_RANGE, "start + count past the strip");
+            bad[6] = 0xff;
+            bad[7] = 0xff;
+            checkRejected(bad, LedFrameDecoder::ERROR_RANGE, "start past the strip");
+        }
+    }
+}
+
+/** Frames for another device or strip return 0 and change nothing. */
+static void testAddress() {
+    static const struct {
+        uint8_t device;
+        uint8_t strip;
+        int result;
+    } cases[] = {
+        {1, 0, 50},
+        {LED_FRAME_ID_ALL, 0, 50},
+        {1, LED_FRAME_ID_ALL, 50},
+        {LED_FRAME_ID_ALL, LED_FRAME_ID_ALL, 50},
+        {2, 0, 0},
+        {0, 0, 0},
+        {1, 1, 0},
+        {2, LED_FRAME_ID_ALL, 0},
+        {LED_FRAME_ID_ALL, 7, 0},
+    };
+    for (unsigned k = 0; k < sizeof(cases) / sizeof(cases[0]); ++k) {
+        LedFrameEncoder encoder(cases[k].device, cases[k].strip);
+        Bytes frame = encode(encoder, noise(50), LED_FRAME_RLE);
+        Bytes strip = stripBuffer(64, &PIXEL_LAYOUT_APA102);
+        Bytes before = strip;
+        LedFrameDecoder decoder(1, 0);
+        CHECK_EQ(decode(decoder, frame, strip, &PIXEL_LAYOUT_APA102), cases[k].result);
+        CHECK_EQ(strip == before, cases[k].result == 0);
+    }
+    // Another device's frame is ignored even when it is malformed
+    LedFrameEncoder encoder(2, 0);
+    Bytes frame = encode(encoder, noise(50), LED_FRAME_RAW);
+    frame[1] = 0xff;
+    frame.pop_back();
+    Bytes strip = stripBuffer(64, &PIXEL_LAYOUT_APA102);
+    LedFrameDecoder decoder(1, 0);
+    CHECK_EQ(decode(decoder, frame, strip, &PIXEL_LAYOUT_APA102), 0);
+}
+
+/** Build a frame from its header fields and body. */
+static Bytes frame(uint8_t format, uint8_t encoding, uint16_t sequence, uint16_t count,
+                   const Bytes & body, uint16_t start = 0) {
+    uint8_t h[LED_FRAME_HEADER_SIZE] = {
+        LED_FRAME_MAGIC, (uint8_t) ((format << 4) | encoding), 1, 0,
+        (uint8_t) (sequence >> 8), (uint8_t) sequence, (uint8_t) (start >> 8), (uint8_t) start,
+        (uint8_t) (count >> 8), (uint8_t) count};
+    Bytes f(sizeof(h) + body.size());
+    memcpy(f.data(), h, sizeof(h));
+    std::copy(body.begin(), body.end(), f.begin() + sizeof(h));
+    return f;
+}
+
+/** Pixel i becomes pixel (i - shift) modulo count. */
+static Bytes rotate(const Bytes & rgb, int shift) {
+    int count = (int) rgb.size() / 3;
+    Bytes out(rgb.size());
+    for (int i = 0; i < count; ++i) {
+        int k = ((i - shift) % count + count) % count;
+        memcpy(&out[3 * i], &rgb[3 * k], 3);
+    }
+    return out;
+}
+
+/** Encode a keyframe of previous and a delta to current, decode both
+ * into each layout, and check the result.
+ *
+ * @return The delta frame.
+ */
+static Bytes roundTripDelta(const Bytes & previous, const Bytes & current, uint8_t format,
+                            int maxShift = LED_FRAME_DELTA_SHIFT,
+                            const Bytes * encoderPrevious = NULL) {
+    int count = (int) current.size() / 3;
+    LedFrameEncoder encoder(1, 0, format);
+    Bytes key = encode(encoder, previous, LED_FRAME_RLE);
+    Bytes delta(encoder.maxSize(count));
+    const Bytes & prev = encoderPrevious ? *encoderPrevious : previous;
+    int n = encoder.encodeDelta(current.data(), prev.data(), count, &PIXEL_LAYOUT_RGB,
+                                delta.data(), (int) delta.size(), 0, maxShift);
+    CHECK(n >= LED_FRAME_HEADER_SIZE);
+    delta.resize(n < 0 ? 0 : n);
+    for (unsigned l = 0; l < 3; ++l) {
+        const pixel_layout_s * layout = LAYOUTS[l];
+        Bytes strip = stripBuffer(count, layout);
+        LedFrameDecoder decoder(1, 0);
+        CHECK_EQ(decode(decoder, key, strip, layout), count);
+        Bytes expect = strip;
+        Bytes q = quantize(current, format);
+        for (int i = 0; i < count; ++i) {
+            uint8_t * p = &expect[i * layout->stride];
+            p[layout->r] = q[3 * i + 0];
+            p[layout->g] = q[3 * i + 1];
+            p[layout->b] = q[3 * i + 2];
+        }
+        CHECK_EQ(decode(decoder, delta, strip, layout), count);
+        CHECK(strip == expect);
+    }
+    return delta;
+}
+
+/** Count the ops of each type in a delta body and the longest of each. */
+struct DeltaOps {
+    int count[4];
+    int longest[4];
+};
+
+static DeltaOps deltaOps(const Bytes & f, int pixelSize) {
+    DeltaOps ops;
+    memset(&ops, 0, sizeof(ops));
+    size_t i = LED_FRAME_HEADER_SIZE;
+    if ((i < f.size()) && (f[i] == LED_FRAME_OP_ROTATE)) {
+        ++ops.count[3];
+        i += 3;
+    }
+    while (i < f.size()) {
+        uint8_t c = f[i++];
+        int op = c >> 6;
+        int n = (c & 0x3f) + 1;
+        ++ops.count[op];
+        if (n > ops.longest[op]) {
+            ops.longest[op] = n;
+        }
+        i += (op == 1) ? n * pixelSize : ((op == 2) ? pixelSize : 0);
+    }
+    return ops;
+}
+
+/** Deltas with rotations, as chosen by the encoder and any shift sent. */
+static void testDeltaRotate() {
+    static const uint8_t formats[] = {LED_FRAME_RGB888, LED_FRAME_RGB565};
+    for (unsigned f = 0; f < 2; ++f) {
+        int pixelSize = led_frame_pixel_size(formats[f]);
+        for (int shift = -LED_FRAME_DELTA_SHIFT; shift <= LED_FRAME_DELTA_SHIFT; ++shift) {
+            Bytes previous = noise(60);
+            Bytes current = rotate(previous, shift);
+            current[30] ^= 0x80;
+            Bytes delta = roundTripDelta(previous, current, formats[f]);
+            CHECK_EQ(delta[1] & 0x0f, LED_FRAME_DELTA);
+            if (shift) {
+                CHECK_EQ(delta[LED_FRAME_HEADER_SIZE], LED_FRAME_OP_ROTATE);
+                CHECK_EQ((int16_t) ((delta[11] << 8) | delta[12]), shift);
+            }
+            // The rotation leaves one patched pixel
+            CHECK(delta.size() <= (size_t) LED_FRAME_HEADER_SIZE + 3 + 2 + pixelSize);
+        }
+        // Small strips never search past count - 1
+        Bytes two = noise(2);
+        roundTripDelta(two, rotate(two, 1), formats[f]);
+        Bytes one = noise(1);
+        Bytes other = noise(1);
+        roundTripDelta(one, other, formats[f]);
+    }
+
+    // Any shift that is sent, including |shift| >= count, is taken modulo count
+    static const int shifts[] = {1, -1, 7, -7, 9, 10, -10, 11, -11, 23, -29, 32767, -32768};
+    const int count = 10;
+    for (unsigned k = 0; k < sizeof(shifts) / sizeof(shifts[0]); ++k) {
+        Bytes previous = noise(count);
+        LedFrameEncoder encoder(1, 0);
+        Bytes key = encode(encoder, previous, LED_FRAME_RAW);
+        uint16_t s = (uint16_t) shifts[k];
+        uint8_t body[] = {LED_FRAME_OP_ROTATE, (uint8_t) (s >> 8), (uint8_t) s};
+        Bytes delta = frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 1, count,
+                            Bytes(body, body + sizeof(body)));
+        for (unsigned l = 0; l < 3; ++l) {
+            Bytes strip = stripBuffer(count, LAYOUTS[l]);
+            LedFrameDecoder decoder(1, 0);
+            CHECK_EQ(decode(decoder, key, strip, LAYOUTS[l]), count);
+            Bytes expect = strip;
+            CHECK_EQ(decode(decoder, delta, strip, LAYOUTS[l]), count);
+            Bytes rotated = rotate(previous, shifts[k]);
+            for (int i = 0; i < count; ++i) {
+                uint8_t * p = &expect[i * LAYOUTS[l]->stride];
+                p[LAYOUTS[l]->r] = rotated[3 * i + 0];
+                p[LAYOUTS[l]->g] = rotated[3 * i + 1];
+                p[LAYOUTS[l]->b] = rotated[3 * i + 2];
+            }
+            CHECK(strip == expect);
+            if (strip != expect) {
+                printf("rotate %d into %s failed\n", shifts[k], LAYOUT_NAMES[l]);
+            }
+        }
+    }
+}
+
+/** SKIP, XOR and REPEAT runs longer than LED_FRAME_DELTA_MAX. */
+static void testDeltaRuns() {
+    static const uint8_t formats[] = {LED_FRAME_RGB888, LED_FRAME_RGB565};
+    const int count = 600;
+    for (unsigned f = 0; f < 2; ++f) {
+        Bytes previous = runs(count);
+        Bytes current = previous;
+        // 150 changed pixels with distinct values, then 150 unchanged
+        for (int i = 0; i < 150; ++i) {
+            current[3 * i + 0] = (uint8_t) (i * 8);
+            current[3 * i + 1] = (uint8_t) ~previous[3 * i + 1];
+            current[3 * i + 2] = (uint8_t) (previous[3 * i + 2] + 8 * (i + 1));
+        }
+        // 150 pixels from a constant to another constant XOR the same value
+        for (int i = 300; i < 450; ++i) {
+            previous[3 * i + 0] = 0x10;
+            previous[3 * i + 1] = 0x20;
+            previous[3 * i + 2] = 0x30;
+            current[3 * i + 0] = 0xf0;
+            current[3 * i + 1] = 0x24;
+            current[3 * i + 2] = 0x38;
+        }
+        current[3 * (count - 1)] ^= 0x80;  // a change after a long skip
+        Bytes delta = roundTripDelta(previous, current, formats[f], 0);
+        CHECK_EQ(delta[1] & 0x0f, LED_FRAME_DELTA);
+        DeltaOps ops = deltaOps(delta, led_frame_pixel_size(formats[f]));
+        for (int op = 0; op < 3; ++op) {
+            CHECK(ops.count[op] >= 3);  // each run is split into several ops
+            CHECK_EQ(ops.longest[op], LED_FRAME_DELTA_MAX);
+        }
+        CHECK_EQ(ops.count[3], 0);
+    }
+
+    // Hand-written ops of the longest length
+    const int n = 3 * LED_FRAME_DELTA_MAX;
+    Bytes previous = noise(n);
+    LedFrameEncoder encoder(1, 0);
+    Bytes key = encode(encoder, previous, LED_FRAME_RAW);
+    Bytes body;
+    Bytes expect = previous;
+    body.push_back(LED_FRAME_OP_SKIP | (LED_FRAME_DELTA_MAX - 1));
+    body.push_back(LED_FRAME_OP_XOR | (LED_FRAME_DELTA_MAX - 1));
+    for (int i = LED_FRAME_DELTA_MAX; i < 2 * LED_FRAME_DELTA_MAX; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            uint8_t x = (uint8_t) (i + k);
+            body.push_back(x);
+            expect[3 * i + k] ^= x;
+        }
+    }
+    uint8_t repeat[] = {LED_FRAME_OP_REPEAT | (LED_FRAME_DELTA_MAX - 1), 0x01, 0x80, 0xff};
+    body.insert(body.end(), repeat, repeat + sizeof(repeat));
+    for (int i = 2 * LED_FRAME_DELTA_MAX; i < n; ++i) {
+        expect[3 * i + 0] ^= 0x01;
+        expect[3 * i + 1] ^= 0x80;
+        expect[3 * i + 2] ^= 0xff;
+    }
+    Bytes strip = previous;
+    LedFrameDecoder decoder(1, 0);
+    CHECK_EQ(decode(decoder, key, strip, &PIXEL_LAYOUT_RGB), n);
+    CHECK_EQ(decode(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 1, n, body), strip,
+                    &PIXEL_LAYOUT_RGB), n);
+    CHECK(strip == expect);
+
+    // Ops past count are rejected
+    Bytes over(1, LED_FRAME_OP_SKIP | (LED_FRAME_DELTA_MAX - 1));
+    over.push_back(LED_FRAME_OP_SKIP);
+    Bytes before = strip;
+    CHECK_EQ(decode(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 2,
+                                   LED_FRAME_DELTA_MAX, over), strip, &PIXEL_LAYOUT_RGB), -1);
+    CHECK_EQ(decoder.error(), LedFrameDecoder::ERROR_BODY);
+    CHECK(strip == before);
+}
+
+/** Decode a delta that must be rejected and leave the strip unchanged. */
+static void checkDeltaRejected(LedFrameDecoder & decoder, const Bytes & f, Bytes & strip,
+                               LedFrameDecoder::Error error) {
+    Bytes before = strip;
+    CHECK_EQ(decode(decoder, f, strip, &PIXEL_LAYOUT_APA102), -1);
+    CHECK_EQ(decoder.error(), error);
+    CHECK(strip == before);
+}
+
+/** Deltas need the previous frame: gaps, errors and reset() stop them. */
+static void testDeltaSequence() {
+    const int count = 40;
+    Bytes skip(1, LED_FRAME_OP_SKIP);
+    Bytes xorOne(1, LED_FRAME_OP_XOR);
+    xorOne.push_back(0x11);
+    xorOne.push_back(0x22);
+    xorOne.push_back(0x33);
+    Bytes key = frame(LED_FRAME_RGB888, LED_FRAME_RLE, 100, count,
+                      Bytes({0x80 | (count - 1), 1, 2, 3}));
+
+    // A delta without any keyframe
+    LedFrameDecoder decoder(1, 0);
+    Bytes strip = stripBuffer(count, &PIXEL_LAYOUT_APA102);
+    checkDeltaRejected(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 1, count, xorOne),
+                       strip, LedFrameDecoder::ERROR_SEQUENCE);
+
+    // In sequence, including the wrap from 65535 to 0
+    CHECK_EQ(decode(decoder, key, strip, &PIXEL_LAYOUT_APA102), count);
+    CHECK_EQ(decode(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 101, count, xorOne),
+                    strip, &PIXEL_LAYOUT_APA102), count);
+    CHECK_EQ(decode(decoder, frame(LED_FRAME_RGB888, LED_FRAME_RLE, 65535, count,
+                                   Bytes({0x80 | (count - 1), 1, 2, 3})),
+                    strip, &PIXEL_LAYOUT_APA102), count);
+    CHECK_EQ(decode(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 0, count, xorOne),
+                    strip, &PIXEL_LAYOUT_APA102), count);
+
+    // A gap, a repeat or a step back rejects deltas until the next keyframe
+    static const uint16_t wrong[] = {2, 0, 65535, 1000};
+    for (unsigned k = 0; k < sizeof(wrong) / sizeof(wrong[0]); ++k) {
+        CHECK_EQ(decode(decoder, key, strip, &PIXEL_LAYOUT_APA102), count);
+        checkDeltaRejected(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA,
+                                          (uint16_t) (100 + wrong[k]), count, xorOne),
+                           strip, LedFrameDecoder::ERROR_SEQUENCE);
+        for (uint16_t s = 101; s < 104; ++s) {
+            checkDeltaRejected(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, s, count, skip),
+                               strip, LedFrameDecoder::ERROR_SEQUENCE);
+        }
+    }
+
+    // Any error rejects deltas, even the one that would have been next
+    Bytes bad[] = {
+        Bytes(key.begin(), key.begin() + 5),
+        frame(LED_FRAME_RGB888, LED_FRAME_RLE, 101, count, Bytes({0x80 | (count - 2), 1, 2, 3})),
+        frame(LED_FRAME_RGB888, 7, 101, count, skip),
+        frame(LED_FRAME_RGB888, LED_FRAME_RAW, 101, count + 1, Bytes(3 * (count + 1), 0)),
+        frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 101, count, Bytes({LED_FRAME_OP_XOR, 1})),
+    };
+    for (unsigned k = 0; k < sizeof(bad) / sizeof(bad[0]); ++k) {
+        CHECK_EQ(decode(decoder, key, strip, &PIXEL_LAYOUT_APA102), count);
+        Bytes before = strip;
+        CHECK_EQ(decode(decoder, bad[k], strip, &PIXEL_LAYOUT_APA102), -1);
+        CHECK(strip == before);
+        checkDeltaRejected(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 101, count, xorOne),
+                           strip, LedFrameDecoder::ERROR_SEQUENCE);
+    }
+
+    // Frames for other devices do not break the sequence
+    CHECK_EQ(decode(decoder, key, strip, &PIXEL_LAYOUT_APA102), count);
+    Bytes other = frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 500, count, xorOne);
+    other[2] = 9;
+    CHECK_EQ(decode(decoder, other, strip, &PIXEL_LAYOUT_APA102), 0);
+    CHECK_EQ(decode(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 101, count, xorOne),
+                    strip, &PIXEL_LAYOUT_APA102), count);
+
+    // reset() rejects deltas until the next keyframe
+    decoder.reset();
+    checkDeltaRejected(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 102, count, xorOne),
+                       strip, LedFrameDecoder::ERROR_SEQUENCE);
+    CHECK_EQ(decode(decoder, key, strip, &PIXEL_LAYOUT_APA102), count);
+    CHECK_EQ(decode(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 101, count, xorOne),
+                    strip, &PIXEL_LAYOUT_APA102), count);
+}
+
+/** ROTATE is only allowed as the first op. */
+static void testDeltaRotateOrder() {
+    const int count = 20;
+    Bytes key = frame(LED_FRAME_RGB888, LED_FRAME_RAW, 7, count, noise(count));
+    static const uint8_t bodies[][8] = {
+        {LED_FRAME_OP_SKIP, LED_FRAME_OP_ROTATE, 0, 1},
+        {LED_FRAME_OP_ROTATE, 0, 1, LED_FRAME_OP_ROTATE, 0, 1},
+        {LED_FRAME_OP_XOR, 1, 2, 3, LED_FRAME_OP_ROTATE, 0, 2},
+        {LED_FRAME_OP_REPEAT | 3, 1, 2, 3, LED_FRAME_OP_ROTATE | 5, 0, 2},
+        {LED_FRAME_OP_ROTATE, 0},  // truncated shift
+    };
+    static const int lengths[] = {4, 6, 7, 7, 2};
+    for (unsigned k = 0; k < sizeof(lengths) / sizeof(lengths[0]); ++k) {
+        LedFrameDecoder decoder(1, 0);
+        Bytes strip = stripBuffer(count, &PIXEL_LAYOUT_APA102);
+        CHECK_EQ(decode(decoder, key, strip, &PIXEL_LAYOUT_APA102), count);
+        checkDeltaRejected(decoder, frame(LED_FRAME_RGB888, LED_FRAME_DELTA, 8, count,
+                                          Bytes(bodies[k], bodies[k] + lengths[k])),
+                           strip, LedFrameDecoder::ERROR_BODY);
+    }
+}
+
+/** RGB565 patches apply to the decoded, quantized previous frame. */
+static void testDelta565() {
+    for (int trial = 0; trial < 50; ++trial) {
+        Bytes previous = noise(100);
+        Bytes current = previous;
+        for (int i = 0; i < 20; ++i) {
+            current[rand() % current.size()] = (uint8_t) rand();
+        }
+        // Low bits which RGB565 drops do not count as changes
+        current[0] ^= 0x07;
+        // The encoder may hold the full colors or the quantized ones
+        Bytes q = quantize(previous, LED_FRAME_RGB565);
+        Bytes delta = roundTripDelta(previous, current, LED_FRAME_RGB565,
+                                     LED_FRAME_DELTA_SHIFT, (trial & 1) ? &q : NULL);
+        CHECK_EQ(delta[1], (LED_FRAME_RGB565 << 4) | LED_FRAME_DELTA);
+    }
+}
+
+/** The Python encoder and the C encoder produce the same bytes. */
+static void testPythonParity() {
+    for (unsigned k = 0; k < sizeof(LED_FRAME_VECTORS) / sizeof(LED_FRAME_VECTORS[0]); ++k) {
+        const LedFrameVector & v = LED_FRAME_VECTORS[k];
+        LedFrameEncoder encoder(v.device, v.strip, v.format);
+        Bytes out(encoder.maxSize(v.count) + 16);
+        // Advance to the vector's sequence number
+        for (int s = 0; s < v.sequence; ++s) {
+            encoder.encode(v.pixels, 0, &PIXEL_LAYOUT_RGB, out.data(), (int) out.size());
+        }
+        int n;
+        if (v.encoding == LED_FRAME_DELTA) {
+            n = encoder.encodeDelta(v.pixels, v.previous, v.count, &PIXEL_LAYOUT_RGB,
+                                    out.data(), (int) out.size(), v.start, v.maxShift);
+        } else {
+            n = encoder.encode(v.pixels, v.count, &PIXEL_LAYOUT_RGB, out.data(),
+                               (int) out.size(), v.encoding, v.start);
+        }
+        bool same = (n == v.length) && !memcmp(out.data(), v.frame, v.length);
+        CHECK(same);
+        if (!same) {
+            printf("vector %s: C encoder gives %d bytes, Python %d\n", v.name, n, v.length);
+        }
+    }
+}
+
+int main() {
+    srand(1);
+    testRoundTrip();
+    testRejected();
+    testAddress();
+    testDeltaRotate();
+    testDeltaRuns();
+    testDeltaSequence();
+    testDeltaRotateOrder();
+    testDelta565();
+    testPythonParity();
+    return TEST_RESULT();
+}
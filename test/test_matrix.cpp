@@ -0,0 +1,231 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Compare the MatrixFramebuffer drawing code with the original, pixel
+ * for pixel, over random drawing operations.
+ *
+ * After each operation the new frame, packed to the wire format, must
+ * equal the original video buffer.  The new Transfer() runs at random
+ * and the bytes it leaves in the panel chain must also equal the
+ * original video buffer, with full transfers for the first half of the
+ * operations and partial transfers for the second.  Coordinates reach
+ * past every edge of the display.
+ *
+ * Ellipses are also compared for every pair of radii up to 8, including
+ * a zero radius.  The original never returns when both radii are zero,
+ * and the new code draws the center pixel.
+ *
+ * The original only maps up to 2 panel rows, so taller tilings skip the
+ * comparison and check the Transfer() output against the new frame
+ * alone.  Every tiling checks drawPixel() against a direct reference for
+ * the panel mapping: pixel x, y (from 0) is in panel
+ * (y / 8) * bigX + x / 8, whose 24 bytes are sent in reverse panel order,
+ * with row y % 8 in 3 bytes of red, green and blue planes and the pixel
+ * at bit x % 8.
+ */
+
+#include "matrix_api.h"
+#include "test.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+const int WIDTH = bigX * 8;
+const int HEIGHT = bigY * 8;
+const int PANELS = bigX * bigY;
+// Each transfer through the SPI stub takes time in the square of the chain
+const int OPERATIONS = (PANELS <= 32) ? 200000 : 20000;
+const bool COMPARE_OLD = (bigY <= 2);
+
+static int uniform(int lo, int hi) {
+    return lo + rand() % (hi - lo + 1);
+}
+
+static int randomX() {
+    return uniform(-4, WIDTH + 4);
+}
+
+static int randomY() {
+    return uniform(-4, HEIGHT + 4);
+}
+
+/** Run one random operation on both versions, or only on b if a is NULL. */
+static int step(MatrixTestLib * a, MatrixTestLib * b) {
+    int op = rand() % 12;
+    uint8_t color = (uint8_t) uniform(0, 7);
+    int x1 = randomX();
+    int y1 = randomY();
+    int x2 = randomX();
+    int y2 = randomY();
+    MatrixTestLib * libs[] = {a, b};
+    for (int i = a ? 0 : 1; i < 2; ++i) {
+        MatrixTestLib * m = libs[i];
+        m->setColor(color);
+        switch (op) {
+            case 0: m->drawLine(x1, y1, x2, y2); break;
+            case 1: m->drawLine(x1, y1, x1, y2); break;
+            case 2: m->drawLine(x1, y1, x2, y1); break;
+            case 3: m->drawRectangle(x1, y1, x2, y2); break;
+            case 4: m->drawSolidRectangle(x1, y1, x2, y2); break;
+            case 5: m->drawEllipse(x1, y1, 1 + (x2 & 7), y2 & 7); break;
+            case 6: m->drawTriangle(x1, y1, x2, y2, (x1 + x2) / 2, HEIGHT - y1); break;
+            case 7: m->drawChar((unsigned char) (20 + (x2 * 7 + y2) % 110), x1, y1); break;
+            case 8: m->lScroll(); break;
+            case 9: m->rScroll(); break;
+            case 10: m->drawPixel(x1, y1); break;
+            default:
+                if (x2 % 8 == 0) {
+                    m->vClear();
+                } else {
+                    m->drawPixel(x2, y2);
+                }
+                break;
+        }
+    }
+    return op;
+}
+
+static int countPixels(const std::vector<uint8_t> & wire) {
+    int n = 0;
+    for (size_t i = 0; i < wire.size(); i += 3) {
+        // Any color plane lights the pixel
+        n += __builtin_popcount(wire[i] | wire[i + 1] | wire[i + 2]);
+    }
+    return n;
+}
+
+static void testEllipses(MatrixTestLib * old, MatrixTestLib * lib) {
+    MatrixTestLib * libs[] = {old, lib};
+    int mismatches = 0;
+    for (int rx = -8; rx <= 8; ++rx) {
+        for (int ry = -8; ry <= 8; ++ry) {
+            if (!rx && !ry) {
+                continue;
+            }
+            for (int i = 0; i < 2; ++i) {
+                libs[i]->vClear();
+                libs[i]->setColor(7);
+                libs[i]->drawEllipse(WIDTH / 2, HEIGHT / 2, rx, ry);
+                libs[i]->drawEllipse(2, 3, rx, ry);
+            }
+            mismatches += (old->video() != lib->video());
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+
+    if (WIDTH >= 12 && HEIGHT >= 11) {
+        // A zero radius draws the center and the ends of the other axis
+        lib->vClear();
+        lib->drawEllipse(12, 8, 0, 3);
+        CHECK_EQ(countPixels(lib->video()), 3);
+    }
+
+    // Both radii zero draws the center pixel
+    for (int i = 0; i < 2; ++i) {
+        libs[i]->vClear();
+        libs[i]->setColor(5);
+    }
+    old->drawPixel(3, 4);
+    lib->drawEllipse(3, 4, 0, 0);
+    CHECK(old->video() == lib->video());
+    CHECK_EQ(countPixels(lib->video()), 1);
+    old->vClear();
+    lib->vClear();
+}
+
+/** Set pixel x, y (from 0) in a wire buffer as the panels expect it. */
+static void referencePixel(std::vector<uint8_t> & wire, int x, int y, uint8_t color) {
+    int panel = (y / 8) * bigX + x / 8;
+    uint8_t * row = &wire[(PANELS - 1 - panel) * 24 + (y % 8) * 3];
+    uint8_t bit = (uint8_t) (1 << (x % 8));
+    for (int plane = 0; plane < 3; ++plane) {
+        row[plane] = (uint8_t) ((row[plane] & ~bit) | ((color >> plane) & 1 ? bit : 0));
+    }
+}
+
+/** Draw every pixel, then redraw every pixel with other colors including
+ * black, and compare each frame and the transfers with the reference.
+ */
+static void testReferenceMapping(MatrixTestLib * lib) {
+    std::vector<uint8_t> expect(PANELS * 24, 0);
+    CHECK_EQ(lib->wireSize(), (int) expect.size());
+    lib->vClear();
+    int mismatches = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        lib->setPartialTransfer(pass);
+        for (int y = 0; y < HEIGHT; ++y) {
+            for (int x = 0; x < WIDTH; ++x) {
+                uint8_t color = (uint8_t) ((x * 3 + y + pass * 5) % 8);
+                lib->setColor(color);
+                lib->drawPixel(x + 1, y + 1);
+                referencePixel(expect, x, y, color);
+                if (lib->video() != expect) {
+                    if (!mismatches++) {
+                        printf("pixel %d, %d in pass %d differs\n", x, y, pass);
+                    }
+                    lib->vClear();
+                    expect.assign(expect.size(), 0);
+                }
+            }
+            if (y % 8 == 7) {
+                lib->transfer();
+                CHECK(lib->chain() == expect);
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+    lib->setPartialTransfer(false);
+    lib->vClear();
+}
+
+int main() {
+    MatrixTestLib * old = COMPARE_OLD ? matrix_old() : NULL;
+    MatrixTestLib * lib = matrix_new();
+    testReferenceMapping(lib);
+    if (old) {
+        CHECK_EQ(lib->wireSize(), old->wireSize());
+        testEllipses(old, lib);
+    }
+    srand(1);
+    int mismatches[12] = {0};
+    int chainMismatches = 0;
+    int transfers[2] = {0, 0};
+    unsigned long bytes[2] = {0, 0};
+    for (int i = 0; i < OPERATIONS; ++i) {
+        int partial = (i >= OPERATIONS / 2);
+        lib->setPartialTransfer(partial);
+        int op = step(old, lib);
+        if (old && (old->video() != lib->video())) {
+            ++mismatches[op];
+            old->vClear();  // start over so that one bug is not counted many times
+            lib->vClear();
+            continue;
+        }
+        if (rand() % 4 == 0) {
+            std::vector<uint8_t> expect = lib->video();
+            unsigned long sent = lib->spiBytes();
+            lib->transfer();
+            ++transfers[partial];
+            bytes[partial] += lib->spiBytes() - sent;
+            chainMismatches += (lib->chain() != expect);
+        }
+    }
+    for (int op = 0; op < 12; ++op) {
+        CHECK_EQ(mismatches[op], 0);
+        if (mismatches[op]) {
+            printf("operation %d differs %d times\n", op, mismatches[op]);
+        }
+    }
+    CHECK_EQ(chainMismatches, 0);
+    for (int partial = 0; partial < 2; ++partial) {
+        CHECK(transfers[partial] > OPERATIONS / 10);
+        // Full transfers send the whole chain or nothing
+        CHECK(partial || (bytes[partial] % lib->wireSize() == 0));
+        CHECK(bytes[partial] <= (unsigned long) transfers[partial] * lib->wireSize());
+        printf("%dx%d panels, %s transfers: %.1f bytes per transfer\n", bigX, bigY,
+               partial ? "partial" : "full", (double) bytes[partial] / transfers[partial]);
+    }
+    delete old;
+    delete lib;
+    return TEST_RESULT();
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Compare the frames that scrollString() sends to the panels with the
+ * original, for text that fits the ticker and for text that does not.
+ *
+ * The panel chain is recorded at each scroll step.  The new Transfer()
+ * skips unchanged frames, so repeated frames are dropped before the
+ * comparison.  Text that does not fit the ticker scrolls one character at
+ * a time and must match the original exactly.  The original scrolls two
+ * columns in the step after the last character, so text that fits the
+ * ticker has one more frame, and the original frames must appear in
+ * order.  The original never returns for right scrolling, so right
+ * scrolling is only checked for its step and frame counts.
+ */
+
+#include "matrix_api.h"
+#include "text_ticker.h"
+#include "test.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <string>
+
+const int COLUMNS = bigX * bigY * 8;  // strip columns
+
+typedef std::vector<std::vector<uint8_t> > Frames;
+
+static MatrixTestLib * recording;
+static Frames * frames;
+
+static void record() {
+    const std::vector<uint8_t> & chain = recording->chain();
+    if (frames->empty() || (frames->back() != chain)) {
+        frames->push_back(chain);
+    }
+}
+
+/** Scroll text and return the distinct frames and the step count. */
+static Frames scroll(MatrixTestLib * m, const std::string & text, bool right,
+                     unsigned long * steps) {
+    Frames f;
+    m->setColor(1);
+    m->vClear();
+    m->transfer();
+    recording = m;
+    frames = &f;
+    host_delay_hook() = record;
+    unsigned long start = host_delay_count();
+    m->scrollString(text.c_str(), right);
+    *steps = host_delay_count() - start;
+    host_delay_hook() = 0;
+    return f;
+}
+
+/** Check that every frame of a appears in b, in order. */
+static bool inOrder(const Frames & a, const Frames & b) {
+    size_t j = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        while ((j < b.size()) && (b[j] != a[i])) {
+            ++j;
+        }
+        if (j == b.size()) {
+            return false;
+        }
+        ++j;
+    }
+    return true;
+}
+
+static std::string text(int length) {
+    std::string s;
+    for (int i = 0; i < length; ++i) {
+        s += (char) ('!' + (i * 7) % 93);
+    }
+    return s;
+}
+
+int main() {
+    MatrixTestLib * old = matrix_old();
+    MatrixTestLib * lib = matrix_new();
+    // 85 characters of 6 columns fit the 512 column ticker
+    const int lengths[] = {1, 20, 85, 86, 200};
+    for (unsigned k = 0; k < sizeof(lengths) / sizeof(lengths[0]); ++k) {
+        int n = lengths[k];
+        std::string s = text(n);
+        unsigned long oldSteps;
+        unsigned long steps;
+        bool fits = (6 * n <= TEXT_TICKER_COLUMNS);
+        Frames expect = scroll(old, s, false, &oldSteps);
+        Frames left = scroll(lib, s, false, &steps);
+        CHECK_EQ(steps, oldSteps + fits);
+        if (fits) {
+            CHECK_EQ(left.size(), expect.size() + 1);
+            CHECK(inOrder(expect, left));
+        } else {
+            CHECK(left == expect);
+        }
+        Frames right = scroll(lib, s, true, &steps);
+        CHECK_EQ(steps, oldSteps + fits);
+        CHECK_EQ(right.size(), left.size());
+        printf("%3d characters: %lu steps, %d distinct frames\n", n, steps,
+               (int) left.size());
+    }
+    delete old;
+    delete lib;
+    return TEST_RESULT();
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Report the SPI bytes sent per frame by the original MOD-LED8x8RGB
+ * drawing code and by the MatrixFramebuffer version, with full and with
+ * partial transfers.
+ *
+ * The Fade demo runs the drawing part of loop() in Fade.ino, with
+ * drawing enabled and disabled.  The scrolling text runs scrollString(),
+ * which waits once per step, so its frames are counted with
+ * host_delay_count().
+ */
+
+#include "matrix_api.h"
+#include "test.h"
+#include <Arduino.h>
+#include <stdio.h>
+
+const int FADE_FRAMES = 1000;
+const char TEXT[] = "Hello from the CC3200";
+
+/** Run the Fade.ino loop() drawing and return the bytes per frame. */
+static double fade(MatrixTestLib * m, bool drawEnable) {
+    uint8_t color = 1;
+    m->setColor(color);
+    m->drawRectangle(4, 4, 5, 5);  // as in setup()
+    m->transfer();
+    m->vClear();
+    unsigned long bytes = m->spiBytes();
+    for (int i = 0; i < FADE_FRAMES; ++i) {
+        if (drawEnable) {
+            m->lScroll();
+            m->drawLine(8, 1, 8, 8);
+        } else {
+            m->vClear();
+        }
+        m->setColor(++color);
+        m->transfer();
+    }
+    return (double) (m->spiBytes() - bytes) / FADE_FRAMES;
+}
+
+/** Scroll TEXT and return the bytes per frame. */
+static double scroll(MatrixTestLib * m, bool right) {
+    m->vClear();
+    m->transfer();
+    unsigned long bytes = m->spiBytes();
+    unsigned long frames = host_delay_count();
+    m->scrollString(TEXT, right);
+    frames = host_delay_count() - frames;
+    return (double) (m->spiBytes() - bytes) / frames;
+}
+
+int main() {
+    MatrixTestLib * old = matrix_old();
+    MatrixTestLib * lib = matrix_new();
+    const double size = old->wireSize();
+    printf("%dx%d panels, SPI bytes per frame:\n", bigX, bigY);
+    printf("  %-16s %8s %8s %8s\n", "", "old", "full", "partial");
+
+    const char * names[] = {"Fade drawing", "Fade disabled", "scroll left", "scroll right"};
+    for (int k = 0; k < 4; ++k) {
+        double r[3];
+        for (int partial = 0; partial < 2; ++partial) {
+            lib->setPartialTransfer(partial);
+            r[1 + partial] = (k < 2) ? fade(lib, k == 0) : scroll(lib, k == 3);
+        }
+        if (k < 3) {
+            r[0] = (k < 2) ? fade(old, k == 0) : scroll(old, false);
+            printf("  %-16s %8.2f %8.2f %8.2f\n", names[k], r[0], r[1], r[2]);
+            // The original sends the whole chain every frame
+            CHECK(r[0] == size);
+        } else {
+            printf("  %-16s %8s %8.2f %8.2f\n", names[k], "-", r[1], r[2]);
+        }
+        CHECK(r[1] <= size);
+        CHECK(r[2] <= r[1]);
+        if (k == 1) {
+            // Only the first frame, which clears the setup() rectangle, is sent
+            CHECK(r[1] * FADE_FRAMES == size);
+        }
+    }
+    delete old;
+    delete lib;
+    return TEST_RESULT();
+}
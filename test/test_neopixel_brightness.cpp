@@ -0,0 +1,119 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Check that lossless brightness keeps exact colors through repeated
+ * brightness changes, using the NeoPixel timing model to decode the
+ * bits that show() sends.
+ */
+
+#include "neopixel_sim.h"
+#include "test.h"
+
+const int PIXELS = 60;
+
+static void render(Adafruit_NeoPixel & strip, uint32_t * colors) {
+    for (int i = 0; i < PIXELS; ++i) {
+        colors[i] = Adafruit_NeoPixel::Color((uint8_t) (i * 4), (uint8_t) (255 - i),
+                                             (uint8_t) (i * 37));
+        strip.setPixelColor(i, colors[i]);
+    }
+}
+
+/** Send the strip and return the bytes the strip received. */
+static std::vector<uint8_t> showFrame(Adafruit_NeoPixel & strip) {
+    neopixel_sim.reset();
+    strip.show();
+    std::vector<std::vector<uint8_t> > frames = neopixel_sim.frames();
+    CHECK_EQ(frames.size(), 1);
+    return frames.empty() ? std::vector<uint8_t>() : frames.back();
+}
+
+static void testRoundTrip(bool useGamma) {
+    Adafruit_NeoPixel strip(PIXELS, 0, WS2812B);
+    strip.setLosslessBrightness(true, useGamma);
+    uint32_t colors[PIXELS];
+    render(strip, colors);
+
+    // The first output at each brightness
+    std::vector<std::vector<uint8_t> > reference(256);
+    static const uint8_t levels[] = {255, 128, 1, 0, 64, 200, 3};
+    for (unsigned k = 0; k < sizeof(levels); ++k) {
+        strip.setBrightness(levels[k]);
+        reference[levels[k]] = showFrame(strip);
+    }
+
+    srand(useGamma ? 2 : 1);
+    for (int iter = 0; iter < 2000; ++iter) {
+        uint8_t b = (uint8_t) rand();
+        strip.setBrightness(b);
+        if ((iter % 50) == 0) {
+            strip.setBrightness(levels[iter % sizeof(levels)]);
+            CHECK(showFrame(strip) == reference[levels[iter % sizeof(levels)]]);
+        }
+    }
+
+    // The stored colors never change
+    for (int i = 0; i < PIXELS; ++i) {
+        CHECK_EQ(strip.getPixelColor(i), colors[i]);
+    }
+    // Each byte is sent through the table
+    strip.setBrightness(100);
+    std::vector<uint8_t> out = showFrame(strip);
+    const uint8_t * lut = strip.getOutputLut();
+    CHECK(lut != NULL);
+    int mismatches = 0;
+    for (int i = 0; i < PIXELS * 3; ++i) {
+        mismatches += (out[i] != lut[strip.getPixels()[i]]);
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+static void testTable() {
+    Adafruit_NeoPixel strip(1, 0, WS2812B);
+    strip.setLosslessBrightness(true);
+    strip.setBrightness(255);
+    const uint8_t * lut = strip.getOutputLut();
+    // Gamma is on by default: dark values are compressed toward zero
+    CHECK_EQ(lut[0], 0);
+    CHECK_EQ(lut[255], 255);
+    CHECK(lut[128] < 64);
+    for (int i = 1; i < 256; ++i) {
+        CHECK(lut[i] >= lut[i - 1]);
+    }
+    strip.setLosslessBrightness(true, false);
+    lut = strip.getOutputLut();
+    for (int i = 0; i < 256; ++i) {
+        CHECK_EQ(lut[i], i);
+    }
+    strip.setBrightness(127);
+    for (int i = 0; i < 256; ++i) {
+        CHECK_EQ(lut[i], (i * 128) >> 8);
+    }
+    strip.setLosslessBrightness(false);
+    CHECK(strip.getOutputLut() == NULL);
+}
+
+static void testLossy() {
+    // The in-place scaling loses precision, which lossless mode avoids
+    Adafruit_NeoPixel strip(PIXELS, 0, WS2812B);
+    uint32_t colors[PIXELS];
+    render(strip, colors);
+    strip.setBrightness(255);
+    strip.setBrightness(3);
+    strip.setBrightness(255);
+    int changed = 0;
+    for (int i = 0; i < PIXELS; ++i) {
+        changed += (strip.getPixelColor(i) != colors[i]);
+    }
+    CHECK(changed > 0);
+}
+
+int main() {
+    CHECK(neopixel_sim_select(&NEOPIXEL_TIMING[0]));
+    testRoundTrip(true);
+    testRoundTrip(false);
+    testTable();
+    testLossy();
+    return TEST_RESULT();
+}
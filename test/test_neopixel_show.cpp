@@ -0,0 +1,164 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Check the show() bit timings and chunk boundaries with the NeoPixel
+ * timing model in neopixel_sim.h.
+ */
+
+#include "neopixel_sim.h"
+#include "test.h"
+#include <math.h>
+#include <stdio.h>
+
+enum Pattern {
+    PATTERN_ZEROS,
+    PATTERN_ONES,
+    PATTERN_RANDOM
+};
+
+static void fill(Adafruit_NeoPixel & strip, Pattern pattern) {
+    uint8_t * p = strip.getPixels();
+    for (int i = 0; i < strip.numPixels() * 3; ++i) {
+        switch (pattern) {
+            case PATTERN_ZEROS: p[i] = 0x00; break;
+            case PATTERN_ONES:  p[i] = 0xFF; break;
+            default:            p[i] = (uint8_t) rand(); break;
+        }
+    }
+}
+
+static bool frameIs(const std::vector<uint8_t> & frame,
+                    const Adafruit_NeoPixel & strip) {
+    int n = strip.numPixels() * 3;
+    return ((int) frame.size() == n) &&
+            (0 == memcmp(&frame[0], strip.getPixels(), n));
+}
+
+/** The model's bit times meet the datasheet for every pixel type. */
+static void testBitTimings() {
+    for (unsigned k = 0; k < sizeof(NEOPIXEL_TIMING) / sizeof(NEOPIXEL_TIMING[0]); ++k) {
+        const NeoPixelTiming & t = NEOPIXEL_TIMING[k];
+        for (int bit = 0; bit < 2; ++bit) {
+            for (int phase = 0; phase < 2; ++phase) {
+                CHECK(fabs(t.measured[bit][phase] - t.spec[bit][phase]) <=
+                      NEOPIXEL_TOLERANCE_NS);
+            }
+        }
+        CHECK(neopixel_sim_select(&t));
+        Adafruit_NeoPixel strip(60, 0, t.type);
+        fill(strip, PATTERN_RANDOM);
+        strip.show();
+        std::vector<std::vector<uint8_t> > frames = neopixel_sim.frames();
+        CHECK_EQ(frames.size(), 1);
+        CHECK(frameIs(frames[0], strip));
+    }
+}
+
+/** Every interrupt-off window holds whole pixels and fits the limit. */
+static void testChunks() {
+    static const uint16_t limits[] = {1, 25, 30, 31, 50, 60, 100, 250, 300, 1000};
+    static const int sizes[] = {1, 7, 60, 150};
+    for (unsigned k = 0; k < sizeof(NEOPIXEL_TIMING) / sizeof(NEOPIXEL_TIMING[0]); ++k) {
+        const NeoPixelTiming & t = NEOPIXEL_TIMING[k];
+        CHECK(neopixel_sim_select(&t));
+        double worstPixelNs = neopixel_sim.pixelTime();
+        double maxWindowNs = 0;
+        for (unsigned m = 0; m < sizeof(limits) / sizeof(limits[0]); ++m) {
+            for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+                for (int pattern = 0; pattern < 3; ++pattern) {
+                    Adafruit_NeoPixel strip(sizes[s], 0, t.type);
+                    strip.setMaxInterruptOff(limits[m]);
+                    fill(strip, (Pattern) pattern);
+                    // An interrupt handler shorter than the latch time
+                    neopixel_sim.reset(t.latchUs * 1000.0 * 0.4);
+                    strip.show();
+
+                    // The driver may round its pixel time up by 5%
+                    int minPixels = (int) (limits[m] * 1000.0 / (worstPixelNs * 1.05));
+                    if (minPixels < 1) {
+                        minPixels = 1;
+                    }
+                    int bits = 0;
+                    for (size_t i = 0; i < neopixel_sim.windows.size(); ++i) {
+                        const NeoPixelWindow & w = neopixel_sim.windows[i];
+                        CHECK_EQ(w.bits % 24, 0);
+                        bits += w.bits;
+                        double ns = w.end - w.start;
+                        if (w.bits > 24) {
+                            CHECK(ns <= limits[m] * 1000.0);
+                            if (ns > maxWindowNs) {
+                                maxWindowNs = ns;
+                            }
+                        }
+                        // No more windows than the limit requires
+                        if (i + 1 < neopixel_sim.windows.size()) {
+                            CHECK(w.bits >= minPixels * 24);
+                        }
+                    }
+                    CHECK_EQ(bits, sizes[s] * 24);
+                    std::vector<std::vector<uint8_t> > frames = neopixel_sim.frames();
+                    CHECK_EQ(frames.size(), 1);
+                    CHECK(frameIs(frames[0], strip));
+                }
+            }
+        }
+        printf("%s: worst case %.2f us per pixel, longest window %.2f us\n",
+               t.name, worstPixelNs / 1000.0, maxWindowNs / 1000.0);
+    }
+}
+
+/** An interrupt handler longer than the latch time restarts the frame. */
+static void testRestart() {
+    for (unsigned k = 0; k < sizeof(NEOPIXEL_TIMING) / sizeof(NEOPIXEL_TIMING[0]); ++k) {
+        const NeoPixelTiming & t = NEOPIXEL_TIMING[k];
+        CHECK(neopixel_sim_select(&t));
+        Adafruit_NeoPixel strip(60, 0, t.type);
+        strip.setMaxInterruptOff(200);
+        fill(strip, PATTERN_RANDOM);
+        neopixel_sim.reset(t.latchUs * 1000.0 * 1.5);
+        strip.show();
+        std::vector<std::vector<uint8_t> > frames = neopixel_sim.frames();
+        CHECK_EQ(frames.size(), SHOW_MAX_RESTARTS + 1);
+        for (size_t i = 0; i + 1 < frames.size(); ++i) {
+            // Each partial frame is the start of the full frame
+            CHECK(frames[i].size() < frames.back().size());
+            CHECK(0 == memcmp(&frames[i][0], strip.getPixels(), frames[i].size()));
+        }
+        CHECK(frameIs(frames.back(), strip));
+    }
+}
+
+/** Interrupt handlers near the latch time never corrupt the frame.
+ *
+ * micros() only has 1 us resolution, so show() cannot tell whether a gap
+ * within 1 us of the latch time latched the strip.
+ */
+static void testRestartBoundary() {
+    for (unsigned k = 0; k < sizeof(NEOPIXEL_TIMING) / sizeof(NEOPIXEL_TIMING[0]); ++k) {
+        const NeoPixelTiming & t = NEOPIXEL_TIMING[k];
+        CHECK(neopixel_sim_select(&t));
+        Adafruit_NeoPixel strip(20, 0, t.type);
+        strip.setMaxInterruptOff(100);
+        int failures = 0;
+        for (double isr = t.latchUs - 2.0; isr < t.latchUs + 2.0; isr += 0.01) {
+            fill(strip, PATTERN_RANDOM);
+            neopixel_sim.reset(isr * 1000.0);
+            strip.show();
+            std::vector<std::vector<uint8_t> > frames = neopixel_sim.frames();
+            if (frames.empty() || !frameIs(frames.back(), strip)) {
+                ++failures;
+            }
+        }
+        CHECK_EQ(failures, 0);
+    }
+}
+
+int main() {
+    srand(1);
+    testBitTimings();
+    testChunks();
+    testRestart();
+    testRestartBoundary();
+    return TEST_RESULT();
+}
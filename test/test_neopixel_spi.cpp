@@ -0,0 +1,121 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Decode the NeoPixel SPI waveform back into color bytes.
+ *
+ * The decoder models the NeoPixel input: the MOSI bit stream at the SPI
+ * clock becomes a series of high pulses, each starting a data bit, and a
+ * pulse longer than the sample point is a one.  The low time which ends
+ * the stream must meet the latch time.
+ */
+
+#include "neopixel_spi.h"
+#include "test.h"
+#include <stdlib.h>
+#include <vector>
+
+/** The time after the rising edge at which a NeoPixel samples its input. */
+const double SAMPLE_NS = 500.0;
+
+struct Decoded {
+    std::vector<uint8_t> bytes;
+    double minPeriodNs;
+    double maxPeriodNs;
+    double latchNs;  // the low time after the last pulse
+};
+
+static Decoded decode(const uint8_t * spi, int length, uint32_t spi_hz) {
+    Decoded d;
+    double bitNs = 1e9 / spi_hz;
+    d.minPeriodNs = 1e30;
+    d.maxPeriodNs = 0;
+    int bits = 0;
+    uint8_t value = 0;
+    long rise = -1;   // the SPI bit of the last rising edge
+    long fall = -1;
+    bool level = false;
+    long total = (long) length * 8;
+    for (long i = 0; i < total; ++i) {
+        bool b = (spi[i >> 3] >> (7 - (i & 7))) & 1;
+        if (b && !level) {
+            if (rise >= 0) {
+                double period = (i - rise) * bitNs;
+                if (period < d.minPeriodNs) {
+                    d.minPeriodNs = period;
+                }
+                if (period > d.maxPeriodNs) {
+                    d.maxPeriodNs = period;
+                }
+            }
+            rise = i;
+        } else if (!b && level) {
+            fall = i;
+            value = (uint8_t) ((value << 1) | (((fall - rise) * bitNs) > SAMPLE_NS));
+            if (++bits == 8) {
+                d.bytes.push_back(value);
+                bits = 0;
+            }
+        }
+        level = b;
+    }
+    CHECK(!level);
+    CHECK_EQ(bits, 0);
+    d.latchNs = (total - fall) * bitNs;
+    return d;
+}
+
+static void checkMode(NeoPixelSpiEncoder::Mode mode, uint32_t spi_hz) {
+    NeoPixelSpiEncoder encoder(mode);
+    const int length = 300 * 3;
+    std::vector<uint8_t> pixels(length);
+    for (int i = 0; i < length; ++i) {
+        // Every byte value, then random values
+        pixels[i] = (uint8_t) ((i < 256) ? i : rand());
+    }
+    std::vector<uint8_t> out(encoder.encodedSize(length) +
+                             NeoPixelSpiEncoder::latchSize(spi_hz, 50));
+    CHECK_EQ(encoder.bytesPerByte(), (int) mode);
+    int sz = encoder.encode(&pixels[0], length, &out[0]);
+    CHECK_EQ(sz, length * (int) mode);
+    sz += encoder.latch(&out[sz], spi_hz, 50);
+    CHECK_EQ(sz, (int) out.size());
+
+    Decoded d = decode(&out[0], sz, spi_hz);
+    CHECK(d.bytes == pixels);
+    // Every data bit has the same period
+    CHECK(d.minPeriodNs == d.maxPeriodNs);
+    CHECK(d.latchNs >= 50000.0);
+
+    // The optional table is applied before encoding
+    uint8_t lut[256];
+    for (int i = 0; i < 256; ++i) {
+        lut[i] = (uint8_t) (255 - i);
+    }
+    sz = encoder.encode(&pixels[0], length, &out[0], lut);
+    sz += encoder.latch(&out[sz], spi_hz, 50);
+    d = decode(&out[0], sz, spi_hz);
+    CHECK_EQ(d.bytes.size(), length);
+    int mismatches = 0;
+    for (int i = 0; i < length; ++i) {
+        mismatches += (d.bytes[i] != lut[pixels[i]]);
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+static void testLatchSize() {
+    CHECK_EQ(NeoPixelSpiEncoder::latchSize(8000000, 50), 50);
+    CHECK_EQ(NeoPixelSpiEncoder::latchSize(3200000, 50), 20);
+    CHECK_EQ(NeoPixelSpiEncoder::latchSize(6400000, 50), 40);
+    CHECK_EQ(NeoPixelSpiEncoder::latchSize(1000000, 1), 1);
+    CHECK_EQ(NeoPixelSpiEncoder::latchSize(1000000, 0), 0);
+}
+
+int main() {
+    srand(1);
+    checkMode(NeoPixelSpiEncoder::MODE_8BIT, 8000000);
+    checkMode(NeoPixelSpiEncoder::MODE_8BIT, 6400000);
+    checkMode(NeoPixelSpiEncoder::MODE_4BIT, 3200000);
+    testLatchSize();
+    return TEST_RESULT();
+}
@@ -0,0 +1,200 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Simulate 1000 clients reconnecting after a server restart.
+ *
+ * The stub server is down for the first 10 seconds and then accepts at
+ * most SERVER_CAPACITY connections per 100 ms window.  Refused attempts
+ * count as failures.  Every client loses its connection at time 0.  The
+ * old clients retried every second in lock-step; the new clients use
+ * ReconnectScheduler.  The mbed Websocket state machine is also run
+ * against a refusing server through the mock socket.
+ */
+
+#include "reconnect.h"
+#include "Websocket.h"
+#include "quiet_stdout.h"
+#include "test.h"
+#include <vector>
+
+const int CLIENTS = 1000;
+const uint32_t DOWN_MS = 10000;
+const uint32_t WINDOW_MS = 100;
+const int SERVER_CAPACITY = 50;
+const uint32_t SIM_MS = 300000;
+
+struct StormResult {
+    int attempts;
+    int peak;            // the most attempts in one window
+    int upPeak;          // the most attempts in one window once up
+    uint32_t doneMs;     // the time when every client is connected
+};
+
+/** The stub server. */
+class Server {
+public:
+    Server() : window_(0xffffffff), accepted_(0), attempts_(0), peak_(0), upPeak_(0) {}
+
+    bool connect(uint32_t nowMs) {
+        uint32_t w = nowMs / WINDOW_MS;
+        if (w != window_) {
+            window_ = w;
+            accepted_ = 0;
+            attempts_ = 0;
+        }
+        if (++attempts_ > peak_) {
+            peak_ = attempts_;
+        }
+        if ((nowMs >= DOWN_MS) && (attempts_ > upPeak_)) {
+            upPeak_ = attempts_;
+        }
+        if ((nowMs < DOWN_MS) || (accepted_ >= SERVER_CAPACITY)) {
+            return false;
+        }
+        ++accepted_;
+        return true;
+    }
+
+    int peak() const { return peak_; }
+    int upPeak() const { return upPeak_; }
+
+private:
+    uint32_t window_;
+    int accepted_;
+    int attempts_;
+    int peak_;
+    int upPeak_;
+};
+
+/** The old clients: retry one second after each failure. */
+static StormResult lockStep() {
+    Server server;
+    StormResult r = {0, 0, 0, 0};
+    // Every client lost its connection at time 0
+    std::vector<uint32_t> next(CLIENTS, 1000);
+    std::vector<bool> connected(CLIENTS, false);
+    int remaining = CLIENTS;
+    for (uint32_t now = 0; (now < SIM_MS) && remaining; ++now) {
+        for (int i = 0; i < CLIENTS; ++i) {
+            if (connected[i] || (now < next[i])) {
+                continue;
+            }
+            ++r.attempts;
+            if (server.connect(now)) {
+                connected[i] = true;
+                --remaining;
+                r.doneMs = now;
+            } else {
+                next[i] = now + 1000;
+            }
+        }
+    }
+    r.peak = server.peak();
+    r.upPeak = server.upPeak();
+    return remaining ? StormResult() : r;
+}
+
+static StormResult backoff(uint32_t baseMs, uint32_t maxMs) {
+    Server server;
+    StormResult r = {0, 0, 0, 0};
+    std::vector<ReconnectScheduler> clients;
+    for (int i = 0; i < CLIENTS; ++i) {
+        // Each device seeds from its own address
+        clients.push_back(ReconnectScheduler(baseMs, maxMs, 0x2c3ae000 + i * 2654435761u));
+        clients.back().failed(0);  // the lost connection, as in the clients
+    }
+    std::vector<bool> connected(CLIENTS, false);
+    int remaining = CLIENTS;
+    for (uint32_t now = 0; (now < SIM_MS) && remaining; ++now) {
+        for (int i = 0; i < CLIENTS; ++i) {
+            if (connected[i] || !clients[i].ready(now)) {
+                continue;
+            }
+            ++r.attempts;
+            if (server.connect(now)) {
+                clients[i].reset();
+                connected[i] = true;
+                --remaining;
+                r.doneMs = now;
+            } else {
+                clients[i].failed(now);
+            }
+        }
+    }
+    r.peak = server.peak();
+    r.upPeak = server.upPeak();
+    return remaining ? StormResult() : r;
+}
+
+static void print(const char * name, const StormResult & r) {
+    printf("  %-22s %8d %8d %8d %8.1f\n", name, r.attempts, r.peak, r.upPeak,
+           r.doneMs / 1000.0);
+}
+
+static void testStorm() {
+    printf("%d clients, server down %u s, %d connections per %u ms:\n",
+           CLIENTS, DOWN_MS / 1000, SERVER_CAPACITY, WINDOW_MS);
+    printf("  %-22s %8s %8s %8s %8s\n", "", "attempts", "peak", "up peak", "done s");
+    StormResult old = lockStep();
+    print("lock-step 1 s", old);
+    StormResult r = backoff(500, 60000);
+    print("backoff 0.5 s to 60 s", r);
+    StormResult fast = backoff(500, 8000);
+    print("backoff 0.5 s to 8 s", fast);
+
+    // Every client eventually connects
+    CHECK(old.doneMs > 0);
+    CHECK(r.doneMs > 0);
+    CHECK(fast.doneMs > 0);
+    // Lock-step clients all hit the server in the same window
+    CHECK_EQ(old.peak, CLIENTS);
+    CHECK_EQ(old.upPeak, CLIENTS);
+    // Jitter spreads the storm out, most of all when the server returns
+    CHECK(r.peak * 3 < old.peak);
+    CHECK(fast.peak * 3 < old.peak);
+    CHECK(r.upPeak * 10 < old.upPeak);
+    CHECK(fast.upPeak * 10 < old.upPeak);
+    CHECK(r.attempts * 2 < old.attempts);
+    CHECK(fast.attempts * 2 < old.attempts);
+}
+
+/** The Websocket state machine backs off against a refusing server. */
+static void testWebsocket() {
+    MockNet & net = mock_net();
+    net.reset();
+    net.refuse = true;
+    Websocket ws((char *) "ws://example.com/ws");
+    ws.setReconnect(500, 8000, 1234);
+    QuietStdout quiet;
+    std::vector<uint64_t> attempts;
+    uint64_t start = host_clock_us();
+    int connects = 0;
+    while (host_clock_us() - start < 60000000ULL) {
+        CHECK(!ws.poll());
+        if (net.connects != connects) {
+            connects = net.connects;
+            attempts.push_back(host_clock_us() - start);
+        }
+        wait_ms(1);
+    }
+    // A 1 s lock-step retry would make 60 attempts
+    CHECK(attempts.size() >= 5);
+    CHECK(attempts.size() < 30);
+    for (size_t i = 1; i < attempts.size(); ++i) {
+        // No delay exceeds the maximum
+        CHECK(attempts[i] - attempts[i - 1] <= 8000000ULL + 1000);
+    }
+    net.refuse = false;
+    for (int i = 0; (i < 10000) && !ws.poll(); ++i) {
+        wait_ms(1);
+    }
+    CHECK(ws.is_connected());
+    CHECK(ws.state() == Websocket::STATE_OPEN);
+}
+
+int main() {
+    testStorm();
+    testWebsocket();
+    return TEST_RESULT();
+}
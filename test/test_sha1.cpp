@@ -0,0 +1,148 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Check Sha1Class against the FIPS 180 example messages and the RFC 2202
+ * HMAC-SHA1 test cases, fed whole, one byte at a time and split at every
+ * boundary.
+ */
+
+#include "sha1.h"
+#include "test.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+static std::string hex(const uint8_t * h) {
+    char s[2 * HASH_LENGTH + 1];
+    for (int i = 0; i < HASH_LENGTH; ++i) {
+        snprintf(s + 2 * i, 3, "%02x", h[i]);
+    }
+    return s;
+}
+
+struct Vector {
+    const char * message;
+    const char * digest;
+};
+
+// FIPS 180-2 appendix A and the NIST SHA example files
+static const Vector VECTORS[] = {
+    {"abc", "a9993e364706816aba3e25717850c26c9cd0d89d"},
+    {"", "da39a3ee5e6b4b0d3255bfef95601890afd80709"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+     "84983e441c3bd26ebaae4aa1f95129e5e54670f1"},
+    {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+     "ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+     "a49b2446a02c645bf419f995b67091253a04a259"},
+    {"The quick brown fox jumps over the lazy dog",
+     "2fd4e1c67a2d28fced849ee1bb76e7391b93eb12"},
+};
+
+static void testVectors() {
+    Sha1Class s;
+    for (size_t k = 0; k < sizeof(VECTORS) / sizeof(VECTORS[0]); ++k) {
+        const char * m = VECTORS[k].message;
+        size_t n = strlen(m);
+        s.init();
+        s.update(m, n);
+        CHECK(hex(s.result()) == VECTORS[k].digest);
+
+        s.init();
+        for (size_t i = 0; i < n; ++i) {
+            s.write((uint8_t) m[i]);
+        }
+        CHECK(hex(s.result()) == VECTORS[k].digest);
+
+        s.init();
+        s.print(m);
+        CHECK(hex(s.result()) == VECTORS[k].digest);
+    }
+}
+
+/** One million repetitions of 'a', in uneven pieces. */
+static void testMillion() {
+    static char a[1000000];
+    memset(a, 'a', sizeof(a));
+    static const size_t pieces[] = {1000000, 64, 7777, 1};
+    for (size_t k = 0; k < sizeof(pieces) / sizeof(pieces[0]); ++k) {
+        Sha1Class s;
+        s.init();
+        for (size_t i = 0; i < sizeof(a); i += pieces[k]) {
+            size_t n = sizeof(a) - i;
+            s.update(a + i, (n < pieces[k]) ? n : pieces[k]);
+        }
+        CHECK(hex(s.result()) == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+    }
+}
+
+/** Every split of messages around the block and padding edges. */
+static void testSplit() {
+    uint8_t data[200];
+    for (int i = 0; i < (int) sizeof(data); ++i) {
+        data[i] = (uint8_t) (i * 37 + 11);
+    }
+    Sha1Class s;
+    for (size_t n = 0; n <= sizeof(data); ++n) {
+        s.init();
+        s.update(data, n);
+        std::string whole = hex(s.result());
+        int failures = 0;
+        for (size_t split = 0; split <= n; ++split) {
+            s.init();
+            s.update(data, split);
+            s.update(data + split, n - split);
+            failures += hex(s.result()) != whole;
+        }
+        CHECK_EQ(failures, 0);
+    }
+}
+
+struct HmacVector {
+    uint8_t key;
+    int keyLength;
+    const char * data;
+    int dataLength;
+    const char * digest;
+};
+
+// RFC 2202 section 3, except test case 5, which truncates the output
+static const HmacVector HMAC_VECTORS[] = {
+    {0x0b, 20, "Hi There", 8, "b617318655057264e28bc0b6fb378c8ef146be00"},
+    {0, 0, "what do ya want for nothing?", 28, "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79"},
+    {0xaa, 20, 0, 50, "125d7342b9ac11cd91a39af48aa17b4f63f175d3"},
+    {0xaa, 80, "Test Using Larger Than Block-Size Key - Hash Key First", 54,
+     "aa4ae5e15272d00e95705637ce8a3b55ed402112"},
+    {0xaa, 80, "Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data", 73,
+     "e8e99d0f45237d786d6bbaa7965c7808bbff1a91"},
+};
+
+static void testHmac() {
+    Sha1Class s;
+    for (size_t k = 0; k < sizeof(HMAC_VECTORS) / sizeof(HMAC_VECTORS[0]); ++k) {
+        const HmacVector & v = HMAC_VECTORS[k];
+        uint8_t key[80];
+        uint8_t data[80];
+        if (v.keyLength) {
+            memset(key, v.key, v.keyLength);
+            s.initHmac(key, v.keyLength);
+        } else {
+            s.initHmac((const uint8_t *) "Jefe", 4);
+        }
+        if (v.data) {
+            memcpy(data, v.data, v.dataLength);
+        } else {
+            memset(data, 0xdd, v.dataLength);
+        }
+        s.update(data, v.dataLength);
+        CHECK(hex(s.resultHmac()) == v.digest);
+    }
+}
+
+int main() {
+    testVectors();
+    testMillion();
+    testSplit();
+    testHmac();
+    return TEST_RESULT();
+}
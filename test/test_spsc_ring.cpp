@@ -0,0 +1,169 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Stress SpscRing with a producer and a consumer std::thread.
+ *
+ * The producer sends numbered records with push() and write()/commit()
+ * while the consumer receives them with pop(), read()/release() and
+ * drain().  Every record must arrive once, in order and intact.  Each
+ * run prints its rate, which includes a yield() on every empty or full
+ * poll since the host may have a single core; bench_spsc_ring measures
+ * the ring without the mixed access patterns.  The program is also built with the ARM Compiler 5 index accessors, with
+ * __dmb() mapped to a full fence.
+ */
+
+#if defined(__ARMCC_VERSION)
+#define __dmb(x) __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+#include "spsc_ring.h"
+#include "test.h"
+#include <chrono>
+#include <thread>
+
+struct Record {
+    uint32_t id;
+    uint32_t data[7];  // larger than a word so that torn copies show up
+};
+
+static void fill(Record & r, uint32_t id) {
+    r.id = id;
+    for (int i = 0; i < 7; ++i) {
+        r.data[i] = id * 2654435761u + i;
+    }
+}
+
+static bool intact(const Record & r, uint32_t id) {
+    if (r.id != id) {
+        return false;
+    }
+    for (int i = 0; i < 7; ++i) {
+        if (r.data[i] != id * 2654435761u + i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Checker {
+    uint32_t next;
+    uint32_t errors;
+
+    Checker() : next(0), errors(0) {}
+
+    void operator()(Record & r) {
+        errors += !intact(r, next);
+        ++next;
+    }
+};
+
+/** Send records through a ring of N records.
+ *
+ * A one-record ring hands over every record with a thread switch on a
+ * single core, so it runs fewer records than the larger rings.
+ */
+template <uint32_t N>
+static void stress(uint32_t records) {
+    static SpscRing<Record, N> ring;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::thread producer([records]() {
+        uint32_t id = 0;
+        while (id < records) {
+            bool sent = false;
+            if (id & 1) {
+                Record r;
+                fill(r, id);
+                sent = ring.push(r);
+            } else {
+                Record * r = ring.write();
+                if (r) {
+                    fill(*r, id);
+                    ring.commit();
+                    sent = true;
+                }
+            }
+            if (sent) {
+                ++id;
+            } else {
+                std::this_thread::yield();  // the host may have a single core
+            }
+        }
+    });
+
+    Checker checker;
+    uint32_t maxSize = 0;
+    while (checker.next < records) {
+        uint32_t before = checker.next;
+        uint32_t size = ring.size();
+        if (size > maxSize) {
+            maxSize = size;
+        }
+        switch (checker.next % 3) {
+        case 0: {
+            Record r;
+            if (ring.pop(&r)) {
+                checker(r);
+            }
+            break;
+        }
+        case 1: {
+            Record * r = ring.read();
+            if (r) {
+                checker(*r);
+                ring.release();
+            }
+            break;
+        }
+        default:
+            ring.drain(checker, 1 + checker.next % 5);
+            break;
+        }
+        if (checker.next == before) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+    printf("SpscRing<Record, %3u>: %u records, %.2f M records/s\n", N, records,
+           records / dt.count() / 1e6);
+    CHECK_EQ(checker.errors, 0);
+    CHECK_EQ(checker.next, records);
+    CHECK(maxSize <= N);
+    CHECK_EQ(ring.size(), 0);
+    Record r;
+    CHECK(!ring.pop(&r));
+}
+
+static void testSingleThread() {
+    SpscRing<Record, 4> ring;
+    const SpscRing<Record, 4> & view = ring;
+    CHECK_EQ(view.capacity(), 4);
+    Record r;
+    for (uint32_t i = 0; i < 4; ++i) {
+        fill(r, i);
+        CHECK(ring.push(r));
+        CHECK_EQ(view.size(), i + 1);
+    }
+    CHECK(!ring.push(r));
+    CHECK(ring.write() == NULL);
+    Checker checker;
+    CHECK_EQ(ring.drain(checker, 3), 3);
+    CHECK_EQ(view.size(), 1);
+    CHECK(ring.pop(&r));
+    checker(r);
+    CHECK_EQ(checker.errors, 0);
+    CHECK_EQ(view.size(), 0);
+    CHECK(ring.read() == NULL);
+}
+
+int main() {
+    testSingleThread();
+    stress<1>(500000);
+    stress<8>(4000000);
+    stress<256>(20000000);
+#if defined(__ARMCC_VERSION)
+    printf("ARM Compiler 5 accessors: ");
+#endif
+    return TEST_RESULT();
+}
@@ -0,0 +1,193 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Check the WebSocket payload length edges: 125 bytes, the largest
+ * 7-bit length, 126 bytes, the first 16-bit length, 65535 bytes, the
+ * largest 16-bit length, and 65536 bytes, the first 64-bit length.
+ *
+ * The parser is fed each frame split at every header byte.  Both clients
+ * receive each frame, masked and unmasked, in several chunk sizes and
+ * must deliver it or close with 1009 as their maximum message size
+ * allows, and must send frames with the matching header form.  The
+ * program is built with the default maximum sizes and with a 65535 byte
+ * maximum.
+ */
+
+#include "ws_client.h"
+#include "ws_frames.h"
+#include "ws_parser.h"
+#include "mock_net.h"
+#include "test.h"
+#include <stdio.h>
+
+static const uint32_t LENGTHS[] = {0, 1, 124, 125, 126, 127, 65535, 65536};
+static const uint8_t MASK[4] = {0x12, 0x34, 0x56, 0x78};
+
+static std::string pattern(size_t n) {
+    std::string s(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        s[i] = (char) ('a' + (i * 11) % 26);
+    }
+    return s;
+}
+
+static int headerLength(uint64_t n, bool masked) {
+    return ((n < 126) ? 2 : (n <= 0xffff) ? 4 : 10) + (masked ? 4 : 0);
+}
+
+/** Parse a frame fed as two pieces, returning the payload or an error. */
+static bool parse(const Bytes & frame, size_t split, uint32_t max, std::string & payload,
+                  WsParser::Error & error) {
+    WsParser parser(max);
+    Bytes data = frame;
+    size_t pieces[2] = {split, data.size() - split};
+    size_t offset = 0;
+    payload.clear();
+    error = WsParser::ERROR_NONE;
+    bool last = false;
+    for (int p = 0; p < 2; ++p) {
+        uint8_t * d = &data[0] + offset;
+        int n = (int) pieces[p];
+        offset += pieces[p];
+        while (n > 0) {
+            WsChunk chunk;
+            int rc = parser.parse(d, n, &chunk);
+            if (rc < 0) {
+                error = parser.error();
+                return false;
+            }
+            d += rc;
+            n -= rc;
+            if (chunk.ready) {
+                payload.append((const char *) chunk.data, chunk.length);
+                last = chunk.last;
+            }
+        }
+    }
+    return last && !parser.inFrame();
+}
+
+static void testParser() {
+    for (size_t k = 0; k < sizeof(LENGTHS) / sizeof(LENGTHS[0]); ++k) {
+        uint32_t n = LENGTHS[k];
+        std::string data = pattern(n);
+        for (int masked = 0; masked < 2; ++masked) {
+            Bytes frame = ws_frame(WS_OPCODE_BINARY, bytes(data), true, masked ? MASK : 0);
+            int header = headerLength(n, masked);
+            CHECK_EQ(frame.size(), header + n);
+            int failures = 0;
+            for (int split = 0; split <= header + 1 && split <= (int) frame.size(); ++split) {
+                std::string payload;
+                WsParser::Error error;
+                // At the maximum and one byte over
+                failures += !parse(frame, split, n, payload, error) || (payload != data);
+                if (n > 0) {
+                    failures += parse(frame, split, n - 1, payload, error) ||
+                            (error != WsParser::ERROR_TOO_LARGE);
+                }
+            }
+            CHECK_EQ(failures, 0);
+        }
+    }
+
+    // A 64-bit length beyond 32 bits is too large for any maximum
+    Bytes frame;
+    frame.push_back(0x82);
+    frame.push_back(127);
+    static const uint8_t length[8] = {0, 0, 0, 1, 0, 0, 0, 0};
+    frame.insert(frame.end(), length, length + 8);
+    std::string payload;
+    WsParser::Error error;
+    CHECK(!parse(frame, 5, 0xffffffff, payload, error));
+    CHECK_EQ(error, WsParser::ERROR_TOO_LARGE);
+}
+
+static std::string closeStatus(uint16_t code) {
+    return std::string(1, (char) (code >> 8)) + std::string(1, (char) (code & 0xff));
+}
+
+static void testReceive(WsTestClient * (*factory)()) {
+    static const size_t chunks[] = {1, 3, 128, 1 << 20};
+    WsTestClient * probe = factory();
+    uint32_t max = probe->maxMessage();
+    const char * name = probe->name();
+    delete probe;
+    for (size_t k = 0; k < sizeof(LENGTHS) / sizeof(LENGTHS[0]); ++k) {
+        uint32_t n = LENGTHS[k];
+        std::string data = pattern(n);
+        int failures = 0;
+        for (int masked = 0; masked < 2; ++masked) {
+            // A text frame after the tested frame checks that it was consumed
+            Bytes frames = ws_frame(WS_OPCODE_BINARY, bytes(data), true, masked ? MASK : 0) +
+                    ws_frame(WS_OPCODE_TEXT, "next");
+            for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); ++c) {
+                MockNet & net = mock_net();
+                net.reset();
+                WsTestClient * client = factory();
+                bool ok = client->connect();
+                net.sent.clear();
+                net.pushSplit(frames, chunks[c]);
+                std::vector<WsMessage> messages;
+                client->receive(messages);
+                if (n <= max) {
+                    ok = ok && (messages.size() == 2) &&
+                            (messages[0].opcode == WS_OPCODE_BINARY) &&
+                            (messages[0].data == data) && (messages[1].data == "next") &&
+                            net.sent.empty() && client->connected();
+                } else {
+                    std::vector<WsFrame> replies = ws_decode(net.sent);
+                    ok = ok && messages.empty() && (replies.size() == 1) &&
+                            (replies[0].opcode == WS_OPCODE_CLOSE) &&
+                            (replies[0].text() == closeStatus(WS_CLOSE_TOO_LARGE)) &&
+                            !client->connected();
+                }
+                failures += !ok;
+                delete client;
+            }
+        }
+        CHECK_EQ(failures, 0);
+        if (failures) {
+            printf("%s: %u byte frames failed %d times\n", name, n, failures);
+        }
+    }
+}
+
+static void testSend(WsTestClient * (*factory)()) {
+    MockNet & net = mock_net();
+    net.reset();
+    WsTestClient * client = factory();
+    CHECK(client->connect());
+    for (size_t k = 0; k < sizeof(LENGTHS) / sizeof(LENGTHS[0]); ++k) {
+        uint32_t n = LENGTHS[k];
+        // Both clients take 16-bit lengths and send up to their maximum
+        if ((n > client->maxMessage()) || (n > 0xffff)) {
+            continue;
+        }
+        std::string data = pattern(n);
+        net.sent.clear();
+        CHECK(client->send(WS_OPCODE_BINARY, data));
+        size_t rest;
+        std::vector<WsFrame> frames = ws_decode(net.sent, &rest);
+        CHECK_EQ(rest, 0);
+        CHECK_EQ(frames.size(), 1);
+        if (frames.size() == 1) {
+            CHECK_EQ(frames[0].headerLength, headerLength(n, true));
+            CHECK(frames[0].text() == data);
+        }
+    }
+    delete client;
+}
+
+int main() {
+    testParser();
+    WsTestClient * (*factories[])() = {ws_client_mbed, ws_client_energia};
+    for (int c = 0; c < 2; ++c) {
+        testReceive(factories[c]);
+        testSend(factories[c]);
+    }
+    WsTestClient * client = ws_client_energia();
+    printf("maximum message %u bytes: ", client->maxMessage());
+    delete client;
+    return TEST_RESULT();
+}
@@ -0,0 +1,276 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Check the WebSocket frame parser directly and through the mbed client
+ * reading from a mock socket: headers split at every byte, several frames
+ * in one read and frames at the maximum size.
+ */
+
+#include "Websocket.h"
+#include "ws_frames.h"
+#include "quiet_stdout.h"
+#include "test.h"
+
+const uint32_t MAX_PAYLOAD = 1024;
+
+static Bytes pattern(size_t n) {
+    Bytes b(n);
+    for (size_t i = 0; i < n; ++i) {
+        b[i] = (uint8_t) (i * 7 + 3);
+    }
+    return b;
+}
+
+/** Parse data in pieces split at the given offsets. */
+static std::vector<WsFrame> parseSplit(WsParser & parser, Bytes data,
+                                       const std::vector<size_t> & splits,
+                                       int * error) {
+    std::vector<WsFrame> frames;
+    WsFrame frame = WsFrame();
+    size_t start = 0;
+    *error = 0;
+    for (size_t k = 0; k <= splits.size(); ++k) {
+        size_t end = (k < splits.size()) ? splits[k] : data.size();
+        int pos = (int) start;
+        while (pos < (int) end) {
+            WsChunk chunk;
+            int ret = parser.parse(&data[pos], (int) end - pos, &chunk);
+            if (ret < 0) {
+                *error = parser.error();
+                return frames;
+            }
+            pos += ret;
+            if (!chunk.ready) {
+                continue;
+            }
+            if (chunk.first) {
+                frame.payload.clear();
+                frame.opcode = chunk.opcode;
+                frame.fin = chunk.fin;
+            }
+            frame.payload.insert(frame.payload.end(), chunk.data, chunk.data + chunk.length);
+            if (chunk.last) {
+                frames.push_back(frame);
+            }
+        }
+        start = end;
+    }
+    return frames;
+}
+
+static std::vector<WsFrame> parseAll(WsParser & parser, const Bytes & data, int * error) {
+    return parseSplit(parser, data, std::vector<size_t>(), error);
+}
+
+/** Every header form split into two reads at every byte. */
+static void testSplitHeader() {
+    static const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+    std::vector<Bytes> payloads;
+    payloads.push_back(Bytes());
+    payloads.push_back(pattern(5));
+    payloads.push_back(pattern(200));
+    payloads.push_back(pattern(70000));
+    for (size_t p = 0; p < payloads.size(); ++p) {
+        for (int masked = 0; masked < 2; ++masked) {
+            Bytes frame = ws_frame(WS_OPCODE_BINARY, payloads[p], true,
+                                   masked ? mask : 0);
+            // Split within the header and the first payload bytes
+            size_t limit = frame.size() - payloads[p].size() + 4;
+            if (limit > frame.size()) {
+                limit = frame.size();
+            }
+            for (size_t split = 1; split < limit; ++split) {
+                WsParser parser(100000);
+                int error;
+                std::vector<WsFrame> frames =
+                        parseSplit(parser, frame, std::vector<size_t>(1, split), &error);
+                CHECK_EQ(error, 0);
+                CHECK_EQ(frames.size(), 1);
+                if (frames.size() == 1) {
+                    CHECK_EQ(frames[0].opcode, WS_OPCODE_BINARY);
+                    CHECK(frames[0].payload == payloads[p]);
+                }
+                CHECK(!parser.inFrame());
+            }
+        }
+    }
+
+    // One byte per read
+    Bytes frame = ws_frame(WS_OPCODE_TEXT, pattern(300));
+    std::vector<size_t> splits;
+    for (size_t i = 1; i < frame.size(); ++i) {
+        splits.push_back(i);
+    }
+    WsParser parser(MAX_PAYLOAD);
+    int error;
+    std::vector<WsFrame> frames = parseSplit(parser, frame, splits, &error);
+    CHECK_EQ(error, 0);
+    CHECK_EQ(frames.size(), 1);
+    CHECK(frames.size() && (frames[0].payload == pattern(300)));
+}
+
+/** Several frames of every kind in a single read. */
+static void testManyFrames() {
+    Bytes data = ws_frame(WS_OPCODE_TEXT, "one") +
+                 ws_frame(WS_OPCODE_BINARY, Bytes()) +
+                 ws_frame(WS_OPCODE_PING, "ping") +
+                 ws_frame(WS_OPCODE_TEXT, "frag", false) +
+                 ws_frame(WS_OPCODE_CONTINUATION, pattern(130), true) +
+                 ws_frame(WS_OPCODE_TEXT, "last");
+    WsParser parser(MAX_PAYLOAD);
+    int error;
+    std::vector<WsFrame> frames = parseAll(parser, data, &error);
+    CHECK_EQ(error, 0);
+    CHECK_EQ(frames.size(), 6);
+    if (frames.size() == 6) {
+        CHECK(frames[0].text() == "one");
+        CHECK_EQ(frames[1].opcode, WS_OPCODE_BINARY);
+        CHECK(frames[1].payload.empty());
+        CHECK_EQ(frames[2].opcode, WS_OPCODE_PING);
+        CHECK(!frames[3].fin);
+        CHECK_EQ(frames[4].opcode, WS_OPCODE_CONTINUATION);
+        CHECK(frames[4].payload == pattern(130));
+        CHECK(frames[5].text() == "last");
+    }
+}
+
+/** Frames at the maximum size pass and one more byte fails. */
+static void testMaxSize() {
+    for (int extra = 0; extra < 2; ++extra) {
+        WsParser parser(MAX_PAYLOAD);
+        int error;
+        std::vector<WsFrame> frames = parseAll(
+                parser, ws_frame(WS_OPCODE_BINARY, pattern(MAX_PAYLOAD + extra)), &error);
+        if (extra) {
+            CHECK_EQ(error, WsParser::ERROR_TOO_LARGE);
+            CHECK(frames.empty());
+        } else {
+            CHECK_EQ(error, 0);
+            CHECK(frames.size() && (frames[0].payload == pattern(MAX_PAYLOAD)));
+        }
+    }
+    // A 64-bit length beyond 32 bits
+    Bytes huge;
+    huge.push_back(0x82);
+    huge.push_back(127);
+    static const uint8_t len[8] = {0, 0, 0, 1, 0, 0, 0, 0};
+    huge.insert(huge.end(), len, len + 8);
+    WsParser parser(MAX_PAYLOAD);
+    int error;
+    parseAll(parser, huge, &error);
+    CHECK_EQ(error, WsParser::ERROR_TOO_LARGE);
+}
+
+static MockNet & connect(Websocket & ws) {
+    MockNet & net = mock_net();
+    net.reset();
+    {
+        QuietStdout quiet;
+        CHECK(ws.connect());
+    }
+    CHECK(net.sent.empty());
+    return net;
+}
+
+/** Read until a message arrives or the mock socket runs dry. */
+static bool readMessage(Websocket & ws, std::string * msg, uint8_t * opcode = NULL) {
+    for (int i = 0; i < 100000; ++i) {
+        char * p;
+        int n;
+        if (ws.read(&p, &n, opcode)) {
+            msg->assign(p, n);
+            return true;
+        }
+        if (mock_net().rx.empty() && mock_net().arrived.empty()) {
+            // One more read to parse anything already received
+            return false;
+        }
+    }
+    return false;
+}
+
+static void testClientSplit() {
+    Websocket ws((char *) "ws://example.com:8000/ws");
+    MockNet & net = connect(ws);
+    Bytes payload = pattern(600);
+    Bytes data = ws_frame(WS_OPCODE_TEXT, "hello") +
+                 ws_frame(WS_OPCODE_BINARY, payload) +
+                 ws_frame(WS_OPCODE_TEXT, "frag", false) +
+                 ws_frame(WS_OPCODE_PING, "p") +
+                 ws_frame(WS_OPCODE_CONTINUATION, "ment");
+    net.pushSplit(data, 1);
+    std::string msg;
+    uint8_t opcode;
+    CHECK(readMessage(ws, &msg, &opcode));
+    CHECK(msg == "hello");
+    CHECK(readMessage(ws, &msg, &opcode));
+    CHECK_EQ(opcode, WS_OPCODE_BINARY);
+    CHECK(msg == std::string(payload.begin(), payload.end()));
+    CHECK(readMessage(ws, &msg, &opcode));
+    CHECK(msg == "fragment");
+    std::vector<WsFrame> sent = ws_decode(net.sent);
+    CHECK_EQ(sent.size(), 1);
+    CHECK(sent.size() && (sent[0].opcode == WS_OPCODE_PONG) && sent[0].masked &&
+          (sent[0].text() == "p"));
+    CHECK(ws.is_connected());
+}
+
+static void testClientManyFrames() {
+    Websocket ws((char *) "ws://example.com/ws");
+    MockNet & net = connect(ws);
+    Bytes data;
+    for (int i = 0; i < 20; ++i) {
+        data = data + ws_frame(WS_OPCODE_TEXT, std::string(i, 'a' + i));
+    }
+    net.push(data);
+    for (int i = 0; i < 20; ++i) {
+        std::string msg;
+        CHECK(readMessage(ws, &msg));
+        CHECK(msg == std::string(i, 'a' + i));
+        if (i == 0) {
+            // The whole chunk arrived with the first receive
+            CHECK(net.rx.empty());
+        }
+    }
+    std::string msg;
+    CHECK(!readMessage(ws, &msg));
+    CHECK(ws.is_connected());
+}
+
+static void testClientMaxSize() {
+    Websocket ws((char *) "ws://example.com/ws");
+    MockNet & net = connect(ws);
+    Bytes payload = pattern(WEBSOCKET_MAX_MESSAGE_SIZE);
+    net.pushSplit(ws_frame(WS_OPCODE_BINARY, payload), 100);
+    std::string msg;
+    CHECK(readMessage(ws, &msg));
+    CHECK(msg == std::string(payload.begin(), payload.end()));
+
+    // Fragments up to the maximum reassemble
+    Bytes half(payload.begin(), payload.begin() + WEBSOCKET_MAX_MESSAGE_SIZE / 2);
+    net.push(ws_frame(WS_OPCODE_BINARY, half, false) +
+             ws_frame(WS_OPCODE_CONTINUATION, half, true));
+    CHECK(readMessage(ws, &msg));
+    CHECK_EQ(msg.size(), WEBSOCKET_MAX_MESSAGE_SIZE);
+
+    // One byte more closes with 1009
+    net.push(ws_frame(WS_OPCODE_BINARY, pattern(WEBSOCKET_MAX_MESSAGE_SIZE + 1)));
+    CHECK(!readMessage(ws, &msg));
+    std::vector<WsFrame> sent = ws_decode(net.sent);
+    CHECK_EQ(sent.size(), 1);
+    CHECK(sent.size() && (sent[0].opcode == WS_OPCODE_CLOSE) &&
+          (sent[0].payload.size() == 2) &&
+          (((sent[0].payload[0] << 8) | sent[0].payload[1]) == WS_CLOSE_TOO_LARGE));
+    CHECK(!ws.is_connected());
+}
+
+int main() {
+    testSplitHeader();
+    testManyFrames();
+    testMaxSize();
+    testClientSplit();
+    testClientManyFrames();
+    testClientMaxSize();
+    return TEST_RESULT();
+}
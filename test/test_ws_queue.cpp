@@ -0,0 +1,188 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Drive the mbed Websocket outbound queue through a mock socket that
+ * accepts bytes slowly, for each queue policy.
+ */
+
+#include "Websocket.h"
+#include "ws_frames.h"
+#include "quiet_stdout.h"
+#include "test.h"
+
+const int MESSAGE_SIZE = 100;
+// Each queued message uses its length plus 3 bytes
+const int QUEUE_MESSAGES = WEBSOCKET_TX_QUEUE_SIZE / (MESSAGE_SIZE + 3);
+
+static std::string message(int id) {
+    char s[16];
+    snprintf(s, sizeof(s), "%04d", id);
+    return std::string(s) + std::string(MESSAGE_SIZE - 4, (char) ('a' + id % 26));
+}
+
+static MockNet & connect(Websocket & ws) {
+    MockNet & net = mock_net();
+    net.reset();
+    {
+        QuietStdout quiet;
+        CHECK(ws.connect());
+    }
+    net.writes.clear();
+    return net;
+}
+
+/** Flush until the socket has accepted count frames. */
+static std::vector<WsFrame> drain(Websocket & ws, size_t count) {
+    MockNet & net = mock_net();
+    std::vector<WsFrame> frames;
+    for (int i = 0; i < 100000; ++i) {
+        CHECK(ws.flush() >= 0);
+        frames = ws_decode(net.sent);
+        if (frames.size() >= count) {
+            break;
+        }
+    }
+    CHECK_EQ(frames.size(), count);
+    CHECK_EQ(ws.queueDepth(), 0);
+    return frames;
+}
+
+static void checkIds(const std::vector<WsFrame> & frames, int first) {
+    for (size_t i = 0; i < frames.size(); ++i) {
+        CHECK_EQ(frames[i].opcode, WS_OPCODE_TEXT);
+        CHECK(frames[i].text() == message(first + (int) i));
+    }
+}
+
+/** A stalled socket keeps the newest messages. */
+static void testDropOldest() {
+    Websocket ws((char *) "ws://example.com/ws");
+    MockNet & net = connect(ws);
+    ws.setQueuePolicy(Websocket::QUEUE_DROP_OLDEST);
+    net.budget = 0;
+    int n = QUEUE_MESSAGES + 11;
+    for (int i = 0; i < n; ++i) {
+        CHECK(ws.queue(message(i).data(), MESSAGE_SIZE));
+    }
+    CHECK_EQ(ws.queueDepth(), QUEUE_MESSAGES);
+    CHECK_EQ(ws.droppedCount(), 11);
+    net.budget = -1;
+    checkIds(drain(ws, QUEUE_MESSAGES), 11);
+}
+
+/** A stalled socket keeps the oldest messages. */
+static void testDropNewest() {
+    Websocket ws((char *) "ws://example.com/ws");
+    MockNet & net = connect(ws);
+    ws.setQueuePolicy(Websocket::QUEUE_DROP_NEWEST);
+    net.budget = 0;
+    int n = QUEUE_MESSAGES + 11;
+    for (int i = 0; i < n; ++i) {
+        CHECK_EQ(ws.queue(message(i).data(), MESSAGE_SIZE), i < QUEUE_MESSAGES);
+    }
+    CHECK_EQ(ws.queueDepth(), QUEUE_MESSAGES);
+    CHECK_EQ(ws.droppedCount(), 11);
+    net.budget = -1;
+    checkIds(drain(ws, QUEUE_MESSAGES), 0);
+}
+
+/** A slow socket makes queue() wait without dropping. */
+static void testBlock() {
+    Websocket ws((char *) "ws://example.com/ws");
+    MockNet & net = connect(ws);
+    ws.setQueuePolicy(Websocket::QUEUE_BLOCK, 1000);
+    net.budget = 50;
+    int n = 3 * QUEUE_MESSAGES;
+    uint64_t start = host_clock_us();
+    for (int i = 0; i < n; ++i) {
+        CHECK(ws.queue(message(i).data(), MESSAGE_SIZE));
+    }
+    CHECK_EQ(ws.droppedCount(), 0);
+    CHECK(host_clock_us() > start);  // queue() waited for the socket
+    checkIds(drain(ws, n), 0);
+    for (size_t i = 0; i < net.writes.size(); ++i) {
+        CHECK(net.writes[i].size() <= 50);
+    }
+}
+
+/** A stalled socket makes queue() drop the new message after the timeout. */
+static void testBlockTimeout() {
+    Websocket ws((char *) "ws://example.com/ws");
+    MockNet & net = connect(ws);
+    ws.setQueuePolicy(Websocket::QUEUE_BLOCK, 250);
+    net.budget = 0;
+    int n = QUEUE_MESSAGES + 20;
+    int accepted = 0;
+    for (int i = 0; i < n; ++i) {
+        uint64_t start = host_clock_us();
+        bool ok = ws.queue(message(i).data(), MESSAGE_SIZE);
+        uint64_t waited = host_clock_us() - start;
+        if (ok) {
+            CHECK_EQ(accepted, i);  // nothing is accepted after a drop
+            CHECK(waited < 250000);
+            ++accepted;
+        } else {
+            CHECK(waited >= 250000);
+        }
+    }
+    CHECK(accepted < n);
+    CHECK_EQ(ws.droppedCount(), n - accepted);
+    net.budget = -1;
+    checkIds(drain(ws, accepted), 0);
+}
+
+/** Small messages coalesce into one write. */
+static void testCoalesce() {
+    Websocket ws((char *) "ws://example.com/ws");
+    MockNet & net = connect(ws);
+    for (int i = 0; i < 10; ++i) {
+        CHECK(ws.queue(message(i).data(), 8, (i & 1) ? WS_OPCODE_BINARY : WS_OPCODE_TEXT));
+    }
+    CHECK_EQ(ws.flush(), 0);
+    CHECK_EQ(net.writes.size(), 1);
+    std::vector<WsFrame> frames = ws_decode(net.sent);
+    CHECK_EQ(frames.size(), 10);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        CHECK_EQ(frames[i].opcode, (i & 1) ? WS_OPCODE_BINARY : WS_OPCODE_TEXT);
+        CHECK(frames[i].text() == message((int) i).substr(0, 8));
+    }
+
+    // A full queue needs a write per transmit buffer
+    net.writes.clear();
+    net.sent.clear();
+    for (int i = 0; i < QUEUE_MESSAGES; ++i) {
+        CHECK(ws.queue(message(i).data(), MESSAGE_SIZE));
+    }
+    checkIds(drain(ws, QUEUE_MESSAGES), 0);
+    int perWrite = WEBSOCKET_TX_BUFFER_SIZE / (MESSAGE_SIZE + 8);
+    CHECK_EQ(net.writes.size(), (QUEUE_MESSAGES + perWrite - 1) / perWrite);
+}
+
+/** Frames survive a socket that accepts a few bytes per write. */
+static void testSlowSocket() {
+    Websocket ws((char *) "ws://example.com/ws");
+    MockNet & net = connect(ws);
+    net.budget = 7;
+    int n = 0;
+    for (int round = 0; round < 100; ++round) {
+        CHECK(ws.queue(message(n).data(), MESSAGE_SIZE));
+        ++n;
+        for (int i = 0; i < 20; ++i) {
+            ws.flush();
+        }
+    }
+    CHECK_EQ(ws.droppedCount(), 0);
+    checkIds(drain(ws, n), 0);
+    CHECK(ws.is_connected());
+}
+
+int main() {
+    testDropOldest();
+    testDropNewest();
+    testBlock();
+    testBlockTimeout();
+    testCoalesce();
+    testSlowSocket();
+    return TEST_RESULT();
+}
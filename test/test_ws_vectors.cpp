@@ -0,0 +1,237 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Run the same server test vectors against the mbed and Energia
+ * WebSocket clients.
+ *
+ * Each vector lists the frames sent by the server, the messages that the
+ * client must deliver, the frames that the client must send in reply and
+ * whether the connection stays open.  Every vector is delivered whole,
+ * in small chunks and together with the upgrade response.
+ */
+
+#include "ws_client.h"
+#include "ws_frames.h"
+#include "ws_parser.h"
+#include "mock_net.h"
+#include "test.h"
+#include <stdio.h>
+
+struct Vector {
+    std::string name;
+    Bytes server;
+    std::vector<WsMessage> messages;
+    std::vector<WsFrame> replies;
+    bool open;
+};
+
+static WsMessage message(uint8_t opcode, const std::string & data) {
+    WsMessage m;
+    m.opcode = opcode;
+    m.data = data;
+    return m;
+}
+
+static WsFrame reply(uint8_t opcode, const std::string & payload) {
+    WsFrame f = WsFrame();
+    f.opcode = opcode;
+    f.fin = true;
+    f.masked = true;
+    f.payload = bytes(payload);
+    return f;
+}
+
+static std::string status(uint16_t code) {
+    return std::string(1, (char) (code >> 8)) + std::string(1, (char) (code & 0xff));
+}
+
+static std::string pattern(size_t n) {
+    std::string s(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        s[i] = (char) ('a' + (i * 7) % 26);
+    }
+    return s;
+}
+
+static Vector vector(const std::string & name, const Bytes & server, bool open = true) {
+    Vector v;
+    v.name = name;
+    v.server = server;
+    v.open = open;
+    return v;
+}
+
+static Vector protocolError(const std::string & name, const Bytes & server,
+                            uint16_t code = WS_CLOSE_PROTOCOL_ERROR) {
+    Vector v = vector(name, server, false);
+    v.replies.push_back(reply(WS_OPCODE_CLOSE, status(code)));
+    return v;
+}
+
+static std::vector<Vector> vectors(uint32_t max) {
+    std::vector<Vector> vs;
+    Vector v;
+
+    v = vector("text", ws_frame(WS_OPCODE_TEXT, "hello"));
+    v.messages.push_back(message(WS_OPCODE_TEXT, "hello"));
+    vs.push_back(v);
+
+    std::string binary;
+    for (int i = 0; i < 200; ++i) {
+        binary += (char) i;
+    }
+    v = vector("binary", ws_frame(WS_OPCODE_BINARY, bytes(binary)));
+    v.messages.push_back(message(WS_OPCODE_BINARY, binary));
+    vs.push_back(v);
+
+    v = vector("empty", ws_frame(WS_OPCODE_TEXT, ""));
+    v.messages.push_back(message(WS_OPCODE_TEXT, ""));
+    vs.push_back(v);
+
+    v = vector("several", ws_frame(WS_OPCODE_TEXT, "one") + ws_frame(WS_OPCODE_TEXT, "two") +
+               ws_frame(WS_OPCODE_BINARY, "three"));
+    v.messages.push_back(message(WS_OPCODE_TEXT, "one"));
+    v.messages.push_back(message(WS_OPCODE_TEXT, "two"));
+    v.messages.push_back(message(WS_OPCODE_BINARY, "three"));
+    vs.push_back(v);
+
+    v = vector("fragmented", ws_frame(WS_OPCODE_TEXT, "Hello", false) +
+               ws_frame(WS_OPCODE_CONTINUATION, ", ", false) +
+               ws_frame(WS_OPCODE_CONTINUATION, "world"));
+    v.messages.push_back(message(WS_OPCODE_TEXT, "Hello, world"));
+    vs.push_back(v);
+
+    v = vector("fragmented with ping", ws_frame(WS_OPCODE_BINARY, "ab", false) +
+               ws_frame(WS_OPCODE_PING, "x") +
+               ws_frame(WS_OPCODE_CONTINUATION, "cd"));
+    v.messages.push_back(message(WS_OPCODE_BINARY, "abcd"));
+    v.replies.push_back(reply(WS_OPCODE_PONG, "x"));
+    vs.push_back(v);
+
+    v = vector("ping", ws_frame(WS_OPCODE_PING, "abc"));
+    v.replies.push_back(reply(WS_OPCODE_PONG, "abc"));
+    vs.push_back(v);
+
+    v = vector("empty ping", ws_frame(WS_OPCODE_PING, ""));
+    v.replies.push_back(reply(WS_OPCODE_PONG, ""));
+    vs.push_back(v);
+
+    v = vector("ping 125", ws_frame(WS_OPCODE_PING, pattern(125)));
+    v.replies.push_back(reply(WS_OPCODE_PONG, pattern(125)));
+    vs.push_back(v);
+
+    v = vector("pong", ws_frame(WS_OPCODE_PONG, "unsolicited") + ws_frame(WS_OPCODE_TEXT, "after"));
+    v.messages.push_back(message(WS_OPCODE_TEXT, "after"));
+    vs.push_back(v);
+
+    v = vector("close", ws_frame(WS_OPCODE_CLOSE, status(1000) + "bye"), false);
+    v.replies.push_back(reply(WS_OPCODE_CLOSE, status(1000)));
+    vs.push_back(v);
+
+    v = vector("empty close", ws_frame(WS_OPCODE_CLOSE, ""), false);
+    v.replies.push_back(reply(WS_OPCODE_CLOSE, ""));
+    vs.push_back(v);
+
+    v = vector("data after close", ws_frame(WS_OPCODE_CLOSE, status(1001)) +
+               ws_frame(WS_OPCODE_TEXT, "ignored"), false);
+    v.replies.push_back(reply(WS_OPCODE_CLOSE, status(1001)));
+    vs.push_back(v);
+
+    vs.push_back(protocolError("reserved bits",
+                               ws_frame(WS_OPCODE_TEXT, bytes("x"), true, 0, 4)));
+    vs.push_back(protocolError("reserved data opcode", ws_frame(0x3, "x")));
+    vs.push_back(protocolError("reserved control opcode", ws_frame(0xB, "x")));
+    vs.push_back(protocolError("continuation without start",
+                               ws_frame(WS_OPCODE_CONTINUATION, "x")));
+    vs.push_back(protocolError("interrupted fragments",
+                               ws_frame(WS_OPCODE_TEXT, "a", false) +
+                               ws_frame(WS_OPCODE_TEXT, "b")));
+    vs.push_back(protocolError("fragmented ping", ws_frame(WS_OPCODE_PING, "x", false)));
+    vs.push_back(protocolError("ping 126", ws_frame(WS_OPCODE_PING, pattern(126))));
+
+    v = vector("maximum", ws_frame(WS_OPCODE_TEXT, pattern(max)));
+    v.messages.push_back(message(WS_OPCODE_TEXT, pattern(max)));
+    vs.push_back(v);
+
+    v = vector("maximum fragmented", ws_frame(WS_OPCODE_TEXT, pattern(max - 1), false) +
+               ws_frame(WS_OPCODE_CONTINUATION, "z"));
+    v.messages.push_back(message(WS_OPCODE_TEXT, pattern(max - 1) + "z"));
+    vs.push_back(v);
+
+    vs.push_back(protocolError("too large", ws_frame(WS_OPCODE_TEXT, pattern(max + 1)),
+                               WS_CLOSE_TOO_LARGE));
+    vs.push_back(protocolError("too large fragmented",
+                               ws_frame(WS_OPCODE_TEXT, pattern(max), false) +
+                               ws_frame(WS_OPCODE_CONTINUATION, "z"),
+                               WS_CLOSE_TOO_LARGE));
+    return vs;
+}
+
+/** The server bytes that arrive with the upgrade response. */
+static Bytes with_response;
+
+static void respondWithFrames(MockNet & net, const std::string & key) {
+    net.rx.push_front(bytes(MockNet::response(key)) + with_response);
+}
+
+static bool sameFrame(const WsFrame & a, const WsFrame & b) {
+    return (a.opcode == b.opcode) && (a.fin == b.fin) && (a.masked == b.masked) &&
+            (a.payload == b.payload);
+}
+
+/** Run a vector, delivering the server bytes in chunks of size bytes, or
+ * with the upgrade response when size is 0.
+ */
+static bool run(WsTestClient * (*factory)(), const Vector & v, size_t size) {
+    MockNet & net = mock_net();
+    net.reset();
+    if (size == 0) {
+        with_response = v.server;
+        net.onRequest = respondWithFrames;
+    }
+    WsTestClient * client = factory();
+    bool ok = client->connect();
+    if (size) {
+        net.pushSplit(v.server, size);
+    }
+    std::vector<WsMessage> messages;
+    client->receive(messages);
+
+    ok = ok && (messages.size() == v.messages.size());
+    for (size_t i = 0; ok && (i < messages.size()); ++i) {
+        ok = (messages[i].opcode == v.messages[i].opcode) &&
+                (messages[i].data == v.messages[i].data);
+    }
+    size_t rest;
+    std::vector<WsFrame> replies = ws_decode(net.sent, &rest);
+    ok = ok && (rest == 0) && (replies.size() == v.replies.size());
+    for (size_t i = 0; ok && (i < replies.size()); ++i) {
+        ok = sameFrame(replies[i], v.replies[i]);
+    }
+    ok = ok && (client->connected() == v.open);
+    delete client;
+    return ok;
+}
+
+int main() {
+    WsTestClient * (*factories[])() = {ws_client_mbed, ws_client_energia};
+    static const size_t sizes[] = {0, 1, 2, 3, 7, 64, 1 << 20};
+    for (int c = 0; c < 2; ++c) {
+        WsTestClient * client = factories[c]();
+        std::vector<Vector> vs = vectors(client->maxMessage());
+        for (size_t i = 0; i < vs.size(); ++i) {
+            for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+                bool ok = run(factories[c], vs[i], sizes[s]);
+                CHECK(ok);
+                if (!ok) {
+                    printf("%s: vector \"%s\" failed with chunk size %d\n",
+                           client->name(), vs[i].name.c_str(), (int) sizes[s]);
+                }
+            }
+        }
+        printf("%s: %d vectors\n", client->name(), (int) vs.size());
+        delete client;
+    }
+    return TEST_RESULT();
+}
@@ -0,0 +1,116 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** Count the socket writes and the bytes per write made by the mbed and
+ * Energia WebSocket clients.
+ *
+ * The upgrade request and each frame that fits the transmit buffer must
+ * go out with a single write.  Larger frames continue in buffer-sized
+ * writes.
+ */
+
+#include "ws_client.h"
+#include "ws_frames.h"
+#include "ws_parser.h"
+#include "mock_net.h"
+#include "test.h"
+#include <stdio.h>
+
+static std::string pattern(size_t n) {
+    std::string s(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        s[i] = (char) ('a' + (i * 5) % 26);
+    }
+    return s;
+}
+
+static int headerLength(size_t n) {
+    return ((n < 126) ? 2 : 4) + 4;
+}
+
+static void testUpgrade(WsTestClient * (*factory)()) {
+    MockNet & net = mock_net();
+    net.reset();
+    WsTestClient * client = factory();
+    CHECK(client->connect());
+    CHECK_EQ(net.writes.size(), 1);
+    if (net.writes.size() == 1) {
+        std::string request(net.writes[0].begin(), net.writes[0].end());
+        CHECK_EQ(request.find("GET /ws HTTP/1.1\r\n"), 0);
+        CHECK_EQ(request.find("\r\n\r\n"), request.size() - 4);
+    }
+    delete client;
+}
+
+static void testSend(WsTestClient * (*factory)()) {
+    MockNet & net = mock_net();
+    net.reset();
+    WsTestClient * client = factory();
+    CHECK(client->connect());
+    int maxWrite = (int) client->maxWrite();
+    int maxPayload = maxWrite - headerLength(maxWrite);
+    std::vector<size_t> sizes;
+    static const size_t fixed[] = {0, 1, 125, 126, 127, 200, 1000, 4000};
+    sizes.assign(fixed, fixed + sizeof(fixed) / sizeof(fixed[0]));
+    sizes.push_back(maxPayload);
+    sizes.push_back(maxPayload + 1);
+    for (size_t k = 0; k < sizes.size(); ++k) {
+        for (int binary = 0; binary < 2; ++binary) {
+            uint8_t opcode = binary ? WS_OPCODE_BINARY : WS_OPCODE_TEXT;
+            std::string data = pattern(sizes[k]);
+            net.writes.clear();
+            net.sent.clear();
+            CHECK(client->send(opcode, data));
+            int total = headerLength(sizes[k]) + (int) sizes[k];
+            int expect = (total + maxWrite - 1) / maxWrite;
+            CHECK_EQ(net.writes.size(), expect);
+            for (size_t i = 0; i < net.writes.size(); ++i) {
+                int n = (int) net.writes[i].size();
+                CHECK(n <= maxWrite);
+                if (i + 1 < net.writes.size()) {
+                    CHECK_EQ(n, maxWrite);  // only the last write is partial
+                }
+            }
+            size_t rest;
+            std::vector<WsFrame> frames = ws_decode(net.sent, &rest);
+            CHECK_EQ(rest, 0);
+            CHECK_EQ(frames.size(), 1);
+            if (frames.size() == 1) {
+                CHECK_EQ(frames[0].opcode, opcode);
+                CHECK_EQ(frames[0].headerLength, headerLength(sizes[k]));
+                CHECK(frames[0].text() == data);
+            }
+        }
+    }
+    printf("%s: frames up to %d payload bytes take one write\n",
+           client->name(), maxPayload);
+    delete client;
+}
+
+static void testPong(WsTestClient * (*factory)()) {
+    MockNet & net = mock_net();
+    net.reset();
+    WsTestClient * client = factory();
+    CHECK(client->connect());
+    net.writes.clear();
+    net.push(ws_frame(WS_OPCODE_PING, pattern(125)) + ws_frame(WS_OPCODE_PING, "x"));
+    std::vector<WsMessage> messages;
+    client->receive(messages);
+    CHECK_EQ(net.writes.size(), 2);
+    if (net.writes.size() == 2) {
+        CHECK_EQ(net.writes[0].size(), 6 + 125);
+        CHECK_EQ(net.writes[1].size(), 6 + 1);
+    }
+    delete client;
+}
+
+int main() {
+    WsTestClient * (*factories[])() = {ws_client_mbed, ws_client_energia};
+    for (int c = 0; c < 2; ++c) {
+        testUpgrade(factories[c]);
+        testSend(factories[c]);
+        testPong(factories[c]);
+    }
+    return TEST_RESULT();
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** A common interface to the mbed and Energia WebSocket clients so that
+ * the same test vectors run against both.
+ *
+ * Each client is compiled in its own source file, ws_client_mbed.cpp or
+ * ws_client_energia.cpp, since the two define the same configuration
+ * macros with different values.  Both use the mock network in
+ * stubs/mock_net.h.
+ */
+
+#ifndef WS_CLIENT_H
+#define WS_CLIENT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct WsMessage {
+    uint8_t opcode;
+    std::string data;
+};
+
+class WsTestClient {
+public:
+    virtual ~WsTestClient() {}
+
+    virtual const char * name() const = 0;
+
+    /** The largest message the client receives. */
+    virtual uint32_t maxMessage() const = 0;
+
+    /** The largest message the client sends with a single write. */
+    virtual uint32_t maxWrite() const = 0;
+
+    virtual bool connect() = 0;
+
+    /** Process the received data until the mock network has no more.
+     *
+     * @param messages The complete messages are appended here.
+     */
+    virtual void receive(std::vector<WsMessage> & messages) = 0;
+
+    virtual bool connected() = 0;
+
+    virtual bool send(uint8_t opcode, const std::string & data) = 0;
+};
+
+WsTestClient * ws_client_mbed();
+WsTestClient * ws_client_energia();
+
+#endif /* WS_CLIENT_H */
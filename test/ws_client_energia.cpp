@@ -0,0 +1,63 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "ws_client.h"
+#include "WebClient.h"
+
+static std::vector<WsMessage> * energia_messages;
+
+static void energia_on_message(char * msg, uint16_t length, uint8_t opcode) {
+    WsMessage m;
+    m.opcode = opcode;
+    m.data.assign(msg, length);
+    if (energia_messages) {
+        energia_messages->push_back(m);
+    }
+}
+
+class EnergiaClient : public WsTestClient {
+public:
+    EnergiaClient() : ws_((char *) "example.com", 8000, (char *) "/ws", false,
+                          NULL, energia_on_message) {}
+
+    const char * name() const { return "energia"; }
+    uint32_t maxMessage() const { return WEBSOCKET_MAX_MESSAGE_SIZE; }
+    uint32_t maxWrite() const { return WEBSOCKET_TX_BUFFER_SIZE; }
+
+    bool connect() {
+        return ws_.connect();
+    }
+
+    void receive(std::vector<WsMessage> & messages) {
+        MockNet & net = mock_net();
+        energia_messages = &messages;
+        // Stop once closed, since run() would otherwise reconnect
+        for (int i = 0; i < 1000000; ++i) {
+            if (!net.connected || (net.rx.empty() && net.arrived.empty())) {
+                break;
+            }
+            ws_.run();
+        }
+        energia_messages = NULL;
+    }
+
+    bool connected() {
+        return mock_net().connected;
+    }
+
+    bool send(uint8_t opcode, const std::string & data) {
+        if (opcode == WS_OPCODE_TEXT) {
+            std::string s = data;
+            return ws_.sendMessage(&s[0], (uint16_t) s.size());
+        }
+        return ws_.sendBinary(data.data(), (uint16_t) data.size());
+    }
+
+private:
+    WebsocketClient ws_;
+};
+
+WsTestClient * ws_client_energia() {
+    return new EnergiaClient();
+}
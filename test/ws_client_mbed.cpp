@@ -0,0 +1,59 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+#include "ws_client.h"
+#include "Websocket.h"
+#include "quiet_stdout.h"
+
+class MbedClient : public WsTestClient {
+public:
+    MbedClient() : ws_((char *) "ws://example.com:8000/ws") {}
+
+    const char * name() const { return "mbed"; }
+    uint32_t maxMessage() const { return WEBSOCKET_MAX_MESSAGE_SIZE; }
+    uint32_t maxWrite() const { return WEBSOCKET_TX_BUFFER_SIZE; }
+
+    bool connect() {
+        QuietStdout quiet;
+        return ws_.connect();
+    }
+
+    void receive(std::vector<WsMessage> & messages) {
+        MockNet & net = mock_net();
+        // read() returns one message per call, so read until it returns
+        // nothing twice with no more data pending
+        int idle = 0;
+        for (int i = 0; i < 1000000; ++i) {
+            char * p;
+            int n;
+            WsMessage msg;
+            if (ws_.read(&p, &n, &msg.opcode)) {
+                msg.data.assign(p, n);
+                messages.push_back(msg);
+                idle = 0;
+            } else if (net.rx.empty() && net.arrived.empty() && (++idle >= 2)) {
+                return;
+            }
+        }
+    }
+
+    bool connected() {
+        return ws_.is_connected();
+    }
+
+    bool send(uint8_t opcode, const std::string & data) {
+        if (opcode == WS_OPCODE_TEXT) {
+            std::string s = data;
+            return ws_.send(&s[0]) > 0;
+        }
+        return ws_.sendBinary(data.data(), (int) data.size()) > 0;
+    }
+
+private:
+    Websocket ws_;
+};
+
+WsTestClient * ws_client_mbed() {
+    return new MbedClient();
+}
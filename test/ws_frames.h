@@ -0,0 +1,126 @@
+// Copyright (c) 2015 Jetperch LLC
+// This file is licensed under the MIT License
+// http://opensource.org/licenses/MIT
+
+/** WebSocket frame helpers for the host tests.
+ *
+ * The encoder and decoder are written directly from RFC 6455 section 5.2
+ * and do not share code with the device parser.
+ */
+
+#ifndef WS_FRAMES_H
+#define WS_FRAMES_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+static inline Bytes bytes(const std::string & s) {
+    return Bytes(s.begin(), s.end());
+}
+
+/** Encode a frame.  Server frames are unmasked, client frames use mask. */
+static inline Bytes ws_frame(uint8_t opcode, const Bytes & payload, bool fin = true,
+                             const uint8_t * mask = 0, uint8_t rsv = 0) {
+    Bytes f;
+    uint64_t n = payload.size();
+    f.push_back((uint8_t) ((fin ? 0x80 : 0) | (rsv << 4) | opcode));
+    uint8_t m = mask ? 0x80 : 0;
+    if (n < 126) {
+        f.push_back((uint8_t) (m | n));
+    } else if (n <= 0xffff) {
+        f.push_back(m | 126);
+        f.push_back((uint8_t) (n >> 8));
+        f.push_back((uint8_t) n);
+    } else {
+        f.push_back(m | 127);
+        for (int i = 7; i >= 0; --i) {
+            f.push_back((uint8_t) (n >> (i * 8)));
+        }
+    }
+    if (mask) {
+        f.insert(f.end(), mask, mask + 4);
+    }
+    for (size_t i = 0; i < payload.size(); ++i) {
+        f.push_back(payload[i] ^ (mask ? mask[i & 3] : 0));
+    }
+    return f;
+}
+
+static inline Bytes ws_frame(uint8_t opcode, const std::string & payload, bool fin = true) {
+    return ws_frame(opcode, bytes(payload), fin);
+}
+
+static inline Bytes operator+(Bytes a, const Bytes & b) {
+    a.insert(a.end(), b.begin(), b.end());
+    return a;
+}
+
+/** A decoded frame. */
+struct WsFrame {
+    uint8_t opcode;
+    bool fin;
+    bool masked;
+    int headerLength;   // bytes before the payload, including the mask
+    Bytes payload;      // unmasked
+
+    std::string text() const {
+        return std::string(payload.begin(), payload.end());
+    }
+};
+
+/** Decode the complete frames in data.
+ *
+ * @param data The bytes to decode.
+ * @param rest If not NULL, set to the number of trailing bytes that do
+ *      not form a complete frame.
+ */
+static inline std::vector<WsFrame> ws_decode(const Bytes & data, size_t * rest = 0) {
+    std::vector<WsFrame> frames;
+    size_t pos = 0;
+    while (pos + 2 <= data.size()) {
+        WsFrame f;
+        size_t p = pos;
+        f.fin = (data[p] & 0x80) != 0;
+        f.opcode = data[p] & 0x0f;
+        f.masked = (data[p + 1] & 0x80) != 0;
+        uint64_t n = data[p + 1] & 0x7f;
+        p += 2;
+        int extra = (n == 126) ? 2 : ((n == 127) ? 8 : 0);
+        if (p + extra > data.size()) {
+            break;
+        }
+        if (extra) {
+            n = 0;
+            for (int i = 0; i < extra; ++i) {
+                n = (n << 8) | data[p++];
+            }
+        }
+        uint8_t mask[4] = {0, 0, 0, 0};
+        if (f.masked) {
+            if (p + 4 > data.size()) {
+                break;
+            }
+            for (int i = 0; i < 4; ++i) {
+                mask[i] = data[p++];
+            }
+        }
+        if (p + n > data.size()) {
+            break;
+        }
+        f.headerLength = (int) (p - pos);
+        for (uint64_t i = 0; i < n; ++i) {
+            f.payload.push_back(data[p + i] ^ mask[i & 3]);
+        }
+        frames.push_back(f);
+        pos = p + n;
+    }
+    if (rest) {
+        *rest = data.size() - pos;
+    }
+    return frames;
+}
+
+#endif /* WS_FRAMES_H */